@@ -4,10 +4,12 @@
 #include <functional>
 #include "BaseWindow.hpp"
 #include "WindowUtilities/PixelTextureHelper.hpp"
+#include "WindowUtilities/JoypadInputHelper.hpp"
 
 class ScreenWindow : public BaseWindow {
 public:
-    ScreenWindow(std::span<const uint32_t> screenView);
+    // The keys pressed while the screen has focus are reported as the buttons of a joypad
+    ScreenWindow(std::span<const uint32_t> screenView, JoypadInputHelper::ButtonsFunction onJoypadChange);
 
     void renderWindow() override;
 private:
@@ -17,4 +19,5 @@ private:
 
     std::span<const uint32_t> _screenView;
     PixelTextureHelper _pixelTextureHelper;
+    JoypadInputHelper _joypadInputHelper;
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RecompiledProgram.hpp"
+#include "HardwareEmulation/CpuVariant.hpp"
+
+// Runs code the static recompiler generated ahead of time for a fixed rom
+// Like the jit, recompiled code only touches the bus on the first instruction of a run so the cpu can run ahead of the ppu
+template <typename BusType, CpuVariant Variant>
+class CpuAot
+{
+public:
+    struct Statistics
+    {
+        uint64_t runs;
+        uint64_t instructions; // instructions that ran in recompiled code
+        uint64_t misses; // runs that found no recompiled block at the pc and fell back to the interpreter
+    };
+
+    CpuAot(Cpu<BusType, Variant>& cpu);
+
+    // Returns false when the program wasn't generated from the rom on the bus or the rom is patched, nullptr unloads the current program
+    bool setProgram(const RecompiledProgram* program);
+    bool isLoaded() const;
+
+    // Runs recompiled code from the current pc and returns how many instructions ran
+    // Returns 0 when there is no recompiled block at the pc, the caller should interpret the next instruction
+    uint32_t run(uint32_t maxInstructions);
+
+    Statistics getStatistics() const;
+
+private:
+    void loadContext(RecompiledContext& context);
+    void storeContext(const RecompiledContext& context);
+
+    Cpu<BusType, Variant>& _cpu;
+    const RecompiledProgram* _program;
+    // Indexed by the pc of the first instruction of the block
+    std::vector<RecompiledFunction> _functions;
+    Statistics _statistics;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+
+#include "RecompiledProgram.hpp"
+#include "HardwareEmulation/Bus.hpp"
+
+// The helpers the code generated by the static recompiler is built from
+// Everything is inline so accesses with a constant address fold into a single load or store
+class RecompiledCode
+{
+public:
+    static constexpr uint16_t RAM_MEMORY_RANGE = 0x2000;
+    static constexpr uint16_t TRUE_RAM_MASK = 0x7ff;
+    static constexpr uint16_t PRG_ROM_START = 0x8000;
+    static constexpr uint16_t STACK_OFFSET = 0x100;
+
+    static constexpr uint8_t CARRY_FLAG_MASK = 0x01;
+    static constexpr uint8_t ZERO_FLAG_MASK = 0x02;
+    static constexpr uint8_t INTERRUPT_DISABLE_FLAG_MASK = 0x04;
+    static constexpr uint8_t DECIMAL_MODE_FLAG_MASK = 0x08;
+    static constexpr uint8_t BREAK_COMMAND_FLAG_MASK = 0x10;
+    static constexpr uint8_t RESERVED_FLAG_MASK = 0x20;
+    static constexpr uint8_t OVERFLOW_FLAG_MASK = 0x40;
+    static constexpr uint8_t NEGATIVE_FLAG_MASK = 0x80;
+
+    // Ram and rom are accessed directly, anything else goes through the bus
+    // The bus is only in sync with the ppu for the first instruction of a run so later accesses return false and the run stops
+    static bool Read(RecompiledContext& context, uint16_t address, uint8_t& data);
+    static bool Write(RecompiledContext& context, uint16_t address, uint8_t data);
+
+    static uint8_t ReadRom(const RecompiledContext& context, uint16_t address);
+
+    static void Push(RecompiledContext& context, uint8_t data);
+    static uint8_t Pull(RecompiledContext& context);
+
+    static uint8_t GetStatus(const RecompiledContext& context);
+    static void SetStatus(RecompiledContext& context, uint8_t status);
+};
+
+inline bool RecompiledCode::Read(RecompiledContext& context, uint16_t address, uint8_t& data)
+{
+    if (address < RAM_MEMORY_RANGE)
+    {
+        data = context.ram[address & TRUE_RAM_MASK];
+        return true;
+    }
+    if (address >= PRG_ROM_START)
+    {
+        data = ReadRom(context, address);
+        return true;
+    }
+    if (context.instructions > 0)
+    {
+        return false;
+    }
+    data = context.bus->cpuRead(address);
+    return true;
+}
+
+inline bool RecompiledCode::Write(RecompiledContext& context, uint16_t address, uint8_t data)
+{
+    if (address < RAM_MEMORY_RANGE)
+    {
+        context.ram[address & TRUE_RAM_MASK] = data;
+        return true;
+    }
+    if (context.instructions > 0)
+    {
+        return false;
+    }
+    context.bus->cpuWrite(address, data);
+    return true;
+}
+
+inline uint8_t RecompiledCode::ReadRom(const RecompiledContext& context, uint16_t address)
+{
+    return context.prgBanks[(address >> 14) & 1][address & 0x3fff];
+}
+
+inline void RecompiledCode::Push(RecompiledContext& context, uint8_t data)
+{
+    context.ram[STACK_OFFSET + context.sp--] = data;
+}
+
+inline uint8_t RecompiledCode::Pull(RecompiledContext& context)
+{
+    return context.ram[STACK_OFFSET + ++context.sp];
+}
+
+inline uint8_t RecompiledCode::GetStatus(const RecompiledContext& context)
+{
+    uint8_t status = context.status & ~(CARRY_FLAG_MASK | ZERO_FLAG_MASK | OVERFLOW_FLAG_MASK | NEGATIVE_FLAG_MASK);
+    status |= context.carry;
+    status |= (context.zero == 0)? ZERO_FLAG_MASK : 0;
+    status |= (context.overflow & 0x80)? OVERFLOW_FLAG_MASK : 0;
+    status |= context.negative & NEGATIVE_FLAG_MASK;
+    return status;
+}
+
+inline void RecompiledCode::SetStatus(RecompiledContext& context, uint8_t status)
+{
+    context.status = status & ~(BREAK_COMMAND_FLAG_MASK | RESERVED_FLAG_MASK);
+    context.carry = status & CARRY_FLAG_MASK;
+    context.zero = !(status & ZERO_FLAG_MASK);
+    context.overflow = (status & OVERFLOW_FLAG_MASK) << 1;
+    context.negative = status & NEGATIVE_FLAG_MASK;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+class Bus;
+
+// The state the recompiled code works on, flags are kept the same way the lazy flags of the cpu are
+struct RecompiledContext
+{
+    Bus* bus;
+    uint8_t* ram;
+    std::array<const uint8_t*, 2> prgBanks; // the banks mapped at $8000 and $c000
+    uint64_t cycles;
+    uint32_t maxInstructions;
+    uint32_t instructions;
+    uint16_t pc;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t sp;
+    uint8_t status; // only the I and D bits are used
+    uint8_t carry; // 0 or 1
+    uint8_t zero; // the zero flag is set when this is 0
+    uint8_t overflow; // bit 7 is the overflow
+    uint8_t negative; // bit 7 is the negative
+};
+
+// Every recompiled block leaves the next pc in the context
+// Returns false when the run has to stop, either the instruction budget ran out or the next instruction needs the bus
+using RecompiledFunction = bool (*)(RecompiledContext& context);
+
+struct RecompiledBlock
+{
+    uint16_t pc;
+    RecompiledFunction function;
+};
+
+struct RecompiledProgram
+{
+    const char* name;
+    uint64_t prgChecksum; // the program only runs on the prg rom it was generated from
+    std::span<const RecompiledBlock> blocks;
+};
+
+// Generated programs register themselves when they are linked into a binary
+class RecompiledProgramRegistry
+{
+public:
+    static bool Register(const RecompiledProgram* program);
+
+    // Returns nullptr when no linked program was generated from this rom
+    static const RecompiledProgram* Find(uint64_t prgChecksum);
+
+    // FNV-1a over the cpu view of the prg rom ($8000-$ffff)
+    static uint64_t PrgChecksum(Bus& bus);
+};
@@ -1,8 +1,7 @@
 #pragma once
 
 #include <array>
-#include <list>
-#include <functional>
+#include <map>
 #include <memory>
 #include <stdint.h>
 #include <span>
@@ -10,20 +9,14 @@
 #include "Cpu.hpp"
 #include "Ppu.hpp"
 #include "Cartridge.hpp"
+#include "Cheats.hpp"
+#include "CodeDataLogger.hpp"
+#include "Controller.hpp"
+#include "MemoryHeatmap.hpp"
+#include "Watchpoints.hpp"
 
 class Bus {
 public:
-    using WriteFunction = std::function<void (uint16_t address, uint8_t data)>;
-    using ReadFunction = std::function<uint8_t (uint16_t address)>;
-    
-    struct phis_translation
-    {
-        uint32_t offset;
-        uint32_t size;
-        WriteFunction writeFunc;
-        ReadFunction readFunc;
-    };
-
     Bus();
 
     void insertCartridge(std::fstream file);
@@ -32,23 +25,314 @@ public:
 
     std::span<const uint8_t> getRamView() const;
 
-private:
-    friend class Nes;
-    static constexpr uint32_t TRUE_RAM_SIZE = 0x800;
-    static constexpr uint32_t RAM_MEMORY_RANGE = 0x2000;
+    // Advances the master clock by a single ppu cycle, the cpu runs on every third one
+    void clock();
+
+    // Runs the cpu for a batch of cycles and then the ppu for the same time, returns the ppu cycles that ran
+    // A batch ends right after the ppu can raise an nmi or change its status, the nmi is taken at the start of the next batch
+    // This is a scanline accurate model, register writes land at the start of the batch they happen in
+    uint32_t clockBatch();
+
+    // Runs the cpu until the ppu can raise an nmi or change its status and catches the ppu up to it at the end, returns the ppu cycles that ran
+    // In between the ppu only catches up when the cpu accesses its registers or starts the oam dma, so a frame is two batches
+    // and register accesses land on the cycle their instruction ends
+    uint32_t clockLazy();
 
+    Cpu<Bus>& getCpu();
+    Ppu<Bus>& getPpu();
+    // Port 0 is $4016 and port 1 is $4017
+    Controller& getController(uint32_t port);
+
+    #ifdef MEMORY_HEATMAP
+    // Every access of the cpu, cached and translated code access the memory directly so these builds run the cpu in the interpreter
+    // Recompiled code isn't counted
+    MemoryHeatmap& getCpuHeatmap();
+    #endif // MEMORY_HEATMAP
+
+    #ifdef CPU_TRACE
+    // Writes the last instructions the cpu ran and the current screen, tools/TraceFormatter reads it
+    bool writeTraceDump(const std::string& path);
+    #endif // CPU_TRACE
+
+    // Only the pages a watchpoint covers leave the page table, their accesses are checked on the way to the memory they map
+    // Cached and translated code reads the rom and ram directly so the cpu runs in the plain interpreter while any watchpoint is set
+    uint32_t addWatchpoint(const Watchpoint& watchpoint);
+    bool removeWatchpoint(uint32_t id);
+    void clearWatchpoints();
+    void setWatchpointHandler(Watchpoints::HitHandler handler);
+
+    // The rom pages leave the page table while the logger runs so their reads and fetches can be marked
+    // Like with watchpoints the cpu runs in the plain interpreter, the log is kept until another cartridge is inserted
+    // The dummy reads of the cycle exact core are real reads of the bus so they are logged as data
+    void setCodeDataLoggerEnabled(bool enabled);
+    CodeDataLogger& getCodeDataLogger();
+
+    // Rom patches map the pages they patch to patched copies of the banks, reads of the other pages don't change
+    bool addGameGenieCode(const std::string& code);
+    void addRomPatch(const RomPatch& patch);
+    bool hasRomPatches() const;
+    // The frozen bytes are written at the start of every vblank
+    bool addRamFreeze(const RamFreeze& freeze);
+    void clearCheats();
+
+    // These are the CpuBus and PpuBus interfaces, they are defined in the header so they inline into the cores
     void cpuWrite(uint16_t address, uint8_t data);
     uint8_t cpuRead(uint16_t address);
+    uint8_t cpuFetch(uint16_t address);
 
     bool ppuWrite(uint16_t address, uint8_t data);
     bool ppuRead(uint16_t address, uint8_t& data);
 
-    void ramWrite(uint16_t address, uint8_t data);
-    uint8_t ramRead(uint16_t address);
+    int32_t cpuCodeBank(uint16_t address);
+    bool cpuCodeBypassAllowed();
+
+    std::span<uint8_t> cpuRam();
+
+    const uint8_t* cpuRomPointer(uint16_t address);
+
+    InterruptController& interruptController();
+
+    void vblankStarted();
+
+    void chrRendered(uint16_t address);
+    void chrRead(uint16_t address);
+
+private:
+    friend class Nes;
+    // It copies the rom from the cartridge so the copy isn't counted, logged or watched as a cpu access
+    friend class CpuDisassembler<Bus, Ricoh2A03>;
+    static constexpr uint32_t TRUE_RAM_SIZE = 0x800;
+    static constexpr uint32_t RAM_MEMORY_RANGE = 0x2000;
+    // A scanline of cpu cycles
+    static constexpr uint32_t MAX_BATCH_CYCLES = 114;
+    static constexpr uint32_t PAGE_COUNT = 0x100;
+    static constexpr uint32_t CPU_ADDRESS_SPACE_SIZE = 0x10000;
+    static constexpr uint32_t PAGE_SHIFT = 8;
+    static constexpr uint32_t PAGE_MASK = 0xff;
+    static constexpr uint32_t PPU_REGISTERS_START = 0x2000;
+    static constexpr uint32_t CARTRIDGE_START = 0x4000;
+    static constexpr uint32_t IO_REGISTERS_PAGE = 0x40;
+    // The cartridge space starts after the io registers in the middle of their page
+    static constexpr uint32_t IO_REGISTERS_END = 0x4020;
+    static constexpr uint16_t OAM_DMA_ADDRESS = 0x4014;
+    static constexpr uint16_t JOYPAD1_ADDRESS = 0x4016;
+    static constexpr uint16_t JOYPAD2_ADDRESS = 0x4017;
+    // The halt cycle and 256 reads and writes, a dma that starts on an odd cycle waits one more cycle to align
+    static constexpr uint32_t OAM_DMA_CYCLES = 513;
+    static constexpr uint16_t PPU_PATTERN_TABLES_SIZE = 0x2000;
+
+    // The owner of the accesses to a page that has no pointer in the page table
+    enum class MmioHandler : uint8_t
+    {
+        OPEN_BUS,
+        PPU_REGISTERS,
+        CARTRIDGE,
+        IO_REGISTERS,
+        WATCHPOINT // the page is watched or logged, the handler it maps is in its mapping
+    };
+
+    struct PageMapping
+    {
+        const uint8_t* read;
+        uint8_t* write;
+        MmioHandler handler;
+    };
 
-    std::list<phis_translation> _memoryMapper;
+    // Points the cartridge pages at the prg banks the mapper has mapped, it is called again after every bank switch
+    void mapCartridgePages();
+    // Copies the mapping of a page into the page table, without the pointers of the accesses that are watched
+    void updatePage(uint32_t page);
+    void updateWatchedPages();
+    // Returns the rom page with the patches of the cpu page applied, the copy is kept until the patches change
+    const uint8_t* patchedPage(uint32_t page, const uint8_t* rom);
+    void updateRomPatches();
+
+    uint8_t mmioRead(uint16_t address);
+    void mmioWrite(uint16_t address, uint8_t data);
+    uint8_t deviceRead(uint16_t address, MmioHandler handler);
+    void deviceWrite(uint16_t address, uint8_t data, MmioHandler handler);
+    uint8_t watchedRead(uint16_t address, WatchAccess access);
+    void watchedWrite(uint16_t address, uint8_t data);
+    void logRomAccess(uint16_t address, uint8_t data, WatchAccess access);
+    void logChrAccess(uint16_t address, CdlChrFlags access);
+    uint8_t ioRead(uint16_t address);
+    void ioWrite(uint16_t address, uint8_t data);
+
+    // Runs the ppu up to the cycle the cpu is at, only while clockLazy runs the cpu ahead of it
+    void catchUpPpu();
+
+    // Records where the ppu is at the current cpu cycle count, it is called once per cpu slot, batch or catch up and not per instruction
+    void anchorTrace();
+
+    // Copies a cpu page to the oam and halts the cpu for the time the dma takes
+    void oamDma(uint8_t page);
+
+    // One entry per 256 byte page, ram and rom are accessed through the pointers and everything else through the page handler
+    // Opcode fetches have their own table so execute watchpoints don't slow down reads of the same page
+    std::array<const uint8_t*, PAGE_COUNT> _readPages;
+    std::array<const uint8_t*, PAGE_COUNT> _fetchPages;
+    std::array<uint8_t*, PAGE_COUNT> _writePages;
+    std::array<MmioHandler, PAGE_COUNT> _pageHandlers;
+    // The memory map the page table is built from
+    std::array<PageMapping, PAGE_COUNT> _mappedPages;
+    std::array<uint8_t, PAGE_COUNT> _watchedPages; // WatchAccess flags
+    // The prg rom offset of every page that maps rom and -1 for the rest
+    std::array<int32_t, PAGE_COUNT> _pageRomOffsets;
+    Watchpoints _watchpoints;
+    Cheats _cheats;
+    // A copy for every cpu page and rom page it was mapped from, so translated code that points into a copy stays valid after bank switches
+    std::map<std::pair<uint32_t, const uint8_t*>, std::array<uint8_t, Cheats::PAGE_SIZE>> _patchedPages;
+    CodeDataLogger _codeDataLogger = CodeDataLogger(0, 0);
+    bool _codeDataLogging;
+    // The last opcode fetch, the reads of its operand bytes are code and not data
+    uint16_t _loggedInstructionAddress;
+    uint8_t _loggedInstructionLength;
     std::array<uint8_t, 0x800> _ram;
     std::shared_ptr<Cartridge> _cartridge;
-    Cpu _cpu;
-    Ppu _ppu;
-};
\ No newline at end of file
+    std::array<Controller, 2> _controllers;
+    #ifdef MEMORY_HEATMAP
+    MemoryHeatmap _cpuHeatmap = MemoryHeatmap(CPU_ADDRESS_SPACE_SIZE);
+    #endif // MEMORY_HEATMAP
+    uint32_t _clockCounter;
+    // Instruction slots the cpu already ran ahead of time in translated code
+    uint32_t _cpuIdleSlots;
+    // Cycles the cpu was halted for during its last slot, the ppu still has to run them
+    uint32_t _cpuStallCycles;
+    // The cpu runs ahead of the ppu and the ppu is at the cpu cycle in _ppuSyncedCpuCycles
+    bool _ppuLagging;
+    size_t _ppuSyncedCpuCycles;
+    #ifdef CPU_TRACE
+    // The positions of the traced instructions are worked out from the last anchor at or before their cycle
+    // The ppu runs 3 dots per cycle after an anchor while the cpu runs a batch
+    struct TraceAnchor
+    {
+        size_t cycles;
+        uint32_t position;
+    };
+    std::array<TraceAnchor, CpuTrace::CAPACITY> _traceAnchors;
+    uint64_t _traceAnchorCount;
+    #endif // CPU_TRACE
+    Cpu<Bus> _cpu;
+    Ppu<Bus> _ppu;
+};
+
+inline void Bus::cpuWrite(uint16_t address, uint8_t data)
+{
+    #ifdef MEMORY_HEATMAP
+    _cpuHeatmap.countWrite(address);
+    #endif // MEMORY_HEATMAP
+    uint8_t* page = _writePages[address >> PAGE_SHIFT];
+    if (page != nullptr)
+    {
+        page[address & PAGE_MASK] = data;
+        return;
+    }
+    mmioWrite(address, data);
+}
+
+inline uint8_t Bus::cpuRead(uint16_t address)
+{
+    #ifdef MEMORY_HEATMAP
+    _cpuHeatmap.countRead(address);
+    #endif // MEMORY_HEATMAP
+    const uint8_t* page = _readPages[address >> PAGE_SHIFT];
+    if (page != nullptr)
+    {
+        return page[address & PAGE_MASK];
+    }
+    return mmioRead(address);
+}
+
+inline uint8_t Bus::cpuFetch(uint16_t address)
+{
+    #ifdef MEMORY_HEATMAP
+    _cpuHeatmap.countExecute(address);
+    #endif // MEMORY_HEATMAP
+    const uint8_t* page = _fetchPages[address >> PAGE_SHIFT];
+    if (page != nullptr)
+    {
+        return page[address & PAGE_MASK];
+    }
+    return watchedRead(address, WATCH_EXECUTE);
+}
+
+inline int32_t Bus::cpuCodeBank(uint16_t address)
+{
+    if (_cartridge.get() != nullptr)
+    {
+        return _cartridge->getPrgBankId(address);
+    }
+    return -1;
+}
+
+inline bool Bus::cpuCodeBypassAllowed()
+{
+    #ifdef MEMORY_HEATMAP
+    // Every access is counted so the cpu always goes through the bus
+    return false;
+    #else
+    return _watchpoints.empty() && !_codeDataLogging;
+    #endif // MEMORY_HEATMAP
+}
+
+inline std::span<uint8_t> Bus::cpuRam()
+{
+    return std::span<uint8_t>(_ram);
+}
+
+inline const uint8_t* Bus::cpuRomPointer(uint16_t address)
+{
+    // The mapping and not the cartridge so the patched pages are the rom translated code sees
+    const uint8_t* page = _mappedPages[address >> PAGE_SHIFT].read;
+    if (address >= CARTRIDGE_START && page != nullptr)
+    {
+        return page + (address & PAGE_MASK);
+    }
+    return nullptr;
+}
+
+inline InterruptController& Bus::interruptController()
+{
+    return _cpu.getInterruptController();
+}
+
+inline void Bus::anchorTrace()
+{
+    #ifdef CPU_TRACE
+    _traceAnchors[_traceAnchorCount++ & (CpuTrace::CAPACITY - 1)] = {_cpu.getCycles(), _ppu.getPosition()};
+    #endif // CPU_TRACE
+}
+
+inline void Bus::chrRendered(uint16_t address)
+{
+    if (_codeDataLogging)
+    {
+        logChrAccess(address, CDL_CHR_RENDERED);
+    }
+}
+
+inline void Bus::chrRead(uint16_t address)
+{
+    if (_codeDataLogging)
+    {
+        logChrAccess(address, CDL_CHR_READ);
+    }
+}
+
+inline bool Bus::ppuWrite(uint16_t address, uint8_t data)
+{
+    if (_cartridge.get() != nullptr && _cartridge->ppuWrite(address, data))
+    {
+        return true;
+    }
+    return false;
+}
+
+inline bool Bus::ppuRead(uint16_t address, uint8_t& data)
+{
+    if (_cartridge.get() != nullptr && _cartridge->ppuRead(address, data))
+    {
+        return true;
+    }
+    return false;
+}
\ No newline at end of file
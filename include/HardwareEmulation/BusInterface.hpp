@@ -0,0 +1,131 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+#include "InterruptController.hpp"
+
+// The cpu and ppu are templated on the bus they are connected to so memory accesses can be inlined into the cores
+// The concepts below describe what each core needs from its bus
+
+template <typename T>
+concept CpuBus = requires(T& bus, uint16_t address, uint8_t data)
+{
+    { bus.cpuRead(address) } -> std::same_as<uint8_t>;
+    bus.cpuWrite(address, data);
+};
+
+// A bus that tells opcode fetches apart from other reads, on other buses the cpu fetches with cpuRead
+template <typename T>
+concept FetchBus = requires(T& bus, uint16_t address)
+{
+    { bus.cpuFetch(address) } -> std::same_as<uint8_t>;
+};
+
+// The ppu bus returns false when it doesn't handle the address and the ppu should use its internal memory
+template <typename T>
+concept PpuBus = requires(T& bus, uint16_t address, uint8_t data, uint8_t& out)
+{
+    { bus.ppuRead(address, out) } -> std::same_as<bool>;
+    { bus.ppuWrite(address, data) } -> std::same_as<bool>;
+};
+
+// A bus that can report which rom bank is mapped at a cpu address, negative when the address isn't rom
+// and whether cached, skipped or translated code may run without its fetches and reads going through the bus
+// This is optional, the cpu only caches decoded code on buses that support it
+template <typename T>
+concept CodeBankBus = requires(T& bus, uint16_t address)
+{
+    { bus.cpuCodeBank(address) } -> std::same_as<int32_t>;
+    { bus.cpuCodeBypassAllowed() } -> std::same_as<bool>;
+};
+
+// A bus that also exposes the 2KB internal ram that is mirrored over $0000-$1fff and pointers into the rom
+// The jit only runs on buses like this since its code accesses the ram and rom directly
+template <typename T>
+concept JitBus = CodeBankBus<T> && requires(T& bus, uint16_t address)
+{
+    { bus.cpuRam() } -> std::same_as<std::span<uint8_t>>;
+    { bus.cpuRomPointer(address) } -> std::same_as<const uint8_t*>;
+};
+
+// A bus that connects the interrupt outputs of the devices to the cpu
+// On other buses the ppu only reports the nmi through getNmiStatus
+template <typename T>
+concept InterruptBus = requires(T& bus)
+{
+    { bus.interruptController() } -> std::same_as<InterruptController&>;
+};
+
+// A bus that is told when the ppu starts the vblank, once every frame
+template <typename T>
+concept VblankBus = requires(T& bus)
+{
+    bus.vblankStarted();
+};
+
+// A bus that is told which pattern table bytes the ppu rendered and which the cpu read through $2007
+template <typename T>
+concept ChrLogBus = requires(T& bus, uint16_t address)
+{
+    bus.chrRendered(address);
+    bus.chrRead(address);
+};
+
+// Type erased adapters for tools that want to connect a core to something other than the Bus class
+
+class FunctionalCpuBus
+{
+public:
+    using WriteFunction = std::function<void (uint16_t address, uint8_t data)>;
+    using ReadFunction = std::function<uint8_t (uint16_t address)>;
+
+    FunctionalCpuBus(WriteFunction bus_write, ReadFunction bus_read) :
+        _busWrite(std::move(bus_write)),
+        _busRead(std::move(bus_read))
+    {
+    }
+
+    void cpuWrite(uint16_t address, uint8_t data)
+    {
+        _busWrite(address, data);
+    }
+
+    uint8_t cpuRead(uint16_t address)
+    {
+        return _busRead(address);
+    }
+
+private:
+    WriteFunction _busWrite;
+    ReadFunction _busRead;
+};
+
+class FunctionalPpuBus
+{
+public:
+    using WriteFunction = std::function<bool (uint16_t address, uint8_t data)>;
+    using ReadFunction = std::function<bool (uint16_t address, uint8_t& data)>;
+
+    FunctionalPpuBus(WriteFunction bus_write, ReadFunction bus_read) :
+        _busWrite(std::move(bus_write)),
+        _busRead(std::move(bus_read))
+    {
+    }
+
+    bool ppuWrite(uint16_t address, uint8_t data)
+    {
+        return _busWrite(address, data);
+    }
+
+    bool ppuRead(uint16_t address, uint8_t& data)
+    {
+        return _busRead(address, data);
+    }
+
+private:
+    WriteFunction _busWrite;
+    ReadFunction _busRead;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <fstream>
+#include <functional>
 #include <memory>
 
 #include "Mappers/Mapper.hpp"
@@ -19,6 +20,22 @@ public:
 
     uint8_t getMirroringMode();
 
+    int32_t getPrgBankId(uint16_t address);
+
+    const uint8_t* getPrgPointer(uint16_t address);
+
+    int32_t getPrgRomOffset(uint16_t address);
+
+    int32_t getChrRomOffset(uint16_t address);
+
+    uint32_t getPrgRomSize();
+
+    uint32_t getChrRomSize();
+
+    void setPrgBankSwitchHandler(std::function<void()> handler);
+
+    void setChrBankSwitchHandler(std::function<void(uint16_t address, uint16_t size)> handler);
+
 private:
     struct CartridgeHeader
     {
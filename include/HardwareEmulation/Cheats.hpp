@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// A byte of the rom as the cpu sees it, with a compare value it is only replaced while the mapped bank holds that value
+struct RomPatch
+{
+    uint16_t address;
+    uint8_t value;
+    std::optional<uint8_t> compare;
+};
+
+struct RamFreeze
+{
+    uint16_t address;
+    uint8_t value;
+};
+
+// Game Genie codes and ram freezes
+// The bus maps the rom pages that have patches to patched copies, so reads of the rom never look up a cheat
+class Cheats
+{
+public:
+    static constexpr uint32_t PAGE_SIZE = 0x100;
+
+    // 6 letter codes replace a byte, 8 letter codes also have a compare value
+    static bool DecodeGameGenie(const std::string& code, RomPatch& patch);
+
+    void addRomPatch(const RomPatch& patch);
+    // Only the internal ram ($0000-$1fff) can be frozen
+    bool addRamFreeze(const RamFreeze& freeze);
+    void clear();
+
+    bool hasRomPatches() const;
+    bool isPagePatched(uint32_t page) const;
+    // Applies the patches of the page that starts at pageAddress to a copy of what is mapped there
+    void patchPage(uint16_t pageAddress, std::span<uint8_t, PAGE_SIZE> page) const;
+
+    // Called once a frame
+    void applyRamFreezes(std::span<uint8_t> ram) const;
+
+private:
+    static constexpr char GAME_GENIE_LETTERS[] = "APZLGITYEOXUKSVN";
+    static constexpr uint16_t RAM_MEMORY_RANGE = 0x2000;
+
+    std::vector<RomPatch> _romPatches;
+    std::vector<RamFreeze> _ramFreezes;
+};
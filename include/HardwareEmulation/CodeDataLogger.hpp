@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// The flags of the common .cdl format, a byte for every prg rom byte followed by a byte for every chr rom byte
+enum CdlPrgFlags : uint8_t
+{
+    CDL_CODE = 0x01,
+    CDL_DATA = 0x02,
+    CDL_WINDOW_SHIFT = 2 // bits 2-3 are the 8KB cpu window ($8000, $a000, $c000 or $e000) the byte was mapped at
+};
+
+enum CdlChrFlags : uint8_t
+{
+    CDL_CHR_RENDERED = 0x01,
+    CDL_CHR_READ = 0x02 // read by the cpu through $2007
+};
+
+// Marks every rom byte by how it was used, indexed by the rom offset so it stays right across bank switches
+// The .cdl format has no flag for opcodes so they are kept in a bitmap of their own
+class CodeDataLogger
+{
+public:
+    CodeDataLogger(uint32_t prgSize, uint32_t chrSize);
+
+    void logOpcode(uint32_t offset, uint16_t address);
+    void logOperand(uint32_t offset, uint16_t address);
+    void logData(uint32_t offset, uint16_t address);
+    void logChr(uint32_t offset, CdlChrFlags access);
+
+    bool isOpcode(uint32_t offset) const;
+    const std::vector<uint8_t>& getPrgFlags() const;
+    const std::vector<uint8_t>& getChrFlags() const;
+
+    void reset();
+    void writeCdl(std::ostream& stream) const;
+
+private:
+    static constexpr uint32_t WINDOW_ADDRESS_SHIFT = 13;
+
+    static uint8_t WindowFlags(uint16_t address);
+
+    std::vector<uint8_t> _prgFlags;
+    std::vector<uint8_t> _chrFlags;
+    std::vector<uint64_t> _opcodes;
+};
+
+// These are called for every rom access while the logger runs, they are defined in the header so they inline into the bus
+
+inline uint8_t CodeDataLogger::WindowFlags(uint16_t address)
+{
+    return ((address >> WINDOW_ADDRESS_SHIFT) & 0x3) << CDL_WINDOW_SHIFT;
+}
+
+inline void CodeDataLogger::logOpcode(uint32_t offset, uint16_t address)
+{
+    _opcodes[offset / 64] |= uint64_t(1) << (offset % 64);
+    logOperand(offset, address);
+}
+
+inline void CodeDataLogger::logOperand(uint32_t offset, uint16_t address)
+{
+    _prgFlags[offset] |= CDL_CODE | WindowFlags(address);
+}
+
+inline void CodeDataLogger::logData(uint32_t offset, uint16_t address)
+{
+    _prgFlags[offset] |= CDL_DATA | WindowFlags(address);
+}
+
+inline void CodeDataLogger::logChr(uint32_t offset, CdlChrFlags access)
+{
+    _chrFlags[offset] |= access;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// A standard joypad on $4016 or $4017
+// The front end publishes the buttons from its own thread into an atomic snapshot, the emulation only loads it when the game
+// strobes the joypad so the latched state is as fresh as it can be and neither thread ever waits for the other
+class Controller
+{
+public:
+    // The bits in the order the shift register reports them
+    enum Button : uint8_t
+    {
+        BUTTON_A = 0x01,
+        BUTTON_B = 0x02,
+        BUTTON_SELECT = 0x04,
+        BUTTON_START = 0x08,
+        BUTTON_UP = 0x10,
+        BUTTON_DOWN = 0x20,
+        BUTTON_LEFT = 0x40,
+        BUTTON_RIGHT = 0x80
+    };
+
+    Controller();
+
+    // Can be called from any thread
+    void setButtons(uint8_t buttons);
+
+    // A write to $4016, bit 0 is the strobe
+    void write(uint8_t data);
+    // A read of the joypad port, only bit 0 is driven and the rest is open bus
+    uint8_t read();
+
+    void reset();
+
+private:
+    static_assert(std::atomic<uint8_t>::is_always_lock_free);
+
+    // The high byte of $4016/$4017 is the last value on the data bus when the port is read
+    static constexpr uint8_t OPEN_BUS_BITS = 0x40;
+
+    std::atomic<uint8_t> _buttons;
+    uint8_t _shiftRegister;
+    bool _strobe;
+};
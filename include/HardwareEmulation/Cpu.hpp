@@ -1,32 +1,170 @@
 #pragma once
 
-#include <map>
+#include <array>
+#include <functional>
+#include <ostream>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <fstream>
-#include <functional>
+#include <string>
+
+#include "BusInterface.hpp"
+#include "CpuVariant.hpp"
+#include "InterruptController.hpp"
+#include "CpuDisassembler.hpp"
+#include "CpuTrace.hpp"
+#include "Aot/CpuAot.hpp"
 
+#ifdef CPU_JIT
+#include "Jit/CpuJit.hpp"
+#endif // CPU_JIT
+
+// The variant selects the chip that is emulated, see CpuVariant.hpp
+template <typename BusType, CpuVariant Variant>
 class Cpu {
 public:
-    using WriteFunction = std::function<void (uint16_t address, uint8_t data)>;
-    using ReadFunction = std::function<uint8_t (uint16_t address)>;
-
-    Cpu(WriteFunction bus_write, ReadFunction bus_read);
+    // The constraint lives on the constructor so Cpu<Bus> can be a member of the still incomplete Bus class
+    Cpu(BusType& bus) requires CpuBus<BusType>;
 
     void cpuReset();
 
+    // Takes a pending interrupt instead of the next instruction
     void cpuExecuteInstruction();
 
-    void Irq();
-    void Nmi();
+    // Runs at least one and at most maxInstructions instructions and returns how many ran
+    // More than a single instruction only runs in recompiled code or when the jit is enabled
+    uint32_t cpuExecuteInstructions(uint32_t maxInstructions);
+
+    // Runs instructions until at least cycleBudget cycles passed and returns the cycles that actually ran, the last instruction can run past the budget
+    // Interrupts are only taken between instructions so the caller should end the budget where the ppu can raise an nmi
+    uint32_t runFor(uint32_t cycleBudget);
+
+    // The cycle exact core runs every instruction one bus cycle at a time, including the dummy reads and writes of the 6502
+    // Interrupts are taken at instruction boundaries and the block cache, jit, recompiled code and idle loop skipping aren't used
+    // While it is enabled cpuExecuteInstruction runs cycles until the next instruction boundary
+    void setCycleExactEnabled(bool enabled);
+    // Stays true until the instruction that was running when the core was disabled completes
+    bool isCycleExact() const;
+    void cpuExecuteCycle();
+
+    // Devices raise the nmi and irq through the controller, nothing has to poll them between cpu slots
+    InterruptController& getInterruptController();
+
+    // Charges cycles the cpu spent halted by a device, like the $4014 dma, the bus doesn't run the cpu for that time
+    void stall(uint32_t cycles);
+    size_t getCycles() const;
+
+    struct Registers
+    {
+        uint16_t pc;
+        uint8_t a;
+        uint8_t x;
+        uint8_t y;
+        uint8_t status;
+        uint8_t sp;
+    };
+
+    // Only meaningful between instructions, the tools compare it against known good logs
+    Registers getRegisters() const;
+
+    // The handler is called once when the cpu runs into one of the opcodes that lock it up, the cpu stays on it until a reset
+    void setJamHandler(std::function<void()> handler);
+    bool isJammed() const;
+
+    // The opcode and its operand bytes
+    static uint8_t getInstructionLength(uint8_t opcode);
+    // The cycles without the page cross and branch penalties
+    static uint8_t getInstructionCycles(uint8_t opcode);
+
+    #ifdef CPU_TRACE
+    // The last instructions the interpreter ran, translated code, the cycle exact core and skipped idle loops aren't traced
+    // Only the cpu state is filled in, the bus works out the scanline and dot of every entry from its cycle
+    std::vector<TraceEntry> getTraceEntries() const;
+    #endif // CPU_TRACE
+
+    struct BlockCacheStatistics
+    {
+        uint64_t hits;
+        uint64_t misses;
+        size_t blocks;
+    };
+
+    // The block cache keeps predecoded basic blocks of rom code, it is only used when the bus can report rom banks
+    void setBlockCacheEnabled(bool enabled);
+    void invalidateBlockCache();
+    BlockCacheStatistics getBlockCacheStatistics() const;
+
+    struct JitStatistics
+    {
+        uint64_t translatedBlocks;
+        uint64_t instructions;
+        uint64_t mmioExits;
+        uint64_t differentialChecks;
+        uint64_t differentialMismatches;
+        size_t codeSize;
+    };
+
+    // The jit translates hot rom code to native code, it is only available when built with CPU_JIT and for variants without decimal mode
+    // In differential mode every run of translated code is checked against the interpreter
+    bool setJitEnabled(bool enabled);
+    void setJitDifferentialMode(bool enabled);
+    JitStatistics getJitStatistics() const;
+
+    struct RecompiledStatistics
+    {
+        uint64_t runs;
+        uint64_t instructions;
+        uint64_t misses;
+    };
+
+    // Runs code generated ahead of time by tools/StaticRecompiler, the program has to match the inserted rom
+    // Code the recompiler didn't find still runs in the interpreter
+    bool setRecompiledProgram(const RecompiledProgram* program);
+    RecompiledStatistics getRecompiledStatistics() const;
+
+    struct IdleLoopStatistics
+    {
+        uint64_t fastForwards;
+        uint64_t skippedInstructions;
+        uint64_t skippedCycles;
+    };
+
+    // Short rom loops that only poll memory the ppu or an interrupt can change are skipped to the end of the instruction budget
+    // A skip leaves the same state running the loop would have, the switch is there for accuracy testing
+    void setIdleLoopDetectionEnabled(bool enabled);
+    IdleLoopStatistics getIdleLoopStatistics() const;
+
+    #ifdef CPU_STATISTICS
+    // Counted by the interpreter and the cycle exact core, code that runs in the jit, recompiled code or a skipped idle loop isn't counted
+    struct ExecutionStatistics
+    {
+        std::array<uint64_t, 0x100> executions;
+        std::array<uint64_t, 0x100> pageCrosses; // the extra cycle of indexed reads and branches that crossed a page
+        std::array<uint64_t, 0x100> branchesTaken;
+    };
 
-    std::map<uint16_t, std::string> disassemble();
+    void resetExecutionStatistics();
+    const ExecutionStatistics& getExecutionStatistics() const;
+    // The instruction mix sorted by executions, per opcode and per addressing mode
+    void writeExecutionReport(std::ostream& stream) const;
+    #endif // CPU_STATISTICS
 private:
     #ifdef NESTEST_DEBUG
     friend class NestestLogTester;
     #endif // NESTEST_DEBUG
+    #ifdef CPU_JIT
+    friend class CpuJit<BusType, Variant>;
+    #endif // CPU_JIT
+    friend class CpuAot<BusType, Variant>;
+    friend class CpuDisassembler<BusType, Variant>;
+    friend class StaticRecompiler;
+    friend class TraceFormatter;
 
     static constexpr uint32_t STACK_OFFSET = 0x100;
+    static constexpr uint32_t MAX_BLOCK_LENGTH = 32;
+    static constexpr uint32_t MAX_IDLE_LOOP_LENGTH = 8;
+    static constexpr uint32_t MAX_INSTRUCTION_CYCLES = 8;
     static constexpr uint32_t STACK_SIZE = 0x100;
 
     static constexpr uint8_t CARRY_FLAG_MASK = 0x01;
@@ -38,10 +176,6 @@ private:
     static constexpr uint8_t OVERFLOW_FLAG_MASK = 0x40;
     static constexpr uint8_t NEGATIVE_FLAG_MASK = 0x80;
 
-    static constexpr uint16_t ABORT_LSB = 0xfff8;
-    static constexpr uint16_t ABORT_MSB = 0xfff9;
-    static constexpr uint16_t COP_LSB = 0xfff4;
-    static constexpr uint16_t COP_MSB = 0xfff5;
     static constexpr uint16_t NORMAL_IRQ_LSB = 0xfffe;
     static constexpr uint16_t NORMAL_IRQ_MSB = 0xffff;
     static constexpr uint16_t BRK_LSB = NORMAL_IRQ_LSB;
@@ -53,8 +187,6 @@ private:
 
     enum class IrqType
     {
-        ABORT,
-        COP,
         NORMAL_IRQ,
         BRK,
         NMI,
@@ -146,24 +278,169 @@ private:
         uint8_t cycles;
     };
 
-    using AddressFunction = std::function<uint16_t ()>;
-    using InstructionFunction = std::function<void (AMode addrMode)>;
+    using OpcodeHandler = void (Cpu::*)();
+
+    // A single bus cycle of the cycle exact core
+    enum class MicroOp : uint8_t
+    {
+        DUMMY_READ_PC,
+        DUMMY_READ_STACK,
+        SKIP_PADDING, // the byte after BRK is read and skipped
+        FETCH_ADDRESS_LOW,
+        FETCH_ADDRESS_HIGH,
+        FETCH_ADDRESS_HIGH_ADD_X,
+        FETCH_ADDRESS_HIGH_ADD_Y,
+        ADD_X_ZP, // a dummy read from the zero page address before the index is added
+        ADD_Y_ZP,
+        FETCH_POINTER,
+        ADD_X_POINTER,
+        READ_POINTER_LOW,
+        READ_POINTER_HIGH,
+        READ_POINTER_HIGH_ADD_Y,
+        READ_INDEXED, // reads from the address without the page fix, this is the real read when no page was crossed
+        DUMMY_READ_INDEXED, // writes and rmw always read from the address without the page fix
+        READ_EXECUTE,
+        READ_IMMEDIATE_EXECUTE,
+        DUMMY_READ_EXECUTE, // implied and accumulator instructions
+        WRITE_REGISTER,
+        READ_DATA,
+        DUMMY_WRITE_MODIFY, // rmw instructions write the unmodified value back first
+        WRITE_DATA,
+        FETCH_BRANCH_OFFSET,
+        BRANCH_TAKEN,
+        BRANCH_FIX_PAGE,
+        JUMP_ABSOLUTE,
+        READ_JUMP_POINTER_LOW,
+        READ_JUMP_POINTER_HIGH,
+        PUSH_PC_HIGH,
+        PUSH_PC_LOW,
+        PUSH_A,
+        PUSH_STATUS,
+        PUSH_STATUS_BREAK,
+        PUSH_STATUS_INTERRUPT,
+        PULL_A,
+        PULL_STATUS,
+        PULL_PC_LOW,
+        PULL_PC_HIGH,
+        INCREMENT_PC,
+        READ_VECTOR_LOW,
+        READ_VECTOR_HIGH
+    };
+
+    static constexpr uint32_t MAX_MICRO_PROGRAM_LENGTH = 7;
+
+    // The cycles of an instruction after its opcode fetch
+    struct MicroProgram
+    {
+        uint8_t length;
+        std::array<MicroOp, MAX_MICRO_PROGRAM_LENGTH> ops;
+    };
+
+    struct DecodedInstruction
+    {
+        OpcodeHandler handler; // a handler that uses the predecoded operand instead of fetching it
+        uint16_t pc;
+        uint16_t operand;
+        uint8_t opcode;
+        uint8_t length;
+    };
+
+    struct DecodedBlock
+    {
+        int32_t bank;
+        uint32_t cycles; // base cycles of the whole block without branch and page cross penalties
+        std::vector<DecodedInstruction> instructions;
+    };
+
+    // A loop that jumped back from end to start, it is skipped once an iteration ends with the same state it started with
+    struct IdleLoopProbe
+    {
+        bool active;
+        uint16_t start;
+        uint16_t end; // the pc of the instruction that jumps back
+        uint8_t a;
+        uint8_t x;
+        uint8_t y;
+        uint8_t sp;
+        uint8_t status;
+        size_t cycles;
+        uint32_t budget; // the instruction budget that was left when the state was taken
+        uint32_t instructions; // instructions that ran since the state was taken
+    };
 
     uint16_t _pc; //program counter
     uint8_t _sp; //stack
     uint8_t _a; //accumulator
     uint8_t _x; //index
     uint8_t _y; //index
-    uint8_t _p; //flags
+    uint8_t _p; //flags, use getStatus/setStatus since with lazy flags only I and D are kept here
+    #ifdef CPU_LAZY_FLAGS
+    // C, Z, V and N are stored as the values they were computed from and only turned into bits when read
+    uint8_t _lazyCarry; // bit 0 is the carry
+    uint8_t _lazyZero; // zero flag is set when this is 0
+    uint8_t _lazyOverflow; // bit 7 is the overflow
+    uint8_t _lazyNegative; // bit 7 is the negative
+    #endif // CPU_LAZY_FLAGS
     size_t _cycles;
-    WriteFunction _busWrite;
-    ReadFunction _busRead;
-    std::unordered_map<AMode, AddressFunction> _addressModeMapper;
-    std::unordered_map<IType, InstructionFunction> _instructionTypeMapper;
+    uint16_t _operand; // the operand bytes of the current instruction
+    BusType& _bus;
     std::unordered_map<IrqType, std::pair<uint16_t, uint16_t>> _irqVectorMap;
-    std::vector<Instruction> _opcodeVector;
     bool _loop_running;
 
+    // The opcode matrix and the dispatch table generated from it are both built at compile time
+    static const std::array<Instruction, 0x100> _opcodeVector;
+    static const std::array<OpcodeHandler, 0x100> _dispatchTable;
+    static const std::array<OpcodeHandler, 0x100> _decodedDispatchTable;
+
+    // The micro-op programs are generated at compile time from the opcode matrix
+    static const std::array<MicroProgram, 0x100> _microPrograms;
+    static const MicroProgram _interruptProgram; // nmi and irq, the opcode fetch is replaced by a dummy read
+    // The operation of read and implied instructions, the data was already read into the operand
+    static const std::array<OpcodeHandler, 0x100> _microOperationTable;
+
+    // Keyed by the rom bank in the high 16 bits and the pc in the low 16 bits
+    std::unordered_map<uint32_t, DecodedBlock> _blockCache;
+    const DecodedBlock* _currentBlock;
+    size_t _blockIndex;
+    bool _blockCacheEnabled;
+    uint64_t _blockCacheHits;
+    uint64_t _blockCacheMisses;
+
+    bool _idleLoopDetectionEnabled;
+    IdleLoopProbe _idleLoopProbe;
+    // Whether the loop body can be skipped, keyed by the rom bank in the high 32 bits, then the start and end pc
+    std::unordered_map<uint64_t, bool> _idleLoopBodies;
+    IdleLoopStatistics _idleLoopStatistics;
+
+    bool _cycleExact;
+    const MicroProgram* _microProgram; // nullptr between instructions
+    uint8_t _microStep;
+    uint8_t _microOpcode;
+    uint16_t _microAddress;
+    uint16_t _microBase; // the address before the index was added
+    uint8_t _microPointer;
+    uint8_t _microData;
+
+    InterruptController _interrupts;
+
+    bool _jammed;
+    std::function<void()> _jamHandler;
+
+    #ifdef CPU_TRACE
+    CpuTrace _trace;
+    #endif // CPU_TRACE
+
+    #ifdef CPU_STATISTICS
+    ExecutionStatistics _executionStatistics;
+    uint8_t _statisticsOpcode; // the opcode the page crosses and branches are counted for
+    #endif // CPU_STATISTICS
+
+    CpuAot<BusType, Variant> _aot;
+
+    #ifdef CPU_JIT
+    CpuJit<BusType, Variant> _jit;
+    #endif // CPU_JIT
+
     std::vector<std::string> _aModeNameMapper = 
     {
         "ACCUM",
@@ -246,11 +523,106 @@ private:
 
     void clearFlag(uint8_t flagMask);
 
-    uint8_t getFlag(uint8_t flagMask);
+    uint8_t getFlag(uint8_t flagMask) const;
+
+    // Flag updates used by the instruction handlers, with lazy flags these are plain stores
+    void setZeroNegative(uint8_t result);
+
+    void setZeroNegative(uint8_t zeroSource, uint8_t negativeSource);
+
+    void setCarry(bool val);
+
+    // Bit 7 of the source is the new overflow flag
+    void setOverflow(uint8_t overflowSource);
+
+    // The full status register as it would be pushed to the stack (without the B and reserved bits)
+    uint8_t getStatus() const;
+
+    #ifdef CPU_LAZY_FLAGS
+    static uint8_t composeStatus(uint8_t p, uint8_t lazyCarry, uint8_t lazyZero, uint8_t lazyOverflow, uint8_t lazyNegative);
+    #endif // CPU_LAZY_FLAGS
+
+    void setStatus(uint8_t status);
 
     void cpuWrite(uint16_t address, uint8_t data);
 
     uint8_t cpuRead(uint16_t address);
+    // Reads an opcode
+    uint8_t cpuFetch(uint16_t address);
+
+    static constexpr uint8_t operandLength(AMode addrMode);
+
+    static constexpr bool isControlFlow(IType type);
+
+    static constexpr bool isBranch(IType type);
+
+    // The instructions that only read their operand, the ones that pay the page cross penalty
+    static constexpr bool isReadInstruction(IType type);
+
+    // The illegal opcodes that halt the 6502, they are run as the MIA nops by everything but the jam check
+    static constexpr bool isJamOpcode(uint8_t opcode);
+
+    void jam();
+
+    template <bool fetch, size_t... opcodes>
+    static constexpr std::array<OpcodeHandler, 0x100> makeDispatchTable(std::index_sequence<opcodes...>);
+
+    // Every dispatch table entry is this function specialized for a single opcode
+    // The decoded dispatch table uses the versions that don't fetch their operand
+    template <size_t opcode, bool fetch>
+    void executeOpcode();
+
+    template <IType type, AMode addrMode>
+    void executeOperation();
+
+    template <size_t... opcodes>
+    static constexpr std::array<OpcodeHandler, 0x100> makeMicroOperationTable(std::index_sequence<opcodes...>);
+
+    template <size_t opcode>
+    void executeMicroOperation();
+
+    static constexpr MicroProgram makeMicroProgram(Instruction instruction);
+
+    // Every documented opcode has to take as many cycles in the cycle exact core as the opcode matrix says, otherwise the table doesn't compile
+    static constexpr std::array<MicroProgram, 0x100> makeMicroPrograms();
+
+    static constexpr bool microProgramMatches(Instruction instruction, const MicroProgram& program);
+
+    void executeMicroOp(MicroOp op);
+
+    void startInterrupt(IrqType type);
+
+    // Checked at instruction boundaries, returns true when an interrupt was taken
+    bool takeInterrupt();
+
+    void interrupt(IrqType type);
+
+    // The next instruction without the interrupt check, the jit replays translated code with it
+    void executeInstruction();
+
+    bool branchCondition(IType type) const;
+
+    uint8_t modifyData(IType type, uint8_t data);
+
+    const DecodedInstruction* nextDecodedInstruction();
+
+    DecodedBlock decodeBlock(uint16_t pc, int32_t bank);
+
+    // Called after the instruction at pc ran, returns how many more instructions were skipped
+    uint32_t skipIdleLoop(uint16_t pc, uint32_t maxInstructions);
+
+    bool isIdleLoopBody(uint16_t start, uint16_t end);
+
+    template <AMode addrMode>
+    void fetchOperand();
+
+    // Reads the data of a read instruction, immediate operands don't go through the bus again
+    template <AMode addrMode>
+    uint8_t readOperand();
+
+    // Page cross penalties only apply to read instructions, writes and rmw always pay the extra cycle
+    template <AMode addrMode, bool pagePenalty = true>
+    uint16_t resolveAddress();
 
     // This are the diffrent addresing modes:
 
@@ -266,9 +638,9 @@ private:
 
     uint16_t iZpYAddr();
  
-    uint16_t iAbsoluteAddrX();
+    uint16_t iAbsoluteAddrX(bool pagePenalty);
 
-    uint16_t iAbsoluteAddrY();
+    uint16_t iAbsoluteAddrY(bool pagePenalty);
 
     uint16_t impliedAddr();
 
@@ -276,65 +648,115 @@ private:
 
     uint16_t iIndirectAddr();
 
-    uint16_t indirectIAddr();
+    uint16_t indirectIAddr(bool pagePenalty);
 
     uint16_t indirectAddr(); 
 
+    void branch(bool condition);
+
+    // Decimal mode adc and sbc, only compiled in for variants that have it
+    uint8_t addDecimal(uint8_t data) requires (Variant::DECIMAL_MODE);
+
+    uint8_t subtractDecimal(uint8_t data, uint8_t carry) requires (Variant::DECIMAL_MODE);
+
     // Instruction set
-    void Adc(AMode addrMode);
-    void And(AMode addrMode);
-    void Asl(AMode addrMode);
-    void Bcc(AMode addrMode);
-    void Bcs(AMode addrMode);
-    void Beq(AMode addrMode);
-    void Bit(AMode addrMode);
-    void Bmi(AMode addrMode);
-    void Bne(AMode addrMode);
-    void Bpl(AMode addrMode);
-    void Brk(AMode addrMode);
-    void Bvc(AMode addrMode);
-    void Bvs(AMode addrMode);
-    void Clc(AMode addrMode);
-    void Cld(AMode addrMode);
-    void Cli(AMode addrMode);
-    void Clv(AMode addrMode);
-    void Cmp(AMode addrMode);
-    void Cpx(AMode addrMode);
-    void Cpy(AMode addrMode);
-    void Dec(AMode addrMode);
-    void Dex(AMode addrMode);
-    void Dey(AMode addrMode);
-    void Eor(AMode addrMode);
-    void Inc(AMode addrMode);
-    void Inx(AMode addrMode);
-    void Iny(AMode addrMode);
-    void Jmp(AMode addrMode);
-    void Jsr(AMode addrMode);
-    void Lda(AMode addrMode);
-    void Ldx(AMode addrMode);
-    void Ldy(AMode addrMode);
-    void Lsr(AMode addrMode);
-    void Nop(AMode addrMode);
-    void Ora(AMode addrMode);
-    void Pha(AMode addrMode);
-    void Php(AMode addrMode);
-    void Pla(AMode addrMode);
-    void Plp(AMode addrMode);
-    void Rol(AMode addrMode);
-    void Ror(AMode addrMode);
-    void Rti(AMode addrMode);
-    void Rts(AMode addrMode);
-    void Sbc(AMode addrMode);
-    void Sec(AMode addrMode);
-    void Sed(AMode addrMode);
-    void Sei(AMode addrMode);
-    void Sta(AMode addrMode);
-    void Stx(AMode addrMode);
-    void Sty(AMode addrMode);
-    void Tax(AMode addrMode);
-    void Tay(AMode addrMode);
-    void Tsx(AMode addrMode);
-    void Txa(AMode addrMode);
-    void Txs(AMode addrMode);
-    void Tya(AMode addrMode);
-};
\ No newline at end of file
+    template <AMode addrMode> void Adc();
+    template <AMode addrMode> void And();
+    template <AMode addrMode> void Asl();
+    void Bcc();
+    void Bcs();
+    void Beq();
+    template <AMode addrMode> void Bit();
+    void Bmi();
+    void Bne();
+    void Bpl();
+    void Brk();
+    void Bvc();
+    void Bvs();
+    void Clc();
+    void Cld();
+    void Cli();
+    void Clv();
+    template <AMode addrMode> void Cmp();
+    template <AMode addrMode> void Cpx();
+    template <AMode addrMode> void Cpy();
+    template <AMode addrMode> void Dec();
+    void Dex();
+    void Dey();
+    template <AMode addrMode> void Eor();
+    template <AMode addrMode> void Inc();
+    void Inx();
+    void Iny();
+    template <AMode addrMode> void Jmp();
+    template <AMode addrMode> void Jsr();
+    template <AMode addrMode> void Lda();
+    template <AMode addrMode> void Ldx();
+    template <AMode addrMode> void Ldy();
+    template <AMode addrMode> void Lsr();
+    template <AMode addrMode> void Nop();
+    template <AMode addrMode> void Ora();
+    void Pha();
+    void Php();
+    void Pla();
+    void Plp();
+    template <AMode addrMode> void Rol();
+    template <AMode addrMode> void Ror();
+    void Rti();
+    void Rts();
+    template <AMode addrMode> void Sbc();
+    void Sec();
+    void Sed();
+    void Sei();
+    template <AMode addrMode> void Sta();
+    template <AMode addrMode> void Stx();
+    template <AMode addrMode> void Sty();
+    void Tax();
+    void Tay();
+    void Tsx();
+    void Txa();
+    void Txs();
+    void Tya();
+};
+
+// The opcode classification is shared with the jit, the static recompiler and the disassembler so it lives in the header
+template <typename BusType, CpuVariant Variant>
+constexpr bool Cpu<BusType, Variant>::isBranch(IType type)
+{
+    switch (type)
+    {
+    case IType::BCC:
+    case IType::BCS:
+    case IType::BEQ:
+    case IType::BMI:
+    case IType::BNE:
+    case IType::BPL:
+    case IType::BVC:
+    case IType::BVS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+constexpr bool Cpu<BusType, Variant>::isReadInstruction(IType type)
+{
+    switch (type)
+    {
+    case IType::ADC:
+    case IType::AND:
+    case IType::BIT:
+    case IType::CMP:
+    case IType::CPX:
+    case IType::CPY:
+    case IType::EOR:
+    case IType::LDA:
+    case IType::LDX:
+    case IType::LDY:
+    case IType::ORA:
+    case IType::SBC:
+        return true;
+    default:
+        return false;
+    }
+}
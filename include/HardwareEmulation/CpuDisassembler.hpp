@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "CpuVariant.hpp"
+
+// A recursive descent disassembler, it starts at the interrupt vectors and follows branches, jumps and subroutine calls through the rom
+// Only captureRom touches the bus, disassembling and formatting work on the copy so they can run on another thread while the cpu runs
+template <typename BusType, CpuVariant Variant = Ricoh2A03>
+class CpuDisassembler
+{
+public:
+    // The text of an instruction is only built when it is formatted
+    struct Record
+    {
+        uint16_t address;
+        uint16_t operand;
+        uint8_t opcode;
+    };
+
+    CpuDisassembler(Cpu<BusType, Variant>& cpu);
+
+    // Copies $8000-$ffff as the cpu sees it, on the Bus addresses that aren't rom are left out
+    void captureRom();
+
+    // Replaces the records with the code reachable from the vectors of the captured rom, sorted by address
+    void disassemble();
+
+    const std::vector<Record>& getRecords() const;
+
+    std::string format(const Record& record) const;
+
+    void writeLog(std::ostream& stream) const;
+
+private:
+    static constexpr uint32_t ROM_START = 0x8000;
+    static constexpr uint32_t ROM_SIZE = 0x8000;
+
+    using IType = typename Cpu<BusType, Variant>::IType;
+    using AMode = typename Cpu<BusType, Variant>::AMode;
+
+    bool isRom(uint32_t address) const;
+    uint8_t romRead(uint32_t address) const;
+    uint16_t romReadWord(uint32_t address) const;
+
+    Cpu<BusType, Variant>& _cpu;
+    std::array<uint8_t, ROM_SIZE> _rom;
+    std::array<bool, ROM_SIZE> _isRom;
+    std::vector<Record> _records;
+};
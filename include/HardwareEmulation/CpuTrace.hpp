@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// What the cpu stores for every instruction, plain copies of the state it started with
+// In CPU_LAZY_FLAGS builds C, Z, V and N are kept as their sources, the cpu builds the status when the trace is read
+struct TraceRecord
+{
+    uint64_t cycle;
+    uint16_t pc;
+    uint16_t operand; // only the bytes the addressing mode uses are valid
+    uint8_t opcode;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t sp;
+    uint8_t p;
+    uint8_t lazyCarry;
+    uint8_t lazyZero;
+    uint8_t lazyOverflow;
+    uint8_t lazyNegative;
+};
+
+// An instruction the cpu ran as it is written to a dump, the registers and positions are the ones it started with
+struct TraceEntry
+{
+    uint64_t cycle;
+    uint16_t pc;
+    uint16_t operand; // only the bytes the addressing mode uses are valid
+    uint16_t scanline;
+    uint16_t dot;
+    uint8_t opcode;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t status;
+    uint8_t sp;
+};
+
+// A fixed size ring of the last instructions, recording one is a few plain stores so it can stay enabled
+// tools/TraceFormatter turns a dump of the ring into nestest or DK.log style text
+class CpuTrace
+{
+public:
+    static constexpr uint32_t CAPACITY = 0x1000;
+
+    CpuTrace();
+
+    // The slot for the next instruction, it overwrites the oldest one
+    TraceRecord& next();
+    // The slot that was returned by the last call to next
+    TraceRecord& last();
+
+    // The records from the oldest to the newest
+    std::vector<TraceRecord> getRecords() const;
+
+    void clear();
+
+    // A dump holds the traced instructions and the screen at the time it was written
+    static bool WriteDump(const std::string& path, std::span<const TraceEntry> entries, std::span<const uint32_t> screen);
+    static bool ReadDump(const std::string& path, std::vector<TraceEntry>& entries, std::vector<uint32_t>& screen);
+
+private:
+    static constexpr uint32_t INDEX_MASK = CAPACITY - 1;
+    static constexpr char DUMP_MAGIC[8] = {'N', 'E', 'S', 'T', 'R', 'A', 'C', 'E'};
+
+    struct DumpHeader
+    {
+        char magic[8];
+        uint32_t entrySize;
+        uint32_t entryCount;
+        uint32_t screenSize;
+    };
+
+    std::array<TraceRecord, CAPACITY> _records;
+    uint64_t _count;
+};
+
+// These are called for every instruction, they are defined in the header so they inline into the cpu
+
+inline TraceRecord& CpuTrace::next()
+{
+    return _records[_count++ & INDEX_MASK];
+}
+
+inline TraceRecord& CpuTrace::last()
+{
+    return _records[(_count - 1) & INDEX_MASK];
+}
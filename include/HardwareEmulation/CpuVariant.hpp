@@ -0,0 +1,26 @@
+#pragma once
+
+#include <concepts>
+
+// The cpu is specialized at compile time for the chip it emulates, anything a variant doesn't have is compiled out
+
+// The Ricoh 2A03 of the NES, a 6502 without decimal mode
+struct Ricoh2A03
+{
+    static constexpr bool DECIMAL_MODE = false;
+};
+
+// The NMOS 6502, used to run generic 6502 test binaries
+struct Mos6502
+{
+    static constexpr bool DECIMAL_MODE = true;
+};
+
+template <typename T>
+concept CpuVariant = requires
+{
+    { T::DECIMAL_MODE } -> std::convertible_to<bool>;
+};
+
+template <typename BusType, CpuVariant Variant = Ricoh2A03>
+class Cpu;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+// The interrupt inputs of the cpu, devices assert and release their lines and the cpu checks them once per instruction boundary
+// The irq sources and the nmi latch share a byte so the check between instructions is a single compare
+class InterruptController
+{
+public:
+    enum IrqSource : uint8_t
+    {
+        MAPPER_IRQ = 0x01,
+        FRAME_COUNTER_IRQ = 0x02,
+        DMC_IRQ = 0x04
+    };
+
+    InterruptController();
+
+    // The irq is level triggered, it is taken while any source asserts it and the interrupt disable flag is clear
+    void assertIrq(IrqSource source);
+    void releaseIrq(IrqSource source);
+    bool isIrqAsserted() const;
+
+    // The nmi is edge triggered, the edge stays latched until the cpu takes it
+    void triggerNmi();
+    // Returns true and clears the latch when an edge was latched
+    bool takeNmi();
+
+    bool isPending() const;
+
+    void reset();
+
+private:
+    static constexpr uint8_t NMI_LATCH = 0x80;
+    static constexpr uint8_t IRQ_SOURCES_MASK = 0x7f;
+
+    uint8_t _lines;
+};
+
+// These are called by the devices and between every instruction, they are defined in the header so they inline into both
+
+inline InterruptController::InterruptController()
+{
+    _lines = 0;
+}
+
+inline void InterruptController::assertIrq(IrqSource source)
+{
+    _lines |= source;
+}
+
+inline void InterruptController::releaseIrq(IrqSource source)
+{
+    _lines &= ~source;
+}
+
+inline bool InterruptController::isIrqAsserted() const
+{
+    return _lines & IRQ_SOURCES_MASK;
+}
+
+inline void InterruptController::triggerNmi()
+{
+    _lines |= NMI_LATCH;
+}
+
+inline bool InterruptController::takeNmi()
+{
+    bool latched = _lines & NMI_LATCH;
+    _lines &= ~NMI_LATCH;
+    return latched;
+}
+
+inline bool InterruptController::isPending() const
+{
+    return _lines != 0;
+}
+
+inline void InterruptController::reset()
+{
+    _lines = 0;
+}
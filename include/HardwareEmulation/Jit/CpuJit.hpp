@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ExecutableMemory.hpp"
+#include "X86Emitter.hpp"
+#include "HardwareEmulation/CpuVariant.hpp"
+
+// Translates hot blocks of rom code to x86-64 code
+// Translated code only touches the internal ram, every other access exits back to the interpreter before the instruction runs
+// Blocks that loop back to their own start keep running natively until the instruction budget runs out
+template <typename BusType, CpuVariant Variant>
+class CpuJit
+{
+public:
+    struct Statistics
+    {
+        uint64_t translatedBlocks;
+        uint64_t instructions; // instructions that ran in translated code
+        uint64_t mmioExits;
+        uint64_t differentialChecks;
+        uint64_t differentialMismatches;
+        size_t codeSize;
+    };
+
+    CpuJit(Cpu<BusType, Variant>& cpu);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Every run of translated code is repeated by the interpreter and the results are compared
+    void setDifferentialMode(bool enabled);
+
+    void invalidate();
+
+    // Runs translated code from the current pc and returns how many instructions ran
+    // Returns 0 when the code at the pc isn't translated, the caller should interpret the next instruction
+    uint32_t run(uint32_t maxInstructions);
+
+    Statistics getStatistics() const;
+
+private:
+    static constexpr uint32_t HOT_BLOCK_THRESHOLD = 16;
+    // Shorter blocks cost more to enter and leave than they save, unless they loop on themselves
+    static constexpr uint32_t MIN_BLOCK_LENGTH = 4;
+    static constexpr size_t CODE_MEMORY_SIZE = 4 * 1024 * 1024;
+
+    // The state the translated code works on, it is kept standard layout so the code can address its fields
+    struct JitState
+    {
+        uint64_t cycles;
+        uint8_t* ram;
+        uint32_t maxInstructions;
+        uint32_t instructions;
+        uint16_t pc;
+        uint8_t a;
+        uint8_t x;
+        uint8_t y;
+        uint8_t sp;
+        uint8_t carry; // 0 or 1
+        uint8_t zero; // the zero flag is set when this is 0
+        uint8_t overflow; // bit 7 is the overflow
+        uint8_t negative; // bit 7 is the negative
+        uint8_t mmioExit;
+    };
+
+    using JitFunction = void (*)(JitState*);
+
+    struct JitBlock
+    {
+        int32_t bank;
+        uint32_t executions;
+        JitFunction code;
+        bool translatable;
+    };
+
+    struct PendingExit
+    {
+        size_t patch;
+        uint16_t pc;
+        uint32_t instructions;
+        bool mmio;
+        bool dynamicPc; // the pc is already in eax
+    };
+
+    struct CpuSnapshot
+    {
+        uint16_t pc;
+        uint8_t sp;
+        uint8_t a;
+        uint8_t x;
+        uint8_t y;
+        uint8_t status;
+        uint64_t cycles;
+        std::vector<uint8_t> ram;
+
+        bool operator==(const CpuSnapshot&) const = default;
+    };
+
+    JitFunction lookup(uint16_t pc);
+    // Returns false when the block isn't worth translating
+    bool translate(uint16_t pc, int32_t bank, X86Emitter& emitter);
+
+    uint32_t runTranslated(uint32_t maxInstructions);
+
+    void loadState(JitState& state);
+    void storeState(const JitState& state);
+
+    CpuSnapshot takeSnapshot();
+    void restoreSnapshot(const CpuSnapshot& snapshot);
+
+    bool isTranslatable(uint8_t opcode, uint16_t operand);
+    // Returns the rom that backs a range of cpu addresses or nullptr when the range isn't contiguous rom
+    const uint8_t* romPointer(uint16_t address, uint32_t length);
+    // Returns true when the instruction always leaves the block
+    bool emitInstruction(X86Emitter& emitter, uint8_t opcode, uint16_t pc, uint16_t operand, uint32_t index,
+        uint16_t blockStart, uint32_t blockLength, size_t loopStart, std::vector<PendingExit>& exits);
+    // Leaves the offset of the effective address in eax and returns the register it is relative to
+    // That is the ram unless the address is known to be in rom, other addresses exit before the instruction runs
+    X86Emitter::Reg emitAddress(X86Emitter& emitter, uint8_t opcode, uint16_t pc, uint16_t operand, uint32_t index,
+        bool pagePenalty, std::vector<PendingExit>& exits);
+    // Jumps back to the loop start when the target is the start of the block, otherwise exits to the target
+    void emitJump(X86Emitter& emitter, uint16_t target, uint16_t blockStart, uint32_t blockLength, size_t loopStart,
+        std::vector<PendingExit>& exits);
+
+    Cpu<BusType, Variant>& _cpu;
+    bool _enabled;
+    bool _differentialMode;
+    std::unique_ptr<ExecutableMemory> _codeMemory;
+    // Keyed the same way as the cpu block cache
+    std::unordered_map<uint32_t, JitBlock> _blocks;
+    // The last block seen at every pc, checked before the map since most lookups are for code that isn't translated
+    std::vector<JitBlock*> _recentBlocks;
+    Statistics _statistics;
+};
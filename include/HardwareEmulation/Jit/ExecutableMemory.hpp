@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A fixed size arena for generated code
+// The arena is only writable while code is copied into it and executable the rest of the time
+class ExecutableMemory
+{
+public:
+    ExecutableMemory(size_t size);
+    ~ExecutableMemory();
+
+    ExecutableMemory(const ExecutableMemory&) = delete;
+    ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+    // Returns the executable copy of the code or nullptr when the arena is full, throws when the protection can't be changed
+    const uint8_t* commit(const std::vector<uint8_t>& code);
+
+    void reset();
+
+    size_t used() const;
+
+private:
+    uint8_t* _memory;
+    size_t _size;
+    size_t _used;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A minimal x86-64 machine code emitter with only the instructions the cpu jit needs
+// Register operations are 32 bit unless the name says otherwise
+class X86Emitter
+{
+public:
+    enum class Reg : uint8_t
+    {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11, R12, R13, R14, R15
+    };
+
+    enum class AluOp : uint8_t
+    {
+        ADD = 0,
+        OR = 1,
+        ADC = 2,
+        SBB = 3,
+        AND = 4,
+        SUB = 5,
+        XOR = 6,
+        CMP = 7
+    };
+
+    enum class Condition : uint8_t
+    {
+        B = 0x2, // unsigned below (carry set)
+        AE = 0x3, // unsigned above or equal (carry clear)
+        E = 0x4,
+        NE = 0x5,
+        BE = 0x6,
+        A = 0x7
+    };
+
+    const std::vector<uint8_t>& code() const;
+    size_t size() const;
+
+    void mov(Reg dst, Reg src);
+    void movImm(Reg dst, uint32_t imm);
+    void movImm64(Reg dst, uint64_t imm);
+    void alu(AluOp op, Reg dst, Reg src);
+    void aluImm(AluOp op, Reg dst, int32_t imm);
+    void alu64(AluOp op, Reg dst, Reg src);
+    void aluImm64(AluOp op, Reg dst, int32_t imm);
+    void shlImm(Reg dst, uint8_t count);
+    void shrImm(Reg dst, uint8_t count);
+    void test(Reg dst, Reg src);
+    void testImm(Reg dst, uint32_t imm);
+    void setcc(Condition condition, Reg dst);
+
+    // Memory operands are either [base + disp] or [base + index]
+    void loadByte(Reg dst, Reg base, int32_t disp);
+    void loadByteIndexed(Reg dst, Reg base, Reg index);
+    void storeByte(Reg base, int32_t disp, Reg src);
+    void storeByteIndexed(Reg base, Reg index, Reg src);
+    void loadWord(Reg dst, Reg base, int32_t disp);
+    void storeWord(Reg base, int32_t disp, Reg src);
+    void load32(Reg dst, Reg base, int32_t disp);
+    void store32(Reg base, int32_t disp, Reg src);
+    void load64(Reg dst, Reg base, int32_t disp);
+    void store64(Reg base, int32_t disp, Reg src);
+
+    void push(Reg reg);
+    void pop(Reg reg);
+    void ret();
+
+    // Forward jumps return the position of their displacement so it can be bound once the target is known
+    size_t jcc(Condition condition);
+    size_t jmp();
+    void bind(size_t patch);
+    void jccTo(Condition condition, size_t target);
+    void jmpTo(size_t target);
+
+private:
+    void emit8(uint8_t value);
+    void emit32(uint32_t value);
+    void rex(bool wide, uint8_t reg, uint8_t index, uint8_t base, bool byteOperand = false);
+    void modRmReg(uint8_t reg, uint8_t rm);
+    void modRmMemory(uint8_t reg, uint8_t base, int32_t disp);
+    void modRmIndexed(uint8_t reg, uint8_t base, uint8_t index);
+    void patch32(size_t position, uint32_t value);
+
+    std::vector<uint8_t> _code;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <vector>
 #include <array>
 
@@ -25,8 +26,62 @@ public:
 	virtual bool ppuWriteMap(uint16_t address, uint8_t data) = 0;
 	virtual bool ppuReadMap(uint16_t address, uint8_t& data) = 0;
 
+	// Returns the prg rom bank mapped at a cpu address or -1 if the address isn't mapped to prg rom
+	virtual int32_t getPrgBankId(uint16_t address) = 0;
+
+	// Returns the prg rom byte mapped at a cpu address or nullptr if the address isn't mapped to prg rom
+	// The pointer is only valid until the bank at the address is switched
+	virtual const uint8_t* getPrgPointer(uint16_t address) = 0;
+
+	// Returns the offset in the prg rom of the byte mapped at a cpu address or -1 if the address isn't mapped to prg rom
+	virtual int32_t getPrgRomOffset(uint16_t address) = 0;
+	// Returns the offset in the chr rom of the byte mapped at a ppu address or -1 if the address isn't mapped to chr rom
+	virtual int32_t getChrRomOffset(uint16_t address) = 0;
+
+	uint32_t getPrgRomSize() const
+	{
+		return _prgRomBankVector.size() * PRG_ROM_BANK_SIZE;
+	}
+
+	uint32_t getChrRomSize() const
+	{
+		return _chrRomBankVector.size() * CHR_ROM_BANK_SIZE;
+	}
+
+	// The handler is called after the mapper switched prg banks, the bus maps its rom pages again from getPrgPointer
+	void setPrgBankSwitchHandler(std::function<void()> handler)
+	{
+		_prgBankSwitchHandler = std::move(handler);
+	}
+
+	// The handler is called after the mapper switched the chr banks of a ppu address range, the ppu drops the tiles it decoded there
+	void setChrBankSwitchHandler(std::function<void(uint16_t address, uint16_t size)> handler)
+	{
+		_chrBankSwitchHandler = std::move(handler);
+	}
+
 	virtual ~Mapper() = default;
 protected:
+	// Mappers that switch prg banks call this after every switch
+	void prgBanksSwitched()
+	{
+		if (_prgBankSwitchHandler)
+		{
+			_prgBankSwitchHandler();
+		}
+	}
+
+	// Mappers that switch chr banks call this after every switch with the ppu addresses the switched banks cover
+	void chrBanksSwitched(uint16_t address, uint16_t size)
+	{
+		if (_chrBankSwitchHandler)
+		{
+			_chrBankSwitchHandler(address, size);
+		}
+	}
+
+	std::function<void()> _prgBankSwitchHandler;
+	std::function<void(uint16_t address, uint16_t size)> _chrBankSwitchHandler;
     // In my emulator i will implemnt all rom as read only until i will need to change that
     PrgRomBankMapper _prgRomBankVector;
     ChrRomBankMapper _chrRomBankVector;
@@ -16,5 +16,10 @@ public:
 	bool ppuWriteMap(uint16_t address, uint8_t data) override;
 	bool ppuReadMap(uint16_t address, uint8_t& data) override;
 
+	int32_t getPrgBankId(uint16_t address) override;
+	const uint8_t* getPrgPointer(uint16_t address) override;
+	int32_t getPrgRomOffset(uint16_t address) override;
+	int32_t getChrRomOffset(uint16_t address) override;
+
 	~Mapper0() = default;
 };
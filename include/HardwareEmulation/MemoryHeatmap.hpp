@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Read, write and execute counters for every address of an address space
+// The cpu space is counted by the Bus and the ppu space by the Ppu, only in builds with MEMORY_HEATMAP
+class MemoryHeatmap
+{
+public:
+    MemoryHeatmap(uint32_t size);
+
+    void countRead(uint32_t address);
+    void countWrite(uint32_t address);
+    void countExecute(uint32_t address);
+
+    uint32_t getSize() const;
+    const std::vector<uint32_t>& getReads() const;
+    const std::vector<uint32_t>& getWrites() const;
+    const std::vector<uint32_t>& getExecutes() const;
+
+    // Called at the start of a frame to count a single frame
+    void reset();
+
+    // A line per address that was accessed: address,reads,writes,executes
+    void writeCsv(std::ostream& stream) const;
+    // A header followed by the reads, writes and executes arrays of every address
+    void writeBinary(std::ostream& stream) const;
+
+private:
+    static constexpr char BINARY_MAGIC[8] = {'N', 'E', 'S', 'H', 'E', 'A', 'T', '\0'};
+
+    struct BinaryHeader
+    {
+        char magic[8];
+        uint32_t size;
+        uint32_t counterSize;
+    };
+
+    std::vector<uint32_t> _reads;
+    std::vector<uint32_t> _writes;
+    std::vector<uint32_t> _executes;
+};
+
+// These are called for every memory access, they are defined in the header so they inline into the bus and the ppu
+
+inline void MemoryHeatmap::countRead(uint32_t address)
+{
+    _reads[address]++;
+}
+
+inline void MemoryHeatmap::countWrite(uint32_t address)
+{
+    _writes[address]++;
+}
+
+inline void MemoryHeatmap::countExecute(uint32_t address)
+{
+    _executes[address]++;
+}
@@ -12,12 +12,13 @@ class Nes
 public:
 	Nes();
 	void StartNesEmulation();
-	~Nes() = default;
+	~Nes();
 private:
 	void InsertNewCartridge(std::string file_path);
 	Bus _bus;
     WindowManager _wm;
 	std::thread _wmThread;
+	std::thread _disassemblyThread;
 	bool _runMasterClock;
 	std::shared_ptr<ScreenWindow> _screen;
 };
@@ -27,7 +27,8 @@ public:
         return instance;
     }
 
-    void DebugInstruction(const Cpu& cpu, uint8_t opcode, uint32_t index)
+    template <typename BusType, CpuVariant Variant>
+    void DebugInstruction(const Cpu<BusType, Variant>& cpu, uint8_t opcode, uint32_t index)
     {
         if (index > _cmp_vector.max_size())
         {
@@ -39,7 +40,7 @@ public:
             "   A:" + NumToHexStringConvertor::Convert(cpu._a, 2) +
             "   X:" + NumToHexStringConvertor::Convert(cpu._x, 2) +
             "   Y:" + NumToHexStringConvertor::Convert(cpu._y, 2) +
-            "   P:" + NumToHexStringConvertor::Convert(cpu._p | cpu.RESERVED_FLAG_MASK, 2) +
+            "   P:" + NumToHexStringConvertor::Convert(cpu.getStatus() | cpu.RESERVED_FLAG_MASK, 2) +
             "   SP:" + NumToHexStringConvertor::Convert(cpu._sp, 2);
         if (!StringComperator(opcode, index, str))
         {
@@ -1,34 +1,67 @@
 #pragma once
 
-#include <functional>
+#include <array>
 #include <cstdint>
 #include <span>
 #include <vector>
 
+#include "BusInterface.hpp"
+#include "MemoryHeatmap.hpp"
+
+template <typename BusType>
 class Ppu
 {
 public:
-    using WriteFunction = std::function<bool (uint16_t address, uint8_t data)>;
-    using ReadFunction = std::function<bool (uint16_t address, uint8_t& data)>;
-
-    Ppu(WriteFunction bus_write, ReadFunction bus_read);
+    // The constraint lives on the constructor so Ppu<Bus> can be a member of the still incomplete Bus class
+    Ppu(BusType& bus) requires PpuBus<BusType>;
 
     void writeToRegister(uint16_t address, uint8_t data);
     uint8_t readFromRegister(uint16_t address);
 
     void executeCycle();
+    void executeCycles(uint32_t cycles);
 
+    // The $4014 dma, the page is written to the oam starting at the oam address like 256 writes to $2004
+    void writeOam(std::span<const uint8_t, 0x100> page);
+    std::span<const uint8_t> getOam() const;
+
+    // Only used on buses without an interrupt controller, see InterruptBus
     bool getNmiStatus();
     void clearNmiStatus();
 
+    // The scanline in the high 16 bits and the cycle in the low 16 bits
+    uint32_t getPosition() const;
+    // Where the ppu is after running the cycles from a position, negative cycles go back
+    static uint32_t positionAfter(uint32_t position, int64_t cycles);
+
+    // A lower bound of the cycles that run before the ppu can raise an nmi by itself
+    uint32_t cyclesUntilNmi() const;
+
+    // A lower bound of the cycles that run before the status register can change by itself
+    uint32_t cyclesUntilStatusChange() const;
+
     void setMirroringMode(uint8_t mode);
 
+    // The visible dots of a scanline are drawn in one pass when the line ends, a register access in the middle of the line
+    // runs the dots that already passed one at a time and the rest of the line stays on that path
+    // The switch is there for accuracy testing, builds with MEMORY_HEATMAP always draw a dot at a time
+    void setScanlineRendererEnabled(bool enabled);
+
+    // Drops the decoded tiles of a pattern table range, the bus calls it when the chr mapped there changes without a ppu write
+    // like a cartridge swap or a chr bank switch
+    void invalidateTiles(uint16_t address, uint16_t size);
+
     void reset();
 
     std::span<const uint32_t> getPalette();
     std::array<std::array<uint32_t, 0x4000>, 2> getPatternTable(uint8_t paletteId);
     std::array<uint32_t, 4> getWorkPaletteRgb(uint8_t paletteId);
     std::span<const uint32_t> getScreen();
+
+    #ifdef MEMORY_HEATMAP
+    // Every read and write of the ppu address space, including the ones of the debug views
+    MemoryHeatmap& getHeatmap();
+    #endif // MEMORY_HEATMAP
 private:
     static constexpr uint8_t PPU_CTRL_OFFSET = 0; // W
     static constexpr uint8_t PPU_MASK_OFFSET = 1; // W
@@ -53,17 +86,25 @@ private:
 
     static constexpr uint16_t PPU_ATTRIBUTE_TABLE_OFFSET = 0x3c0; //WR
 
+    static constexpr uint32_t PPU_ADDRESS_SPACE_SIZE = 0x4000;
+
     using TilePlane = std::array<uint8_t, 8>;
     using Tile = std::array<TilePlane, 2>;
     using PatternSection = std::array<std::array<TilePlane, 2>, 256>;
     using PatternTable = std::array<PatternSection, 2>;
 
+    // The 8 rows of a tile with the pixels packed 2 bits each, the leftmost pixel in the high bits
+    using DecodedTile = std::array<uint16_t, 8>;
+
     using PaletteTable = std::array<uint32_t, 64>;
 
     using WorkPaletteSet = std::array<uint8_t, 32>;
 
     using NameTable = std::array<uint8_t, PPU_NAME_TABLE_SIZE>;
 
+    // The unused bits of the sprite attribute byte read back as 0
+    static constexpr uint8_t OAM_ATTRIBUTE_MASK = 0xe3;
+
     union PatternTableAddr
     {
         struct
@@ -97,18 +138,31 @@ private:
 
     uint8_t ppuRead(uint16_t address, bool active = true);
 
+    // A pattern table read that isn't counted by the heatmap, tiles are decoded through it
+    uint8_t patternRead(uint16_t address);
+    // The tile is decoded on its first use after it was invalidated
+    const DecodedTile& getDecodedTile(uint16_t tile);
+
     uint32_t getRgbForPixel(uint8_t paletteId, uint8_t pixelValue);
 
     void progressNt();
 
     void fetchNextTile();
     void fetchNextTileAttribute();
+    // The low plane address of the current row of the tile in _ntByte, both fetch paths build it here
+    PatternTableAddr patternAddress() const;
     void fetchPatternForTile(bool isLow);
+    // Both fetches of the tile's row at once, returns the decoded row
+    uint16_t fetchTileRow();
     void updateShiftRegisters();
     void progressX();
     void progressY();
     void activeCycleSwitch();
     void renderPixelsToScreen();
+    // Runs the dots of the deferred line that already passed one at a time
+    void runDeferredDots();
+    // Runs dots 1-256 of the deferred line at once
+    void renderScanline();
 
     // registers
     union
@@ -164,17 +218,25 @@ private:
 
     int16_t _cycle;
     int16_t _scanLine;
+    bool _scanlineRendererEnabled;
+    // The visible dots of the current line haven't run yet
+    bool _lineDeferred;
     bool _nmi;
     bool _oddFrame;
 
     PatternTable _patternTable;
+    // Indexed by the pattern table address / 16
+    std::array<DecodedTile, 0x200> _decodedTiles;
+    std::array<bool, 0x200> _decodedTileValid;
     PaletteTable _paletteTable;
     std::array<NameTable, 2> _internalNameTableMem;
 
     WorkPaletteSet _workPaletteSet;
 
-    WriteFunction _busWrite;
-    ReadFunction _busRead;
+    std::array<uint8_t, 0x100> _oam;
+    uint8_t _oamAddr;
+
+    BusType& _bus;
 
     bool _ignoreCtrlFlagW;
     uint8_t _mirroringMode;
@@ -190,4 +252,8 @@ private:
     uint16_t _hiAtShift;
 
     std::array<uint32_t, 0xf000> _screen;
+
+    #ifdef MEMORY_HEATMAP
+    MemoryHeatmap _heatmap = MemoryHeatmap(PPU_ADDRESS_SPACE_SIZE);
+    #endif // MEMORY_HEATMAP
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// The comparisons a search narrows its candidates with
+// EQUAL and NOT_EQUAL compare the newer snapshot with the operand, the rest compare the newer snapshot with the older one
+// INCREASED_BY and DECREASED_BY wrap around like the 8 bit counters of the games
+enum class SearchFilter : uint8_t
+{
+    EQUAL,
+    NOT_EQUAL,
+    CHANGED,
+    UNCHANGED,
+    INCREASED,
+    DECREASED,
+    INCREASED_BY,
+    DECREASED_BY
+};
+
+// Finds the addresses that hold a value like the lives or a timer from snapshots of the memory taken every frame
+// Every address starts as a candidate and the filters remove the ones that don't match, 16 addresses at a time
+class RamSearch
+{
+public:
+    RamSearch(uint32_t size);
+
+    // Appends a snapshot, the memory must be the size the search was created with
+    void capture(std::span<const uint8_t> memory);
+    uint32_t getSnapshotCount() const;
+    uint8_t getValue(uint32_t snapshot, uint32_t address) const;
+
+    // Keeps the candidates that match between two snapshots
+    void filter(SearchFilter filter, uint8_t operand, uint32_t older, uint32_t newer);
+    // Keeps the candidates that match between every snapshot and the one before it, EQUAL and NOT_EQUAL check every snapshot
+    void filterHistory(SearchFilter filter, uint8_t operand);
+
+    uint32_t getCandidateCount() const;
+    std::vector<uint32_t> getCandidates() const;
+
+    // Makes every address a candidate again, the snapshots are kept
+    void resetCandidates();
+    void clearSnapshots();
+
+private:
+    // The snapshots and the candidate mask are padded to whole vectors so the filters have no scalar tail
+    static constexpr uint32_t VECTOR_SIZE = 16;
+    static constexpr uint8_t CANDIDATE = 0xff;
+
+    const uint8_t* snapshot(uint32_t index) const;
+
+    uint32_t _size;
+    uint32_t _stride;
+    std::vector<uint8_t> _snapshots;
+    // CANDIDATE for every address that is still a candidate and 0 for the rest
+    std::vector<uint8_t> _candidates;
+};
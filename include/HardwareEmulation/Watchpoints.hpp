@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+// The cpu accesses a watchpoint can stop on, an opcode fetch is an execute access and not a read
+enum WatchAccess : uint8_t
+{
+    WATCH_READ = 0x01,
+    WATCH_WRITE = 0x02,
+    WATCH_EXECUTE = 0x04
+};
+
+struct Watchpoint
+{
+    uint16_t start;
+    uint16_t end; // inclusive
+    uint8_t accesses; // WatchAccess flags
+    std::optional<uint8_t> value; // when set only accesses of this value hit
+};
+
+// The watchpoints of the cpu address space, the bus only sends the accesses of the pages they cover here
+class Watchpoints
+{
+public:
+    // Called for every access that hits, the data is the value that was read or is about to be written
+    // The handler must not add or remove watchpoints
+    using HitHandler = std::function<void (const Watchpoint& watchpoint, uint16_t address, uint8_t data, WatchAccess access)>;
+
+    Watchpoints();
+
+    // Returns an id for remove
+    uint32_t add(const Watchpoint& watchpoint);
+    bool remove(uint32_t id);
+    void clear();
+    bool empty() const;
+
+    void setHitHandler(HitHandler handler);
+
+    // The WatchAccess flags of the watchpoints that cover some of the page
+    uint8_t getPageAccesses(uint32_t page) const;
+
+    void check(uint16_t address, uint8_t data, WatchAccess access) const;
+
+private:
+    struct Entry
+    {
+        uint32_t id;
+        Watchpoint watchpoint;
+    };
+
+    std::vector<Entry> _entries;
+    uint32_t _nextId;
+    HitHandler _hitHandler;
+};
@@ -0,0 +1,25 @@
+#pragma once 
+
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+// Keeps the joypad buttons held on the keyboard and reports every change
+// The state is set from the key events instead of toggled so an event that is handled twice changes nothing
+class JoypadInputHelper {
+public:
+    using ButtonsFunction = std::function<void (uint8_t)>;
+
+    using EventMapper = std::unordered_map<SDL_EventType, std::function<void (const SDL_Event& e)>>;
+
+    JoypadInputHelper(EventMapper& event_mapper, ButtonsFunction on_buttons_change);
+
+    void KeyHandler(const SDL_Event& e);
+
+    ~JoypadInputHelper() = default;
+private:
+    static uint8_t KeyToButton(SDL_Keycode key);
+
+    ButtonsFunction _on_buttons_change;
+    uint8_t _buttons;
+};
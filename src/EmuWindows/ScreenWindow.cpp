@@ -2,10 +2,11 @@
 #include "EmuWindows/ScreenWindow.hpp"
 #include "WindowUtilities/SdlColorHelper.hpp"
 
-ScreenWindow::ScreenWindow(std::span<const uint32_t> screenView) : 
+ScreenWindow::ScreenWindow(std::span<const uint32_t> screenView, JoypadInputHelper::ButtonsFunction onJoypadChange) : 
     _pixelTextureHelper(SCREEN_ROW_SIZE, SCREEN_COL_SIZE, PIXEL_SIZE),
     BaseWindow("ScreenWindow", {0,0, SCREEN_ROW_SIZE * PIXEL_SIZE, SCREEN_COL_SIZE * PIXEL_SIZE}, 0, COLOR_WHITE),
-    _screenView(std::move(screenView))
+    _screenView(std::move(screenView)),
+    _joypadInputHelper(_eventMapper, std::move(onJoypadChange))
 {
     _pixelTextureHelper.fillTexture(_screenView);
 }
@@ -34,6 +34,7 @@ void WindowManager::EmuWindowManagerEventLoop()
         switch (e.type)
         {
         case SDL_KEYDOWN:
+        case SDL_KEYUP:
             EventMapperHelper(e.key.windowID, e);
             break;
         case SDL_TEXTINPUT:
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <type_traits>
+
+#include "HardwareEmulation/Aot/CpuAot.hpp"
+#include "HardwareEmulation/Aot/RecompiledCode.hpp"
+#include "HardwareEmulation/Bus.hpp"
+
+// Recompiled code calls the Bus class directly so other buses never load a program
+template <typename BusType>
+static constexpr bool RECOMPILED_BUS = std::is_same_v<BusType, Bus>;
+
+template <typename BusType, CpuVariant Variant>
+CpuAot<BusType, Variant>::CpuAot(Cpu<BusType, Variant>& cpu) :
+    _cpu(cpu),
+    _functions(0x10000, nullptr)
+{
+    _program = nullptr;
+    _statistics = {};
+}
+
+template <typename BusType, CpuVariant Variant>
+bool CpuAot<BusType, Variant>::setProgram(const RecompiledProgram* program)
+{
+    _program = nullptr;
+    std::fill(_functions.begin(), _functions.end(), nullptr);
+    if (program == nullptr)
+    {
+        return true;
+    }
+    if constexpr (RECOMPILED_BUS<BusType>)
+    {
+        // The recompiled code indexes whole 16KB banks from cpuRomPointer, a patched page is only a 256 byte copy
+        // Adding a patch later unloads the program with the rest of the cached code
+        if (_cpu._bus.hasRomPatches() || RecompiledProgramRegistry::PrgChecksum(_cpu._bus) != program->prgChecksum)
+        {
+            return false;
+        }
+        for (const auto& block : program->blocks)
+        {
+            _functions[block.pc] = block.function;
+        }
+        _program = program;
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+bool CpuAot<BusType, Variant>::isLoaded() const
+{
+    return _program != nullptr;
+}
+
+template <typename BusType, CpuVariant Variant>
+uint32_t CpuAot<BusType, Variant>::run(uint32_t maxInstructions)
+{
+    if constexpr (RECOMPILED_BUS<BusType>)
+    {
+        // The recompiled code reads the rom and ram directly
+        if (!_cpu._bus.cpuCodeBypassAllowed())
+        {
+            return 0;
+        }
+    }
+    _statistics.runs++;
+    RecompiledFunction function = _functions[_cpu._pc];
+    if (function == nullptr)
+    {
+        _statistics.misses++;
+        return 0;
+    }
+    RecompiledContext context;
+    loadContext(context);
+    size_t loadedCycles = context.cycles;
+    context.maxInstructions = maxInstructions;
+    context.instructions = 0;
+    // Only the first instruction of a run reaches the bus, it sees the cpu cycles the interpreter would have counted by then
+    uint8_t firstInstructionCycles = 0;
+    if constexpr (RECOMPILED_BUS<BusType>)
+    {
+        firstInstructionCycles = Cpu<BusType, Variant>::getInstructionCycles(RecompiledCode::ReadRom(context, context.pc));
+    }
+    _cpu._cycles += firstInstructionCycles;
+    while (function != nullptr && function(context))
+    {
+        function = _functions[context.pc];
+    }
+    _cpu._cycles -= firstInstructionCycles;
+    if (context.instructions > 0)
+    {
+        // A device can stall the cpu during the first instruction of a run, the stall was added to the cpu directly
+        context.cycles += _cpu._cycles - loadedCycles;
+        storeContext(context);
+        _statistics.instructions += context.instructions;
+    }
+    return context.instructions;
+}
+
+template <typename BusType, CpuVariant Variant>
+typename CpuAot<BusType, Variant>::Statistics CpuAot<BusType, Variant>::getStatistics() const
+{
+    return _statistics;
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuAot<BusType, Variant>::loadContext(RecompiledContext& context)
+{
+    if constexpr (RECOMPILED_BUS<BusType>)
+    {
+        context.bus = &_cpu._bus;
+        context.ram = _cpu._bus.cpuRam().data();
+        context.prgBanks = {_cpu._bus.cpuRomPointer(0x8000), _cpu._bus.cpuRomPointer(0xc000)};
+    }
+    context.cycles = _cpu._cycles;
+    context.pc = _cpu._pc;
+    context.a = _cpu._a;
+    context.x = _cpu._x;
+    context.y = _cpu._y;
+    context.sp = _cpu._sp;
+    RecompiledCode::SetStatus(context, _cpu.getStatus());
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuAot<BusType, Variant>::storeContext(const RecompiledContext& context)
+{
+    _cpu._cycles = context.cycles;
+    _cpu._pc = context.pc;
+    _cpu._a = context.a;
+    _cpu._x = context.x;
+    _cpu._y = context.y;
+    _cpu._sp = context.sp;
+    _cpu.setStatus(RecompiledCode::GetStatus(context));
+}
+
+template class CpuAot<Bus, Ricoh2A03>;
+template class CpuAot<FunctionalCpuBus, Ricoh2A03>;
+template class CpuAot<FunctionalCpuBus, Mos6502>;
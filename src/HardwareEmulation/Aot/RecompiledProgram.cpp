@@ -0,0 +1,39 @@
+#include <vector>
+
+#include "HardwareEmulation/Aot/RecompiledProgram.hpp"
+#include "HardwareEmulation/Bus.hpp"
+
+static std::vector<const RecompiledProgram*>& Programs()
+{
+    // A function local static so generated programs can register from their static initializers
+    static std::vector<const RecompiledProgram*> programs;
+    return programs;
+}
+
+bool RecompiledProgramRegistry::Register(const RecompiledProgram* program)
+{
+    Programs().push_back(program);
+    return true;
+}
+
+const RecompiledProgram* RecompiledProgramRegistry::Find(uint64_t prgChecksum)
+{
+    for (auto program : Programs())
+    {
+        if (program->prgChecksum == prgChecksum)
+        {
+            return program;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t RecompiledProgramRegistry::PrgChecksum(Bus& bus)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (uint32_t address = 0x8000; address <= 0xffff; address++)
+    {
+        hash = (hash ^ bus.cpuRead(address)) * 0x100000001b3;
+    }
+    return hash;
+}
@@ -1,14 +1,45 @@
+#include <algorithm>
 #include <iostream>
 
 #include "HardwareEmulation/Bus.hpp"
 
 Bus::Bus() : 
-    _cpu(std::bind(&Bus::cpuWrite, this, std::placeholders::_1, std::placeholders::_2), std::bind(&Bus::cpuRead, this, std::placeholders::_1)),
-    _ppu(std::bind(&Bus::ppuWrite, this, std::placeholders::_1, std::placeholders::_2), std::bind(&Bus::ppuRead, this, std::placeholders::_1, std::placeholders::_2))
+    _cpu(*this),
+    _ppu(*this)
 {
     std::fill(std::begin(_ram), std::end(_ram), 0);
-    _memoryMapper.emplace_front(phis_translation({0, RAM_MEMORY_RANGE, std::bind(&Bus::ramWrite, this, std::placeholders::_1, std::placeholders::_2), std::bind(&Bus::ramRead, this, std::placeholders::_1)}));
-    _memoryMapper.emplace_front(phis_translation({0x2000, 0x2000, std::bind(&Ppu::writeToRegister, &_ppu, std::placeholders::_1, std::placeholders::_2), std::bind(&Ppu::readFromRegister, &_ppu, std::placeholders::_1)}));
+    _clockCounter = 0;
+    _cpuIdleSlots = 0;
+    _cpuStallCycles = 0;
+    _ppuLagging = false;
+    _ppuSyncedCpuCycles = 0;
+    #ifdef CPU_TRACE
+    _traceAnchors = {};
+    _traceAnchorCount = 0;
+    #endif // CPU_TRACE
+    _codeDataLogging = false;
+    _loggedInstructionAddress = 0;
+    _loggedInstructionLength = 0;
+    std::fill(_watchedPages.begin(), _watchedPages.end(), 0);
+    std::fill(_pageRomOffsets.begin(), _pageRomOffsets.end(), -1);
+    for (uint32_t page = 0; page < PAGE_COUNT; page++)
+    {
+        uint32_t address = page << PAGE_SHIFT;
+        if (address < RAM_MEMORY_RANGE)
+        {
+            // The ram is mirrored every 0x800 bytes
+            _mappedPages[page] = {&_ram[address % TRUE_RAM_SIZE], &_ram[address % TRUE_RAM_SIZE], MmioHandler::OPEN_BUS};
+        }
+        else if (address < CARTRIDGE_START)
+        {
+            _mappedPages[page] = {nullptr, nullptr, MmioHandler::PPU_REGISTERS};
+        }
+        else
+        {
+            _mappedPages[page] = {nullptr, nullptr, (page == IO_REGISTERS_PAGE)? MmioHandler::IO_REGISTERS : MmioHandler::CARTRIDGE};
+        }
+        updatePage(page);
+    }
 }
 
 std::span<const uint8_t> Bus::getRamView() const
@@ -16,84 +47,503 @@ std::span<const uint8_t> Bus::getRamView() const
     return std::span<const uint8_t>(_ram.begin(), _ram.size());
 }
 
-void Bus::cpuWrite(uint16_t address, uint8_t data)
+void Bus::clock()
 {
-    if (_cartridge.get() != nullptr && _cartridge->cpuWrite(address, data))
+    _ppu.executeCycle();
+    if (_clockCounter % 3 == 0)
     {
-        
+        if (_cpuIdleSlots > 0)
+        {
+            _cpuIdleSlots--;
+        }
+        else if (_cpu.isCycleExact())
+        {
+            // A single bus cycle so the ppu sees every access at the dot it happens on
+            _cpu.cpuExecuteCycle();
+        }
+        else
+        {
+            // The cpu may run ahead as long as it can't miss an nmi or a change of the ppu status, the slots it ran ahead are skipped later
+            // Translated code exits before touching anything but ram so nothing else can observe it ran early
+            // An asserted irq has to be checked after every instruction since the cpu can clear the interrupt disable flag
+            anchorTrace();
+            InterruptController& interrupts = _cpu.getInterruptController();
+            uint32_t maxInstructions = (interrupts.isIrqAsserted())? 1 : _ppu.cyclesUntilStatusChange() / 3 + 1;
+            _cpuIdleSlots = _cpu.cpuExecuteInstructions(maxInstructions) - 1;
+        }
+        // A slot runs a single cycle of the cycle exact core or a whole instruction otherwise, a stall skips a slot per cycle either way
+        _cpuIdleSlots += _cpuStallCycles;
+        _cpuStallCycles = 0;
     }
-    else
+    _clockCounter++;
+}
+
+uint32_t Bus::clockBatch()
+{
+    if (_cpu.isCycleExact() || _cpuIdleSlots > 0 || _clockCounter % 3 != 0)
     {
-        for (auto &target : _memoryMapper)
-        {  
-            if (target.offset + target.size > address && address >= target.offset)
-            {
-                target.writeFunc(address, data);
-            }
-        }
+        // Only whole cpu slots are batched
+        clock();
+        return 1;
     }
+    uint32_t cycleBudget = std::min(_ppu.cyclesUntilStatusChange() / 3 + 1, MAX_BATCH_CYCLES);
+    anchorTrace();
+    // The budget counts the cycles the cpu was stalled for so the ppu already runs them
+    uint32_t ppuCycles = _cpu.runFor(cycleBudget) * 3;
+    _cpuStallCycles = 0;
+    _ppu.executeCycles(ppuCycles);
+    _clockCounter += ppuCycles;
+    return ppuCycles;
 }
 
-uint8_t Bus::cpuRead(uint16_t address)
+uint32_t Bus::clockLazy()
 {
-    uint8_t data = 0;
-    if (_cartridge.get() != nullptr && _cartridge->cpuRead(address, data))
+    if (_cpu.isCycleExact() || _cpuIdleSlots > 0 || _clockCounter % 3 != 0)
     {
+        clock();
+        return 1;
     }
-    else
+    uint32_t cycleBudget = _ppu.cyclesUntilStatusChange() / 3 + 1;
+    size_t start = _cpu.getCycles();
+    _ppuSyncedCpuCycles = start;
+    _ppuLagging = true;
+    anchorTrace();
+    // The budget counts the cycles the cpu was stalled for so the ppu runs them when it catches up
+    uint32_t ppuCycles = _cpu.runFor(cycleBudget) * 3;
+    catchUpPpu();
+    _ppuLagging = false;
+    _cpuStallCycles = 0;
+    _clockCounter += ppuCycles;
+    return ppuCycles;
+}
+
+void Bus::catchUpPpu()
+{
+    if (_ppuLagging)
     {
-        for (auto &target : _memoryMapper)
-        {  
-            if (target.offset + target.size > address && address >= target.offset)
-            {
-                return target.readFunc(address);
-            }
+        size_t cycles = _cpu.getCycles();
+        _ppu.executeCycles((cycles - _ppuSyncedCpuCycles) * 3);
+        _ppuSyncedCpuCycles = cycles;
+        anchorTrace();
+    }
+}
+
+Cpu<Bus>& Bus::getCpu()
+{
+    return _cpu;
+}
+
+Ppu<Bus>& Bus::getPpu()
+{
+    return _ppu;
+}
+
+Controller& Bus::getController(uint32_t port)
+{
+    return _controllers[port];
+}
+
+#ifdef MEMORY_HEATMAP
+
+MemoryHeatmap& Bus::getCpuHeatmap()
+{
+    return _cpuHeatmap;
+}
+
+#endif // MEMORY_HEATMAP
+
+#ifdef CPU_TRACE
+
+bool Bus::writeTraceDump(const std::string& path)
+{
+    std::vector<TraceAnchor> anchors;
+    uint64_t anchorCount = std::min<uint64_t>(_traceAnchorCount, _traceAnchors.size());
+    for (uint64_t index = _traceAnchorCount - anchorCount; index < _traceAnchorCount; index++)
+    {
+        anchors.push_back(_traceAnchors[index & (_traceAnchors.size() - 1)]);
+    }
+    std::vector<TraceEntry> entries = _cpu.getTraceEntries();
+    for (TraceEntry& entry : entries)
+    {
+        if (anchors.empty())
+        {
+            break;
         }
+        auto next = std::upper_bound(anchors.begin(), anchors.end(), entry.cycle, [](uint64_t cycle, const TraceAnchor& anchor)
+        {
+            return cycle < anchor.cycles;
+        });
+        // Instructions older than every anchor are counted back from the oldest one
+        const TraceAnchor& anchor = (next == anchors.begin())? anchors.front() : *(next - 1);
+        int64_t cycles = static_cast<int64_t>(entry.cycle) - static_cast<int64_t>(anchor.cycles);
+        uint32_t position = Ppu<Bus>::positionAfter(anchor.position, cycles * 3);
+        entry.scanline = position >> 16;
+        entry.dot = position & 0xffff;
     }
-    return data;
+    return CpuTrace::WriteDump(path, entries, _ppu.getScreen());
+}
+
+#endif // CPU_TRACE
+
+uint32_t Bus::addWatchpoint(const Watchpoint& watchpoint)
+{
+    uint32_t id = _watchpoints.add(watchpoint);
+    updateWatchedPages();
+    return id;
+}
+
+bool Bus::removeWatchpoint(uint32_t id)
+{
+    if (!_watchpoints.remove(id))
+    {
+        return false;
+    }
+    updateWatchedPages();
+    return true;
+}
+
+void Bus::clearWatchpoints()
+{
+    _watchpoints.clear();
+    updateWatchedPages();
+}
+
+void Bus::setWatchpointHandler(Watchpoints::HitHandler handler)
+{
+    _watchpoints.setHitHandler(std::move(handler));
+}
+
+void Bus::setCodeDataLoggerEnabled(bool enabled)
+{
+    _codeDataLogging = enabled;
+    for (uint32_t page = 0; page < PAGE_COUNT; page++)
+    {
+        updatePage(page);
+    }
+    // Cached blocks, translated code and idle loops read the rom without the bus
+    _cpu.invalidateBlockCache();
+}
+
+CodeDataLogger& Bus::getCodeDataLogger()
+{
+    return _codeDataLogger;
+}
+
+bool Bus::addGameGenieCode(const std::string& code)
+{
+    RomPatch patch;
+    if (!Cheats::DecodeGameGenie(code, patch))
+    {
+        return false;
+    }
+    addRomPatch(patch);
+    return true;
+}
+
+void Bus::addRomPatch(const RomPatch& patch)
+{
+    _cheats.addRomPatch(patch);
+    updateRomPatches();
+}
+
+bool Bus::addRamFreeze(const RamFreeze& freeze)
+{
+    return _cheats.addRamFreeze(freeze);
+}
+
+bool Bus::hasRomPatches() const
+{
+    return _cheats.hasRomPatches();
+}
+
+void Bus::clearCheats()
+{
+    _cheats.clear();
+    updateRomPatches();
+}
+
+void Bus::vblankStarted()
+{
+    _cheats.applyRamFreezes(_ram);
 }
 
 void Bus::insertCartridge(std::fstream file)
 {
     _cartridge = std::make_shared<Cartridge>(std::move(file));
-    //_ppu.setMirroringMode(_cartridge->getMirroringMode());
-    _ppu.ConnectCartridge(_cartridge);
+    _cartridge->setPrgBankSwitchHandler(std::bind(&Bus::mapCartridgePages, this));
+    _cartridge->setChrBankSwitchHandler(std::bind(&Ppu<Bus>::invalidateTiles, &_ppu, std::placeholders::_1, std::placeholders::_2));
+    _ppu.setMirroringMode(_cartridge->getMirroringMode());
+    _ppu.invalidateTiles(0, PPU_PATTERN_TABLES_SIZE);
+    _codeDataLogger = CodeDataLogger(_cartridge->getPrgRomSize(), _cartridge->getChrRomSize());
+    mapCartridgePages();
+    _cpu.invalidateBlockCache();
 }
 
 void Bus::removeCartridge()
 {
     if (_cartridge.get() != nullptr)
     {
-        // The cartridge will alwase be at the front beacause it is loaded after the mmu construction and "hot swapable"
-        _memoryMapper.pop_front();
         _cartridge.reset();
+        _patchedPages.clear();
+        mapCartridgePages();
+        _ppu.invalidateTiles(0, PPU_PATTERN_TABLES_SIZE);
     }
 }
 
-void Bus::ramWrite(uint16_t address, uint8_t data)
+void Bus::mapCartridgePages()
 {
-    _ram[address % TRUE_RAM_SIZE] = data;
+    for (uint32_t page = CARTRIDGE_START >> PAGE_SHIFT; page < PAGE_COUNT; page++)
+    {
+        // The rom is read only so its writes still reach the mapper, they are how it switches banks
+        const uint8_t* rom = (_cartridge.get() != nullptr)? _cartridge->getPrgPointer(page << PAGE_SHIFT) : nullptr;
+        if (rom != nullptr && _cheats.isPagePatched(page))
+        {
+            rom = patchedPage(page, rom);
+        }
+        _mappedPages[page].read = rom;
+        _pageRomOffsets[page] = (_cartridge.get() != nullptr)? _cartridge->getPrgRomOffset(page << PAGE_SHIFT) : -1;
+        updatePage(page);
+    }
+}
+
+const uint8_t* Bus::patchedPage(uint32_t page, const uint8_t* rom)
+{
+    auto [iter, inserted] = _patchedPages.try_emplace({page, rom});
+    std::array<uint8_t, Cheats::PAGE_SIZE>& copy = iter->second;
+    if (inserted)
+    {
+        std::copy(rom, rom + Cheats::PAGE_SIZE, copy.begin());
+        _cheats.patchPage(page << PAGE_SHIFT, copy);
+    }
+    return copy.data();
+}
+
+void Bus::updateRomPatches()
+{
+    _patchedPages.clear();
+    mapCartridgePages();
+    // Cached blocks, translated and recompiled code were built from the rom before the patches changed
+    _cpu.invalidateBlockCache();
+}
+
+void Bus::updatePage(uint32_t page)
+{
+    const PageMapping& mapping = _mappedPages[page];
+    uint8_t watched = _watchedPages[page];
+    if (_codeDataLogging && _pageRomOffsets[page] >= 0)
+    {
+        watched |= WATCH_READ | WATCH_EXECUTE;
+    }
+    _readPages[page] = (watched & WATCH_READ)? nullptr : mapping.read;
+    _fetchPages[page] = (watched & WATCH_EXECUTE)? nullptr : mapping.read;
+    _writePages[page] = (watched & WATCH_WRITE)? nullptr : mapping.write;
+    _pageHandlers[page] = (watched != 0)? MmioHandler::WATCHPOINT : mapping.handler;
 }
 
-uint8_t Bus::ramRead(uint16_t address)
+void Bus::updateWatchedPages()
 {
-    return _ram[address % TRUE_RAM_SIZE];
+    for (uint32_t page = 0; page < PAGE_COUNT; page++)
+    {
+        _watchedPages[page] = _watchpoints.getPageAccesses(page);
+        updatePage(page);
+    }
+    // Cached blocks, translated code and idle loops were built while the pages they read weren't watched
+    _cpu.invalidateBlockCache();
 }
 
-bool Bus::ppuWrite(uint16_t address, uint8_t data)
+uint8_t Bus::mmioRead(uint16_t address)
 {
-    if (_cartridge.get() != nullptr && _cartridge->ppuWrite(address, data))
+    MmioHandler handler = _pageHandlers[address >> PAGE_SHIFT];
+    if (handler == MmioHandler::WATCHPOINT)
     {
-        return true;
+        return watchedRead(address, WATCH_READ);
     }
-    return false;
+    return deviceRead(address, handler);
 }
 
-bool Bus::ppuRead(uint16_t address, uint8_t& data)
+void Bus::mmioWrite(uint16_t address, uint8_t data)
 {
-    if (_cartridge.get() != nullptr && _cartridge->ppuRead(address, data))
+    MmioHandler handler = _pageHandlers[address >> PAGE_SHIFT];
+    if (handler == MmioHandler::WATCHPOINT)
     {
-        return true;
+        watchedWrite(address, data);
+        return;
     }
-    return false;
-}
\ No newline at end of file
+    deviceWrite(address, data, handler);
+}
+
+uint8_t Bus::deviceRead(uint16_t address, MmioHandler handler)
+{
+    uint8_t data = 0;
+    switch (handler)
+    {
+    case MmioHandler::PPU_REGISTERS:
+        catchUpPpu();
+        return _ppu.readFromRegister(address);
+    case MmioHandler::IO_REGISTERS:
+        if (address < IO_REGISTERS_END)
+        {
+            return ioRead(address);
+        }
+        [[fallthrough]];
+    case MmioHandler::CARTRIDGE:
+        if (_cartridge.get() != nullptr)
+        {
+            _cartridge->cpuRead(address, data);
+        }
+        return data;
+    default:
+        return data;
+    }
+}
+
+void Bus::deviceWrite(uint16_t address, uint8_t data, MmioHandler handler)
+{
+    switch (handler)
+    {
+    case MmioHandler::PPU_REGISTERS:
+        catchUpPpu();
+        _ppu.writeToRegister(address, data);
+        break;
+    case MmioHandler::IO_REGISTERS:
+        if (address < IO_REGISTERS_END)
+        {
+            ioWrite(address, data);
+            break;
+        }
+        [[fallthrough]];
+    case MmioHandler::CARTRIDGE:
+        if (_cartridge.get() != nullptr)
+        {
+            _cartridge->cpuWrite(address, data);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+uint8_t Bus::watchedRead(uint16_t address, WatchAccess access)
+{
+    // Fetches from pages without a pointer come here too, they are only checked when the page is watched
+    uint32_t page = address >> PAGE_SHIFT;
+    const PageMapping& mapping = _mappedPages[page];
+    uint8_t data = (mapping.read != nullptr)? mapping.read[address & PAGE_MASK] : deviceRead(address, mapping.handler);
+    if (_codeDataLogging && _pageRomOffsets[page] >= 0)
+    {
+        logRomAccess(address, data, access);
+    }
+    if (_watchedPages[page] & access)
+    {
+        _watchpoints.check(address, data, access);
+    }
+    return data;
+}
+
+void Bus::watchedWrite(uint16_t address, uint8_t data)
+{
+    uint32_t page = address >> PAGE_SHIFT;
+    const PageMapping& mapping = _mappedPages[page];
+    if (_watchedPages[page] & WATCH_WRITE)
+    {
+        _watchpoints.check(address, data, WATCH_WRITE);
+    }
+    if (mapping.write != nullptr)
+    {
+        mapping.write[address & PAGE_MASK] = data;
+    }
+    else
+    {
+        deviceWrite(address, data, mapping.handler);
+    }
+}
+
+void Bus::logRomAccess(uint16_t address, uint8_t data, WatchAccess access)
+{
+    uint32_t offset = _pageRomOffsets[address >> PAGE_SHIFT] + (address & PAGE_MASK);
+    if (access == WATCH_EXECUTE)
+    {
+        _codeDataLogger.logOpcode(offset, address);
+        _loggedInstructionAddress = address;
+        _loggedInstructionLength = Cpu<Bus>::getInstructionLength(data);
+        return;
+    }
+    uint16_t distance = address - _loggedInstructionAddress;
+    if (distance > 0 && distance < _loggedInstructionLength)
+    {
+        _codeDataLogger.logOperand(offset, address);
+    }
+    else
+    {
+        _codeDataLogger.logData(offset, address);
+    }
+}
+
+void Bus::logChrAccess(uint16_t address, CdlChrFlags access)
+{
+    int32_t offset = (_cartridge.get() != nullptr)? _cartridge->getChrRomOffset(address) : -1;
+    if (offset >= 0)
+    {
+        _codeDataLogger.logChr(offset, access);
+    }
+}
+
+uint8_t Bus::ioRead(uint16_t address)
+{
+    switch (address)
+    {
+    case JOYPAD1_ADDRESS:
+        return _controllers[0].read();
+    case JOYPAD2_ADDRESS:
+        return _controllers[1].read();
+    default:
+        // The apu isn't connected yet
+        return 0;
+    }
+}
+
+void Bus::ioWrite(uint16_t address, uint8_t data)
+{
+    switch (address)
+    {
+    case OAM_DMA_ADDRESS:
+        oamDma(data);
+        break;
+    case JOYPAD1_ADDRESS:
+        // Both ports share the strobe line
+        _controllers[0].write(data);
+        _controllers[1].write(data);
+        break;
+    default:
+        break;
+    }
+}
+
+void Bus::oamDma(uint8_t page)
+{
+    catchUpPpu();
+    const uint8_t* source = _readPages[page];
+    if (source != nullptr)
+    {
+        _ppu.writeOam(std::span<const uint8_t, 0x100>(source, 0x100));
+        #ifdef MEMORY_HEATMAP
+        for (uint32_t i = 0; i < 0x100; i++)
+        {
+            _cpuHeatmap.countRead((page << PAGE_SHIFT) | i);
+        }
+        #endif // MEMORY_HEATMAP
+    }
+    else
+    {
+        // Registers and watched pages are read a byte at a time like the dma does
+        std::array<uint8_t, 0x100> data;
+        for (uint32_t i = 0; i < data.size(); i++)
+        {
+            data[i] = cpuRead((page << PAGE_SHIFT) | i);
+        }
+        _ppu.writeOam(data);
+    }
+    uint32_t cycles = OAM_DMA_CYCLES + (_cpu.getCycles() & 1);
+    _cpu.stall(cycles);
+    _cpuStallCycles += cycles;
+}
@@ -61,6 +61,46 @@ bool Cartridge::ppuRead(uint16_t address, uint8_t& data)
     return _mapper->ppuReadMap(address, data);
 }
 
+int32_t Cartridge::getPrgBankId(uint16_t address)
+{
+    return _mapper->getPrgBankId(address);
+}
+
+const uint8_t* Cartridge::getPrgPointer(uint16_t address)
+{
+    return _mapper->getPrgPointer(address);
+}
+
+int32_t Cartridge::getPrgRomOffset(uint16_t address)
+{
+    return _mapper->getPrgRomOffset(address);
+}
+
+int32_t Cartridge::getChrRomOffset(uint16_t address)
+{
+    return _mapper->getChrRomOffset(address);
+}
+
+uint32_t Cartridge::getPrgRomSize()
+{
+    return _mapper->getPrgRomSize();
+}
+
+uint32_t Cartridge::getChrRomSize()
+{
+    return _mapper->getChrRomSize();
+}
+
+void Cartridge::setPrgBankSwitchHandler(std::function<void()> handler)
+{
+    _mapper->setPrgBankSwitchHandler(std::move(handler));
+}
+
+void Cartridge::setChrBankSwitchHandler(std::function<void(uint16_t address, uint16_t size)> handler)
+{
+    _mapper->setChrBankSwitchHandler(std::move(handler));
+}
+
 uint8_t Cartridge::getMirroringMode()
 {
     uint8_t mode;
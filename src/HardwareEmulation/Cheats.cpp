@@ -0,0 +1,93 @@
+#include <array>
+#include <algorithm>
+#include <cctype>
+
+#include "HardwareEmulation/Cheats.hpp"
+
+bool Cheats::DecodeGameGenie(const std::string& code, RomPatch& patch)
+{
+    if (code.size() != 6 && code.size() != 8)
+    {
+        return false;
+    }
+    std::array<uint8_t, 8> n = {};
+    for (size_t i = 0; i < code.size(); i++)
+    {
+        const char* letter = std::find(std::begin(GAME_GENIE_LETTERS), std::end(GAME_GENIE_LETTERS) - 1, std::toupper(code[i]));
+        if (letter == std::end(GAME_GENIE_LETTERS) - 1)
+        {
+            return false;
+        }
+        n[i] = letter - GAME_GENIE_LETTERS;
+    }
+    // Every letter is 4 bits and the bits of the address and the values are scrambled over them
+    patch.address = 0x8000 | ((n[3] & 7) << 12) | ((n[5] & 7) << 8) | ((n[4] & 8) << 8) | ((n[2] & 7) << 4) | ((n[1] & 8) << 4) |
+        (n[4] & 7) | (n[3] & 8);
+    patch.value = ((n[1] & 7) << 4) | ((n[0] & 8) << 4) | (n[0] & 7);
+    if (code.size() == 6)
+    {
+        patch.value |= n[5] & 8;
+        patch.compare.reset();
+    }
+    else
+    {
+        patch.value |= n[7] & 8;
+        patch.compare = ((n[7] & 7) << 4) | ((n[6] & 8) << 4) | (n[6] & 7) | (n[5] & 8);
+    }
+    return true;
+}
+
+void Cheats::addRomPatch(const RomPatch& patch)
+{
+    _romPatches.push_back(patch);
+}
+
+bool Cheats::addRamFreeze(const RamFreeze& freeze)
+{
+    if (freeze.address >= RAM_MEMORY_RANGE)
+    {
+        return false;
+    }
+    _ramFreezes.push_back(freeze);
+    return true;
+}
+
+void Cheats::clear()
+{
+    _romPatches.clear();
+    _ramFreezes.clear();
+}
+
+bool Cheats::hasRomPatches() const
+{
+    return !_romPatches.empty();
+}
+
+bool Cheats::isPagePatched(uint32_t page) const
+{
+    return std::any_of(_romPatches.begin(), _romPatches.end(), [page](const RomPatch& patch) { return (patch.address >> 8) == page; });
+}
+
+void Cheats::patchPage(uint16_t pageAddress, std::span<uint8_t, PAGE_SIZE> page) const
+{
+    for (const RomPatch& patch : _romPatches)
+    {
+        if ((patch.address & ~(PAGE_SIZE - 1)) != pageAddress)
+        {
+            continue;
+        }
+        uint8_t& data = page[patch.address & (PAGE_SIZE - 1)];
+        if (!patch.compare.has_value() || *patch.compare == data)
+        {
+            data = patch.value;
+        }
+    }
+}
+
+void Cheats::applyRamFreezes(std::span<uint8_t> ram) const
+{
+    for (const RamFreeze& freeze : _ramFreezes)
+    {
+        ram[freeze.address % ram.size()] = freeze.value;
+    }
+}
@@ -0,0 +1,38 @@
+#include <algorithm>
+
+#include "HardwareEmulation/CodeDataLogger.hpp"
+
+CodeDataLogger::CodeDataLogger(uint32_t prgSize, uint32_t chrSize) :
+    _prgFlags(prgSize, 0),
+    _chrFlags(chrSize, 0),
+    _opcodes((prgSize + 63) / 64, 0)
+{
+}
+
+bool CodeDataLogger::isOpcode(uint32_t offset) const
+{
+    return (_opcodes[offset / 64] >> (offset % 64)) & 1;
+}
+
+const std::vector<uint8_t>& CodeDataLogger::getPrgFlags() const
+{
+    return _prgFlags;
+}
+
+const std::vector<uint8_t>& CodeDataLogger::getChrFlags() const
+{
+    return _chrFlags;
+}
+
+void CodeDataLogger::reset()
+{
+    std::fill(_prgFlags.begin(), _prgFlags.end(), 0);
+    std::fill(_chrFlags.begin(), _chrFlags.end(), 0);
+    std::fill(_opcodes.begin(), _opcodes.end(), 0);
+}
+
+void CodeDataLogger::writeCdl(std::ostream& stream) const
+{
+    stream.write(reinterpret_cast<const char*>(_prgFlags.data()), _prgFlags.size());
+    stream.write(reinterpret_cast<const char*>(_chrFlags.data()), _chrFlags.size());
+}
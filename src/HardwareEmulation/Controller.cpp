@@ -0,0 +1,42 @@
+#include "HardwareEmulation/Controller.hpp"
+
+Controller::Controller() :
+    _buttons(0)
+{
+    reset();
+}
+
+void Controller::setButtons(uint8_t buttons)
+{
+    _buttons.store(buttons, std::memory_order_release);
+}
+
+void Controller::write(uint8_t data)
+{
+    // The shift register keeps reloading while the strobe is high, the state it holds is the one from when the strobe went low
+    bool strobe = data & 0x1;
+    if (_strobe || strobe)
+    {
+        _shiftRegister = _buttons.load(std::memory_order_acquire);
+    }
+    _strobe = strobe;
+}
+
+uint8_t Controller::read()
+{
+    if (_strobe)
+    {
+        _shiftRegister = _buttons.load(std::memory_order_acquire);
+        return OPEN_BUS_BITS | (_shiftRegister & BUTTON_A);
+    }
+    uint8_t data = OPEN_BUS_BITS | (_shiftRegister & 0x1);
+    // An official joypad reports 1 after the 8 buttons
+    _shiftRegister = (_shiftRegister >> 1) | 0x80;
+    return data;
+}
+
+void Controller::reset()
+{
+    _shiftRegister = 0;
+    _strobe = false;
+}
@@ -1,97 +1,19 @@
 #include "NumToHexStringConvertor.hpp"
 
+#include <algorithm>
+#include <initializer_list>
+#include <iomanip>
+#include <stdexcept>
+
 #include "HardwareEmulation/Cpu.hpp"
+#include "HardwareEmulation/Bus.hpp"
 
 #ifdef NESTEST_DEBUG
 #include "HardwareEmulation/NestestLogTester.hpp"
 #endif // NESTEST_DEBUG
 
-Cpu::Cpu(WriteFunction mmu_write, ReadFunction mmu_read) : 
-    _busWrite(std::move(mmu_write)),
-    _busRead(std::move(mmu_read)),
-    _addressModeMapper({
-        {AMode::ACCUM, std::bind(&Cpu::accumAddr, this)},
-        {AMode::IMM, std::bind(&Cpu::immAddr, this)},
-        {AMode::ABSOLUTE, std::bind(&Cpu::absoluteAddr, this)},
-        {AMode::ZP, std::bind(&Cpu::zpAddr, this)},
-        {AMode::I_ZP_X, std::bind(&Cpu::iZpXAddr, this)},
-        {AMode::I_ZP_Y, std::bind(&Cpu::iZpYAddr, this)},
-        {AMode::I_ABSOLUTE_X, std::bind(&Cpu::iAbsoluteAddrX, this)},
-        {AMode::I_ABSOLUTE_Y, std::bind(&Cpu::iAbsoluteAddrY, this)},
-        {AMode::IMPLIED, std::bind(&Cpu::impliedAddr, this)},
-        {AMode::RELATIVE, std::bind(&Cpu::relativeAddr, this)},
-        {AMode::I_INDIRECT, std::bind(&Cpu::iIndirectAddr, this)},
-        {AMode::INDIRECT_I, std::bind(&Cpu::indirectIAddr, this)},
-        {AMode::INDIRECT, std::bind(&Cpu::indirectAddr, this)}
-    }),
-    _instructionTypeMapper({
-        {IType::ADC, std::bind(&Cpu::Adc, this, std::placeholders::_1)},
-        {IType::AND, std::bind(&Cpu::And, this, std::placeholders::_1)},
-        {IType::ASL, std::bind(&Cpu::Asl, this, std::placeholders::_1)},
-        {IType::BCC, std::bind(&Cpu::Bcc, this, std::placeholders::_1)},
-        {IType::BCS, std::bind(&Cpu::Bcs, this, std::placeholders::_1)},
-        {IType::BEQ, std::bind(&Cpu::Beq, this, std::placeholders::_1)},
-        {IType::BIT, std::bind(&Cpu::Bit, this, std::placeholders::_1)},
-        {IType::BMI, std::bind(&Cpu::Bmi, this, std::placeholders::_1)},
-        {IType::BNE, std::bind(&Cpu::Bne, this, std::placeholders::_1)},
-        {IType::BPL, std::bind(&Cpu::Bpl, this, std::placeholders::_1)},
-        {IType::BRK, std::bind(&Cpu::Brk, this, std::placeholders::_1)},
-        {IType::BVC, std::bind(&Cpu::Bvc, this, std::placeholders::_1)},
-        {IType::BVS, std::bind(&Cpu::Bvs, this, std::placeholders::_1)},
-        {IType::CLC, std::bind(&Cpu::Clc, this, std::placeholders::_1)},
-        {IType::CLD, std::bind(&Cpu::Cld, this, std::placeholders::_1)},
-        {IType::CLI, std::bind(&Cpu::Cli, this, std::placeholders::_1)},
-        {IType::CLV, std::bind(&Cpu::Clv, this, std::placeholders::_1)},
-        {IType::CMP, std::bind(&Cpu::Cmp, this, std::placeholders::_1)},
-        {IType::CPX, std::bind(&Cpu::Cpx, this, std::placeholders::_1)},
-        {IType::CPY, std::bind(&Cpu::Cpy, this, std::placeholders::_1)},
-        {IType::DEC, std::bind(&Cpu::Dec, this, std::placeholders::_1)},
-        {IType::DEX, std::bind(&Cpu::Dex, this, std::placeholders::_1)},
-        {IType::DEY, std::bind(&Cpu::Dey, this, std::placeholders::_1)},
-        {IType::EOR, std::bind(&Cpu::Eor, this, std::placeholders::_1)},
-        {IType::INC, std::bind(&Cpu::Inc, this, std::placeholders::_1)},
-        {IType::INX, std::bind(&Cpu::Inx, this, std::placeholders::_1)},
-        {IType::INY, std::bind(&Cpu::Iny, this, std::placeholders::_1)},
-        {IType::JMP, std::bind(&Cpu::Jmp, this, std::placeholders::_1)},
-        {IType::JSR, std::bind(&Cpu::Jsr, this, std::placeholders::_1)},
-        {IType::LDA, std::bind(&Cpu::Lda, this, std::placeholders::_1)},
-        {IType::LDX, std::bind(&Cpu::Ldx, this, std::placeholders::_1)},
-        {IType::LDY, std::bind(&Cpu::Ldy, this, std::placeholders::_1)},
-        {IType::LSR, std::bind(&Cpu::Lsr, this, std::placeholders::_1)},
-        {IType::NOP, std::bind(&Cpu::Nop, this, std::placeholders::_1)},
-        {IType::ORA, std::bind(&Cpu::Ora, this, std::placeholders::_1)},
-        {IType::PHA, std::bind(&Cpu::Pha, this, std::placeholders::_1)},
-        {IType::PHP, std::bind(&Cpu::Php, this, std::placeholders::_1)},
-        {IType::PLA, std::bind(&Cpu::Pla, this, std::placeholders::_1)},
-        {IType::PLP, std::bind(&Cpu::Plp, this, std::placeholders::_1)},
-        {IType::ROL, std::bind(&Cpu::Rol, this, std::placeholders::_1)},
-        {IType::ROR, std::bind(&Cpu::Ror, this, std::placeholders::_1)},
-        {IType::RTI, std::bind(&Cpu::Rti, this, std::placeholders::_1)},
-        {IType::RTS, std::bind(&Cpu::Rts, this, std::placeholders::_1)},
-        {IType::SBC, std::bind(&Cpu::Sbc, this, std::placeholders::_1)},
-        {IType::SEC, std::bind(&Cpu::Sec, this, std::placeholders::_1)},
-        {IType::SED, std::bind(&Cpu::Sed, this, std::placeholders::_1)},
-        {IType::SEI, std::bind(&Cpu::Sei, this, std::placeholders::_1)},
-        {IType::STA, std::bind(&Cpu::Sta, this, std::placeholders::_1)},
-        {IType::STX, std::bind(&Cpu::Stx, this, std::placeholders::_1)},
-        {IType::STY, std::bind(&Cpu::Sty, this, std::placeholders::_1)},
-        {IType::TAX, std::bind(&Cpu::Tax, this, std::placeholders::_1)},
-        {IType::TAY, std::bind(&Cpu::Tay, this, std::placeholders::_1)},
-        {IType::TSX, std::bind(&Cpu::Tsx, this, std::placeholders::_1)},
-        {IType::TXA, std::bind(&Cpu::Txa, this, std::placeholders::_1)},
-        {IType::TXS, std::bind(&Cpu::Txs, this, std::placeholders::_1)},
-        {IType::TYA, std::bind(&Cpu::Tya, this, std::placeholders::_1)},
-        {IType::MIA, std::bind(&Cpu::Nop, this, std::placeholders::_1)}
-    }),
-    _irqVectorMap({
-        {IrqType::ABORT, std::pair<uint32_t,uint32_t>(ABORT_LSB, ABORT_MSB)},
-        {IrqType::COP, std::pair<uint32_t,uint32_t>(COP_LSB, COP_MSB)},
-        {IrqType::NORMAL_IRQ, std::pair<uint32_t,uint32_t>(NORMAL_IRQ_LSB, NORMAL_IRQ_MSB)},
-        {IrqType::BRK, std::pair<uint32_t,uint32_t>(BRK_LSB, BRK_MSB)},
-        {IrqType::NMI, std::pair<uint32_t,uint32_t>(NMI_LSB, NMI_MSB)},
-        {IrqType::RESET, std::pair<uint32_t,uint32_t>(RESET_LSB, RESET_MSB)},
-    }),
-    _opcodeVector({
+template <typename BusType, CpuVariant Variant>
+constexpr std::array<typename Cpu<BusType, Variant>::Instruction, 0x100> Cpu<BusType, Variant>::_opcodeVector = {{
         /*          0                                       1                                   2                                    3                               4                              5                                6                              7                               8                                  9                                       A                              B                                        C                                       D                                      E                                        F
 /*0*/   {IType::BRK, AMode::IMPLIED, 7},    {IType::ORA, AMode::I_INDIRECT, 6}, {IType::MIA, AMode::IMPLIED, 2},    {IType::MIA, AMode::I_INDIRECT, 2}, {IType::MIA, AMode::ZP, 3},     {IType::ORA, AMode::ZP, 3},     {IType::ASL, AMode::ZP, 5},     {IType::MIA, AMode::ZP, 5},     {IType::PHP, AMode::IMPLIED, 3}, {IType::ORA, AMode::IMM, 2},           {IType::ASL, AMode::ACCUM, 2}, {IType::MIA, AMode::IMM, 2},           {IType::MIA, AMode::ABSOLUTE, 4},       {IType::ORA, AMode::ABSOLUTE, 4},       {IType::ASL, AMode::ABSOLUTE, 6},       {IType::MIA, AMode::ABSOLUTE, 6},
 /*1*/   {IType::BPL, AMode::RELATIVE, 2},   {IType::ORA, AMode::INDIRECT_I, 5}, {IType::MIA, AMode::IMPLIED, 2},    {IType::MIA, AMode::INDIRECT_I, 8}, {IType::MIA, AMode::I_ZP_X, 4}, {IType::ORA, AMode::I_ZP_X, 4}, {IType::ASL, AMode::I_ZP_X, 6}, {IType::MIA, AMode::I_ZP_X, 6}, {IType::CLC, AMode::IMPLIED, 2}, {IType::ORA, AMode::I_ABSOLUTE_Y, 4},  {IType::MIA, AMode::IMPLIED, 2}, {IType::MIA, AMode::I_ABSOLUTE_Y, 7},  {IType::MIA, AMode::I_ABSOLUTE_X, 4},   {IType::ORA, AMode::I_ABSOLUTE_X, 4},   {IType::ASL, AMode::I_ABSOLUTE_X, 7},   {IType::MIA, AMode::I_ABSOLUTE_X, 7},
@@ -108,27 +30,1242 @@ Cpu::Cpu(WriteFunction mmu_write, ReadFunction mmu_read) :
 /*C*/   {IType::CPY, AMode::IMM, 2},        {IType::CMP, AMode::I_INDIRECT, 6}, {IType::MIA, AMode::IMM, 2},        {IType::MIA, AMode::I_INDIRECT, 8}, {IType::CPY, AMode::ZP, 3},     {IType::CMP, AMode::ZP, 3},     {IType::DEC, AMode::ZP, 5},     {IType::MIA, AMode::ZP, 5},     {IType::INY, AMode::IMPLIED, 2}, {IType::CMP, AMode::IMM, 2},           {IType::DEX, AMode::IMPLIED, 2}, {IType::MIA, AMode::IMM, 2},           {IType::CPY, AMode::ABSOLUTE, 4},       {IType::CMP, AMode::ABSOLUTE, 4},       {IType::DEC, AMode::ABSOLUTE, 6},       {IType::MIA, AMode::ABSOLUTE, 6},
 /*D*/   {IType::BNE, AMode::RELATIVE, 2},   {IType::CMP, AMode::INDIRECT_I, 5}, {IType::MIA, AMode::IMPLIED, 2},    {IType::MIA, AMode::INDIRECT_I, 8}, {IType::MIA, AMode::I_ZP_X, 4}, {IType::CMP, AMode::I_ZP_X, 4}, {IType::DEC, AMode::I_ZP_X, 6}, {IType::MIA, AMode::I_ZP_X, 6}, {IType::CLD, AMode::IMPLIED, 2}, {IType::CMP, AMode::I_ABSOLUTE_Y, 4},  {IType::MIA, AMode::IMPLIED, 2}, {IType::MIA, AMode::I_ABSOLUTE_Y, 7},  {IType::MIA, AMode::I_ABSOLUTE_X, 4},   {IType::CMP, AMode::I_ABSOLUTE_X, 4},   {IType::DEC, AMode::I_ABSOLUTE_X, 7},   {IType::MIA, AMode::I_ABSOLUTE_X, 7},
 /*E*/   {IType::CPX, AMode::IMM, 2},        {IType::SBC, AMode::I_INDIRECT, 6}, {IType::MIA, AMode::IMM, 2},        {IType::MIA, AMode::I_INDIRECT, 8}, {IType::CPX, AMode::ZP, 3},     {IType::SBC, AMode::ZP, 3},     {IType::INC, AMode::ZP, 5},     {IType::MIA, AMode::ZP, 5},     {IType::INX, AMode::IMPLIED, 2}, {IType::SBC, AMode::IMM, 2},           {IType::NOP, AMode::IMPLIED, 2}, {IType::MIA, AMode::IMM, 2},           {IType::CPX, AMode::ABSOLUTE, 4},       {IType::SBC, AMode::ABSOLUTE, 4},       {IType::INC, AMode::ABSOLUTE, 6},       {IType::MIA, AMode::ABSOLUTE, 6},
-/*F*/   {IType::BEQ, AMode::RELATIVE, 2},   {IType::SBC, AMode::INDIRECT_I, 6}, {IType::MIA, AMode::IMPLIED, 2},    {IType::MIA, AMode::INDIRECT_I, 8}, {IType::MIA, AMode::I_ZP_X, 4}, {IType::SBC, AMode::I_ZP_X, 4}, {IType::INC, AMode::I_ZP_X, 6}, {IType::MIA, AMode::I_ZP_X, 6}, {IType::SED, AMode::IMPLIED, 2}, {IType::SBC, AMode::I_ABSOLUTE_Y, 4},  {IType::MIA, AMode::IMPLIED, 2}, {IType::MIA, AMode::I_ABSOLUTE_Y, 7},  {IType::MIA, AMode::I_ABSOLUTE_X, 4},   {IType::SBC, AMode::I_ABSOLUTE_X, 4},   {IType::INC, AMode::I_ABSOLUTE_X, 7},   {IType::MIA, AMode::I_ABSOLUTE_X, 7}
-    })
+/*F*/   {IType::BEQ, AMode::RELATIVE, 2},   {IType::SBC, AMode::INDIRECT_I, 5}, {IType::MIA, AMode::IMPLIED, 2},    {IType::MIA, AMode::INDIRECT_I, 8}, {IType::MIA, AMode::I_ZP_X, 4}, {IType::SBC, AMode::I_ZP_X, 4}, {IType::INC, AMode::I_ZP_X, 6}, {IType::MIA, AMode::I_ZP_X, 6}, {IType::SED, AMode::IMPLIED, 2}, {IType::SBC, AMode::I_ABSOLUTE_Y, 4},  {IType::MIA, AMode::IMPLIED, 2}, {IType::MIA, AMode::I_ABSOLUTE_Y, 7},  {IType::MIA, AMode::I_ABSOLUTE_X, 4},   {IType::SBC, AMode::I_ABSOLUTE_X, 4},   {IType::INC, AMode::I_ABSOLUTE_X, 7},   {IType::MIA, AMode::I_ABSOLUTE_X, 7}
+}};
+
+template <typename BusType, CpuVariant Variant>
+constexpr uint8_t Cpu<BusType, Variant>::operandLength(AMode addrMode)
+{
+    switch (addrMode)
+    {
+    case AMode::ACCUM:
+    case AMode::IMPLIED:
+        return 0;
+    case AMode::ABSOLUTE:
+    case AMode::I_ABSOLUTE_X:
+    case AMode::I_ABSOLUTE_Y:
+    case AMode::INDIRECT:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::getInstructionLength(uint8_t opcode)
+{
+    return 1 + operandLength(_opcodeVector[opcode].addrMode);
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::getInstructionCycles(uint8_t opcode)
+{
+    return _opcodeVector[opcode].cycles;
+}
+
+template <typename BusType, CpuVariant Variant>
+template <bool fetch, size_t... opcodes>
+constexpr std::array<typename Cpu<BusType, Variant>::OpcodeHandler, 0x100> Cpu<BusType, Variant>::makeDispatchTable(std::index_sequence<opcodes...>)
+{
+    return {{&Cpu::executeOpcode<opcodes, fetch>...}};
+}
+
+template <typename BusType, CpuVariant Variant>
+constexpr std::array<typename Cpu<BusType, Variant>::OpcodeHandler, 0x100> Cpu<BusType, Variant>::_dispatchTable = Cpu<BusType, Variant>::makeDispatchTable<true>(std::make_index_sequence<0x100>{});
+
+template <typename BusType, CpuVariant Variant>
+constexpr std::array<typename Cpu<BusType, Variant>::OpcodeHandler, 0x100> Cpu<BusType, Variant>::_decodedDispatchTable = Cpu<BusType, Variant>::makeDispatchTable<false>(std::make_index_sequence<0x100>{});
+
+template <typename BusType, CpuVariant Variant>
+constexpr typename Cpu<BusType, Variant>::MicroProgram Cpu<BusType, Variant>::makeMicroProgram(Instruction instruction)
+{
+    MicroProgram program = {};
+    auto add = [&program](std::initializer_list<MicroOp> ops)
+    {
+        for (MicroOp op : ops)
+        {
+            program.ops[program.length++] = op;
+        }
+    };
+    enum class Access
+    {
+        READ,
+        WRITE,
+        RMW
+    };
+    Access access = Access::READ;
+    switch (instruction.type)
+    {
+    case IType::BCC:
+    case IType::BCS:
+    case IType::BEQ:
+    case IType::BMI:
+    case IType::BNE:
+    case IType::BPL:
+    case IType::BVC:
+    case IType::BVS:
+        add({MicroOp::FETCH_BRANCH_OFFSET, MicroOp::BRANCH_TAKEN, MicroOp::BRANCH_FIX_PAGE});
+        return program;
+    case IType::BRK:
+        add({MicroOp::SKIP_PADDING, MicroOp::PUSH_PC_HIGH, MicroOp::PUSH_PC_LOW, MicroOp::PUSH_STATUS_BREAK, MicroOp::READ_VECTOR_LOW, MicroOp::READ_VECTOR_HIGH});
+        return program;
+    case IType::JMP:
+        if (instruction.addrMode == AMode::INDIRECT)
+        {
+            add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::FETCH_ADDRESS_HIGH, MicroOp::READ_JUMP_POINTER_LOW, MicroOp::READ_JUMP_POINTER_HIGH});
+        }
+        else
+        {
+            add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::JUMP_ABSOLUTE});
+        }
+        return program;
+    case IType::JSR:
+        add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::DUMMY_READ_STACK, MicroOp::PUSH_PC_HIGH, MicroOp::PUSH_PC_LOW, MicroOp::JUMP_ABSOLUTE});
+        return program;
+    case IType::RTS:
+        add({MicroOp::DUMMY_READ_PC, MicroOp::DUMMY_READ_STACK, MicroOp::PULL_PC_LOW, MicroOp::PULL_PC_HIGH, MicroOp::INCREMENT_PC});
+        return program;
+    case IType::RTI:
+        add({MicroOp::DUMMY_READ_PC, MicroOp::DUMMY_READ_STACK, MicroOp::PULL_STATUS, MicroOp::PULL_PC_LOW, MicroOp::PULL_PC_HIGH});
+        return program;
+    case IType::PHA:
+        add({MicroOp::DUMMY_READ_PC, MicroOp::PUSH_A});
+        return program;
+    case IType::PHP:
+        add({MicroOp::DUMMY_READ_PC, MicroOp::PUSH_STATUS});
+        return program;
+    case IType::PLA:
+        add({MicroOp::DUMMY_READ_PC, MicroOp::DUMMY_READ_STACK, MicroOp::PULL_A});
+        return program;
+    case IType::PLP:
+        add({MicroOp::DUMMY_READ_PC, MicroOp::DUMMY_READ_STACK, MicroOp::PULL_STATUS});
+        return program;
+    case IType::STA:
+    case IType::STX:
+    case IType::STY:
+        access = Access::WRITE;
+        break;
+    case IType::ASL:
+    case IType::LSR:
+    case IType::ROL:
+    case IType::ROR:
+    case IType::INC:
+    case IType::DEC:
+        access = Access::RMW;
+        break;
+    default:
+        break;
+    }
+    switch (instruction.addrMode)
+    {
+    case AMode::ACCUM:
+    case AMode::IMPLIED:
+        add({MicroOp::DUMMY_READ_EXECUTE});
+        return program;
+    case AMode::IMM:
+        add({MicroOp::READ_IMMEDIATE_EXECUTE});
+        return program;
+    case AMode::ZP:
+        add({MicroOp::FETCH_ADDRESS_LOW});
+        break;
+    case AMode::I_ZP_X:
+        add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::ADD_X_ZP});
+        break;
+    case AMode::I_ZP_Y:
+        add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::ADD_Y_ZP});
+        break;
+    case AMode::ABSOLUTE:
+        add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::FETCH_ADDRESS_HIGH});
+        break;
+    case AMode::I_ABSOLUTE_X:
+        add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::FETCH_ADDRESS_HIGH_ADD_X});
+        break;
+    case AMode::I_ABSOLUTE_Y:
+        add({MicroOp::FETCH_ADDRESS_LOW, MicroOp::FETCH_ADDRESS_HIGH_ADD_Y});
+        break;
+    case AMode::I_INDIRECT:
+        add({MicroOp::FETCH_POINTER, MicroOp::ADD_X_POINTER, MicroOp::READ_POINTER_LOW, MicroOp::READ_POINTER_HIGH});
+        break;
+    case AMode::INDIRECT_I:
+        add({MicroOp::FETCH_POINTER, MicroOp::READ_POINTER_LOW, MicroOp::READ_POINTER_HIGH_ADD_Y});
+        break;
+    default:
+        // Relative and indirect addressing only belong to the instructions above
+        break;
+    }
+    bool indexed = instruction.addrMode == AMode::I_ABSOLUTE_X || instruction.addrMode == AMode::I_ABSOLUTE_Y ||
+        instruction.addrMode == AMode::INDIRECT_I;
+    if (access == Access::READ)
+    {
+        if (indexed)
+        {
+            add({MicroOp::READ_INDEXED});
+        }
+        add({MicroOp::READ_EXECUTE});
+    }
+    else
+    {
+        if (indexed)
+        {
+            add({MicroOp::DUMMY_READ_INDEXED});
+        }
+        if (access == Access::WRITE)
+        {
+            add({MicroOp::WRITE_REGISTER});
+        }
+        else
+        {
+            add({MicroOp::READ_DATA, MicroOp::DUMMY_WRITE_MODIFY, MicroOp::WRITE_DATA});
+        }
+    }
+    return program;
+}
+
+template <typename BusType, CpuVariant Variant>
+constexpr std::array<typename Cpu<BusType, Variant>::MicroProgram, 0x100> Cpu<BusType, Variant>::makeMicroPrograms()
+{
+    std::array<MicroProgram, 0x100> programs = {};
+    for (size_t opcode = 0; opcode < programs.size(); opcode++)
+    {
+        programs[opcode] = makeMicroProgram(_opcodeVector[opcode]);
+        if (!microProgramMatches(_opcodeVector[opcode], programs[opcode]))
+        {
+            throw std::logic_error("The micro-op program doesn't match the cycles of the opcode matrix");
+        }
+    }
+    return programs;
+}
+
+template <typename BusType, CpuVariant Variant>
+constexpr std::array<typename Cpu<BusType, Variant>::MicroProgram, 0x100> Cpu<BusType, Variant>::_microPrograms = Cpu<BusType, Variant>::makeMicroPrograms();
+
+template <typename BusType, CpuVariant Variant>
+constexpr typename Cpu<BusType, Variant>::MicroProgram Cpu<BusType, Variant>::_interruptProgram = {7, {MicroOp::DUMMY_READ_PC, MicroOp::DUMMY_READ_PC,
+    MicroOp::PUSH_PC_HIGH, MicroOp::PUSH_PC_LOW, MicroOp::PUSH_STATUS_INTERRUPT, MicroOp::READ_VECTOR_LOW, MicroOp::READ_VECTOR_HIGH}};
+
+template <typename BusType, CpuVariant Variant>
+constexpr bool Cpu<BusType, Variant>::microProgramMatches(Instruction instruction, const MicroProgram& program)
+{
+    // Illegal opcodes run as nops with the bus accesses of their addressing mode
+    if (instruction.type == IType::MIA)
+    {
+        return true;
+    }
+    uint32_t cycles = 1 + program.length;
+    // Taken branches and page crossings add the optional cycles at the end of the program
+    if (program.ops[0] == MicroOp::FETCH_BRANCH_OFFSET)
+    {
+        cycles -= 2;
+    }
+    else if (program.length >= 2 && program.ops[program.length - 2] == MicroOp::READ_INDEXED)
+    {
+        cycles -= 1;
+    }
+    return cycles == instruction.cycles;
+}
+
+template <typename BusType, CpuVariant Variant>
+template <size_t... opcodes>
+constexpr std::array<typename Cpu<BusType, Variant>::OpcodeHandler, 0x100> Cpu<BusType, Variant>::makeMicroOperationTable(std::index_sequence<opcodes...>)
+{
+    return {{&Cpu::executeMicroOperation<opcodes>...}};
+}
+
+template <typename BusType, CpuVariant Variant>
+constexpr std::array<typename Cpu<BusType, Variant>::OpcodeHandler, 0x100> Cpu<BusType, Variant>::_microOperationTable = Cpu<BusType, Variant>::makeMicroOperationTable(std::make_index_sequence<0x100>{});
+
+template <typename BusType, CpuVariant Variant>
+Cpu<BusType, Variant>::Cpu(BusType& bus) requires CpuBus<BusType> : 
+    _bus(bus),
+    _irqVectorMap({
+        {IrqType::NORMAL_IRQ, std::pair<uint32_t,uint32_t>(NORMAL_IRQ_LSB, NORMAL_IRQ_MSB)},
+        {IrqType::BRK, std::pair<uint32_t,uint32_t>(BRK_LSB, BRK_MSB)},
+        {IrqType::NMI, std::pair<uint32_t,uint32_t>(NMI_LSB, NMI_MSB)},
+        {IrqType::RESET, std::pair<uint32_t,uint32_t>(RESET_LSB, RESET_MSB)},
+    }),
+    _aot(*this)
+    #ifdef CPU_JIT
+    , _jit(*this)
+    #endif // CPU_JIT
+{
+    _loop_running = false;
+    _blockCacheEnabled = true;
+    _blockCacheHits = 0;
+    _blockCacheMisses = 0;
+    _currentBlock = nullptr;
+    _blockIndex = 0;
+    _idleLoopDetectionEnabled = true;
+    _jammed = false;
+    _cycleExact = false;
+    _microProgram = nullptr;
+    _microStep = 0;
+    _microOpcode = 0;
+    _microAddress = 0;
+    _microBase = 0;
+    _microPointer = 0;
+    _microData = 0;
+    _idleLoopProbe = {};
+    _idleLoopStatistics = {};
+    #ifdef CPU_STATISTICS
+    _executionStatistics = {};
+    _statisticsOpcode = 0;
+    #endif // CPU_STATISTICS
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::cpuExecuteInstruction()
+{
+    if (isCycleExact())
+    {
+        do
+        {
+            cpuExecuteCycle();
+        } while (_microProgram != nullptr);
+        return;
+    }
+    if (_interrupts.isPending() && takeInterrupt())
+    {
+        return;
+    }
+    executeInstruction();
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::executeInstruction()
+{
+    #ifdef NESTEST_DEBUG
+    static uint32_t index = 0;
+    #endif // NESTEST_DEBUG
+    #ifdef CPU_TRACE
+    // The record is built as a whole so the compiler can write it with a few wide stores
+    TraceRecord& trace = _trace.next();
+    #ifdef CPU_LAZY_FLAGS
+    trace = {_cycles, _pc, 0, 0, _a, _x, _y, _sp, _p, _lazyCarry, _lazyZero, _lazyOverflow, _lazyNegative};
+    #else
+    trace = {_cycles, _pc, 0, 0, _a, _x, _y, _sp, _p, 0, 0, 0, 0};
+    #endif // CPU_LAZY_FLAGS
+    #endif // CPU_TRACE
+    const DecodedInstruction* decoded = (_blockCacheEnabled)? nextDecodedInstruction() : nullptr;
+    uint8_t opcode = (decoded != nullptr)? decoded->opcode : cpuFetch(_pc++);
+    
+    #ifdef NESTEST_DEBUG
+    NestestLogTester::GetInstance()->DebugInstruction(*this, opcode, index);
+    index++;
+    #endif // NESTEST_DEBUG
+    #ifdef CPU_STATISTICS
+    _statisticsOpcode = opcode;
+    _executionStatistics.executions[opcode]++;
+    #endif // CPU_STATISTICS
+    if (decoded != nullptr)
+    {
+        _pc += decoded->length;
+        _operand = decoded->operand;
+        (this->*decoded->handler)();
+    }
+    else
+    {
+        (this->*_dispatchTable[opcode])();
+    }
+    #ifdef CPU_TRACE
+    // The operand is only known once the handler fetched it
+    trace.opcode = opcode;
+    trace.operand = _operand;
+    #endif // CPU_TRACE
+}
+
+template <typename BusType, CpuVariant Variant>
+uint32_t Cpu<BusType, Variant>::cpuExecuteInstructions(uint32_t maxInstructions)
+{
+    if (isCycleExact())
+    {
+        cpuExecuteInstruction();
+        return 1;
+    }
+    if (_interrupts.isPending() && takeInterrupt())
+    {
+        return 1;
+    }
+    if (_aot.isLoaded())
+    {
+        uint32_t instructions = _aot.run(maxInstructions);
+        if (instructions > 0)
+        {
+            return instructions;
+        }
+    }
+    #ifdef CPU_JIT
+    if (_jit.isEnabled())
+    {
+        uint32_t instructions = _jit.run(maxInstructions);
+        if (instructions > 0)
+        {
+            return instructions;
+        }
+    }
+    #endif // CPU_JIT
+    uint16_t pc = _pc;
+    executeInstruction();
+    if (_idleLoopDetectionEnabled)
+    {
+        return 1 + skipIdleLoop(pc, maxInstructions - 1);
+    }
+    return 1;
+}
+
+template <typename BusType, CpuVariant Variant>
+uint32_t Cpu<BusType, Variant>::runFor(uint32_t cycleBudget)
+{
+    size_t start = _cycles;
+    uint32_t maxInstructions = 0;
+    while (_cycles - start < cycleBudget)
+    {
+        // The instruction budget can't run past the cycle budget by more than an instruction
+        // It only counts down while it lasts so translated code and idle loops see a single window
+        if (maxInstructions == 0)
+        {
+            maxInstructions = std::max<uint32_t>((cycleBudget - (_cycles - start)) / MAX_INSTRUCTION_CYCLES, 1);
+        }
+        // An asserted irq is checked after every instruction since the cpu can clear the interrupt disable flag
+        uint32_t instructions = (_interrupts.isIrqAsserted())? 1 : maxInstructions;
+        maxInstructions -= std::min(cpuExecuteInstructions(instructions), maxInstructions);
+    }
+    return _cycles - start;
+}
+
+template <typename BusType, CpuVariant Variant>
+bool Cpu<BusType, Variant>::setJitEnabled([[maybe_unused]] bool enabled)
+{
+    #ifdef CPU_JIT
+    // Translated code has no decimal mode
+    if constexpr (JitBus<BusType> && !Variant::DECIMAL_MODE)
+    {
+        _jit.setEnabled(enabled);
+        return true;
+    }
+    #endif // CPU_JIT
+    return false;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setJitDifferentialMode([[maybe_unused]] bool enabled)
+{
+    #ifdef CPU_JIT
+    _jit.setDifferentialMode(enabled);
+    #endif // CPU_JIT
+}
+
+template <typename BusType, CpuVariant Variant>
+typename Cpu<BusType, Variant>::JitStatistics Cpu<BusType, Variant>::getJitStatistics() const
+{
+    #ifdef CPU_JIT
+    auto statistics = _jit.getStatistics();
+    return {statistics.translatedBlocks, statistics.instructions, statistics.mmioExits,
+        statistics.differentialChecks, statistics.differentialMismatches, statistics.codeSize};
+    #else
+    return {};
+    #endif // CPU_JIT
+}
+
+template <typename BusType, CpuVariant Variant>
+bool Cpu<BusType, Variant>::setRecompiledProgram(const RecompiledProgram* program)
+{
+    return _aot.setProgram(program);
+}
+
+template <typename BusType, CpuVariant Variant>
+typename Cpu<BusType, Variant>::RecompiledStatistics Cpu<BusType, Variant>::getRecompiledStatistics() const
+{
+    auto statistics = _aot.getStatistics();
+    return {statistics.runs, statistics.instructions, statistics.misses};
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setIdleLoopDetectionEnabled(bool enabled)
+{
+    _idleLoopDetectionEnabled = enabled;
+    _idleLoopProbe.active = false;
+}
+
+template <typename BusType, CpuVariant Variant>
+typename Cpu<BusType, Variant>::IdleLoopStatistics Cpu<BusType, Variant>::getIdleLoopStatistics() const
+{
+    return _idleLoopStatistics;
+}
+
+#ifdef CPU_STATISTICS
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::resetExecutionStatistics()
+{
+    _executionStatistics = {};
+}
+
+template <typename BusType, CpuVariant Variant>
+const typename Cpu<BusType, Variant>::ExecutionStatistics& Cpu<BusType, Variant>::getExecutionStatistics() const
+{
+    return _executionStatistics;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::writeExecutionReport(std::ostream& stream) const
+{
+    const ExecutionStatistics& statistics = _executionStatistics;
+    uint64_t total = 0;
+    std::vector<uint64_t> modeExecutions(_aModeNameMapper.size(), 0);
+    std::vector<uint64_t> modePageCrosses(_aModeNameMapper.size(), 0);
+    std::vector<uint16_t> opcodes;
+    for (uint16_t opcode = 0; opcode < 0x100; opcode++)
+    {
+        size_t mode = static_cast<size_t>(_opcodeVector[opcode].addrMode);
+        total += statistics.executions[opcode];
+        modeExecutions[mode] += statistics.executions[opcode];
+        modePageCrosses[mode] += statistics.pageCrosses[opcode];
+        if (statistics.executions[opcode] > 0)
+        {
+            opcodes.push_back(opcode);
+        }
+    }
+    std::stable_sort(opcodes.begin(), opcodes.end(), [&statistics](uint16_t first, uint16_t second)
+    {
+        return statistics.executions[first] > statistics.executions[second];
+    });
+    std::vector<size_t> modes(_aModeNameMapper.size());
+    for (size_t mode = 0; mode < modes.size(); mode++)
+    {
+        modes[mode] = mode;
+    }
+    std::stable_sort(modes.begin(), modes.end(), [&modeExecutions](size_t first, size_t second)
+    {
+        return modeExecutions[first] > modeExecutions[second];
+    });
+    auto share = [total](uint64_t count) { return (total > 0)? 100.0 * count / total : 0.0; };
+
+    stream << "Instructions: " << total << std::endl << std::endl;
+    stream << std::left << std::setw(8) << "Opcode" << std::setw(6) << "Type" << std::setw(14) << "Mode" << std::right << std::setw(14) << "Executions" <<
+        std::setw(9) << "Share" << std::setw(14) << "Page crosses" << std::setw(10) << "Taken" << std::setw(11) << "Not taken" << std::endl;
+    stream << std::fixed << std::setprecision(2);
+    for (uint16_t opcode : opcodes)
+    {
+        const Instruction& instruction = _opcodeVector[opcode];
+        stream << std::left << std::setw(8) << NumToHexStringConvertor::Convert(opcode, 2) << std::setw(6) << _iTypeNameMapper[static_cast<size_t>(instruction.type)] <<
+            std::setw(14) << _aModeNameMapper[static_cast<size_t>(instruction.addrMode)] << std::right << std::setw(14) << statistics.executions[opcode] <<
+            std::setw(8) << share(statistics.executions[opcode]) << "%" << std::setw(14) << statistics.pageCrosses[opcode];
+        if (instruction.addrMode == AMode::RELATIVE)
+        {
+            stream << std::setw(10) << statistics.branchesTaken[opcode] << std::setw(11) << statistics.executions[opcode] - statistics.branchesTaken[opcode];
+        }
+        stream << std::endl;
+    }
+    stream << std::endl;
+    stream << std::left << std::setw(14) << "Mode" << std::right << std::setw(14) << "Executions" << std::setw(9) << "Share" << std::setw(14) << "Page crosses" << std::endl;
+    for (size_t mode : modes)
+    {
+        if (modeExecutions[mode] == 0)
+        {
+            continue;
+        }
+        stream << std::left << std::setw(14) << _aModeNameMapper[mode] << std::right << std::setw(14) << modeExecutions[mode] <<
+            std::setw(8) << share(modeExecutions[mode]) << "%" << std::setw(14) << modePageCrosses[mode] << std::endl;
+    }
+    stream << std::defaultfloat;
+}
+
+#endif // CPU_STATISTICS
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setBlockCacheEnabled(bool enabled)
+{
+    _blockCacheEnabled = enabled;
+    invalidateBlockCache();
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::invalidateBlockCache()
+{
+    _blockCache.clear();
+    _currentBlock = nullptr;
+    _blockIndex = 0;
+    _idleLoopBodies.clear();
+    _idleLoopProbe.active = false;
+    // The rom changed so a recompiled program may not match it anymore
+    _aot.setProgram(nullptr);
+    #ifdef CPU_JIT
+    _jit.invalidate();
+    #endif // CPU_JIT
+}
+
+template <typename BusType, CpuVariant Variant>
+typename Cpu<BusType, Variant>::BlockCacheStatistics Cpu<BusType, Variant>::getBlockCacheStatistics() const
+{
+    return {_blockCacheHits, _blockCacheMisses, _blockCache.size()};
+}
+
+template <typename BusType, CpuVariant Variant>
+const typename Cpu<BusType, Variant>::DecodedInstruction* Cpu<BusType, Variant>::nextDecodedInstruction()
+{
+    if (_currentBlock != nullptr && _blockIndex < _currentBlock->instructions.size() &&
+        _currentBlock->instructions[_blockIndex].pc == _pc)
+    {
+        return &_currentBlock->instructions[_blockIndex++];
+    }
+    _currentBlock = nullptr;
+    _blockIndex = 0;
+    if constexpr (CodeBankBus<BusType>)
+    {
+        // Code that runs from ram (or anything that isn't rom) is never cached
+        if (!_bus.cpuCodeBypassAllowed())
+        {
+            return nullptr;
+        }
+        int32_t bank = _bus.cpuCodeBank(_pc);
+        if (bank < 0)
+        {
+            return nullptr;
+        }
+        uint32_t key = (static_cast<uint32_t>(bank) << 16) | _pc;
+        auto iter = _blockCache.find(key);
+        if (iter != _blockCache.end())
+        {
+            _blockCacheHits++;
+        }
+        else
+        {
+            _blockCacheMisses++;
+            iter = _blockCache.emplace(key, decodeBlock(_pc, bank)).first;
+        }
+        _currentBlock = &iter->second;
+        return &_currentBlock->instructions[_blockIndex++];
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+typename Cpu<BusType, Variant>::DecodedBlock Cpu<BusType, Variant>::decodeBlock(uint16_t pc, int32_t bank)
+{
+    DecodedBlock block = {bank, 0, {}};
+    bool endOfBlock = false;
+    while (!endOfBlock && block.instructions.size() < MAX_BLOCK_LENGTH)
+    {
+        DecodedInstruction decoded;
+        decoded.pc = pc;
+        decoded.opcode = cpuRead(pc);
+        const Instruction& instruction = _opcodeVector[decoded.opcode];
+        decoded.length = 1 + operandLength(instruction.addrMode);
+        decoded.operand = 0;
+        for (uint8_t i = 1; i < decoded.length; i++)
+        {
+            decoded.operand |= cpuRead(pc + i) << (8 * (i - 1));
+        }
+        decoded.handler = _decodedDispatchTable[decoded.opcode];
+        block.cycles += instruction.cycles;
+        block.instructions.push_back(decoded);
+        pc += decoded.length;
+        if constexpr (CodeBankBus<BusType>)
+        {
+            // The block stops at a bank boundary or when it runs off the end of the address space
+            endOfBlock = isControlFlow(instruction.type) || pc < decoded.pc || _bus.cpuCodeBank(pc) != bank;
+        }
+    }
+    return block;
+}
+
+template <typename BusType, CpuVariant Variant>
+uint32_t Cpu<BusType, Variant>::skipIdleLoop(uint16_t pc, uint32_t maxInstructions)
+{
+    IdleLoopProbe& probe = _idleLoopProbe;
+    if (probe.active)
+    {
+        if (pc < probe.start || pc > probe.end)
+        {
+            probe.active = false;
+        }
+        else
+        {
+            probe.instructions++;
+        }
+    }
+    if (_pc > pc)
+    {
+        return 0;
+    }
+    // The budget only counts down by one per instruction while no ppu status change passed since the state was taken
+    bool sameWindow = probe.budget == maxInstructions + probe.instructions;
+    if (probe.active && probe.start == _pc && probe.end == pc && sameWindow &&
+        probe.a == _a && probe.x == _x && probe.y == _y && probe.sp == _sp && probe.status == getStatus())
+    {
+        // Nothing the loop reads can change before the budget ends so every following iteration runs the same way
+        uint32_t iterations = maxInstructions / probe.instructions;
+        uint32_t instructions = iterations * probe.instructions;
+        size_t cycles = iterations * (_cycles - probe.cycles);
+        _cycles += cycles;
+        if (iterations > 0)
+        {
+            _idleLoopStatistics.fastForwards++;
+            _idleLoopStatistics.skippedInstructions += instructions;
+            _idleLoopStatistics.skippedCycles += cycles;
+        }
+        probe.cycles = _cycles;
+        probe.budget = maxInstructions - instructions;
+        probe.instructions = 0;
+        return instructions;
+    }
+    if (!(probe.active && probe.start == _pc && probe.end == pc) && !isIdleLoopBody(_pc, pc))
+    {
+        probe.active = false;
+        return 0;
+    }
+    probe = {true, _pc, pc, _a, _x, _y, _sp, getStatus(), _cycles, maxInstructions, 0};
+    return 0;
+}
+
+template <typename BusType, CpuVariant Variant>
+bool Cpu<BusType, Variant>::isIdleLoopBody(uint16_t start, uint16_t end)
+{
+    if constexpr (CodeBankBus<BusType>)
+    {
+        if (!_bus.cpuCodeBypassAllowed())
+        {
+            return false;
+        }
+        // Only rom code is checked since code in ram could be changed by the nmi handler
+        int32_t bank = _bus.cpuCodeBank(start);
+        if (bank < 0 || _bus.cpuCodeBank(end) != bank)
+        {
+            return false;
+        }
+        uint64_t key = (static_cast<uint64_t>(bank) << 32) | (static_cast<uint32_t>(start) << 16) | end;
+        auto iter = _idleLoopBodies.find(key);
+        if (iter != _idleLoopBodies.end())
+        {
+            return iter->second;
+        }
+        auto isRam = [](uint32_t address) { return address < 0x2000; };
+        auto isRom = [this](uint32_t address) { return address <= 0xffff && _bus.cpuCodeBank(address) >= 0; };
+        // Only the status register mirrors, reading it again doesn't change anything the loop can see until vblank
+        auto isPpuStatus = [](uint32_t address) { return address >= 0x2000 && address < 0x4000 && (address & 0x7) == 0x2; };
+        std::vector<uint16_t> instructionStarts;
+        std::vector<uint16_t> jumpTargets;
+        bool idle = true;
+        uint32_t pc = start;
+        while (idle && pc <= end)
+        {
+            const Instruction& instruction = _opcodeVector[cpuRead(pc)];
+            uint16_t operand = 0;
+            for (uint8_t i = 1; i <= operandLength(instruction.addrMode); i++)
+            {
+                operand |= cpuRead(pc + i) << (8 * (i - 1));
+            }
+            instructionStarts.push_back(pc);
+            switch (instruction.type)
+            {
+            case IType::LDA: case IType::LDX: case IType::LDY:
+            case IType::CMP: case IType::CPX: case IType::CPY:
+            case IType::BIT: case IType::AND: case IType::ORA: case IType::EOR:
+            case IType::ADC: case IType::SBC: case IType::NOP:
+                switch (instruction.addrMode)
+                {
+                case AMode::IMM:
+                case AMode::IMPLIED:
+                case AMode::ZP:
+                case AMode::I_ZP_X:
+                case AMode::I_ZP_Y:
+                    break;
+                case AMode::ABSOLUTE:
+                    idle = isRam(operand) || isRom(operand) || isPpuStatus(operand);
+                    break;
+                case AMode::I_ABSOLUTE_X:
+                case AMode::I_ABSOLUTE_Y:
+                    idle = (isRam(operand) && isRam(operand + 0xff)) || (isRom(operand) && isRom(operand + 0xff));
+                    break;
+                default:
+                    idle = false;
+                    break;
+                }
+                break;
+            // Instructions that change a register make the state differ between iterations so those loops are never skipped
+            case IType::TAX: case IType::TAY: case IType::TXA: case IType::TYA: case IType::TSX:
+            case IType::INX: case IType::INY: case IType::DEX: case IType::DEY:
+            case IType::CLC: case IType::SEC: case IType::CLV:
+                break;
+            case IType::BCC: case IType::BCS: case IType::BEQ: case IType::BMI:
+            case IType::BNE: case IType::BPL: case IType::BVC: case IType::BVS:
+                jumpTargets.push_back(pc + 2 + static_cast<int8_t>(operand));
+                break;
+            case IType::JMP:
+                idle = instruction.addrMode == AMode::ABSOLUTE;
+                jumpTargets.push_back(operand);
+                break;
+            default:
+                idle = false;
+                break;
+            }
+            if (pc == end)
+            {
+                break;
+            }
+            pc += 1 + operandLength(instruction.addrMode);
+        }
+        idle = idle && pc == end && instructionStarts.size() <= MAX_IDLE_LOOP_LENGTH;
+        // Jumps may leave the loop but a jump inside it has to land on an instruction that was checked
+        for (uint16_t target : jumpTargets)
+        {
+            if (target >= start && target <= end &&
+                std::find(instructionStarts.begin(), instructionStarts.end(), target) == instructionStarts.end())
+            {
+                idle = false;
+            }
+        }
+        _idleLoopBodies.emplace(key, idle);
+        return idle;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+constexpr bool Cpu<BusType, Variant>::isJamOpcode(uint8_t opcode)
+{
+    // $x2 opcodes other than the immediate nops at $82, $c2, $e2 and LDX #
+    return (opcode & 0x0f) == 0x02 && opcode != 0x82 && opcode != 0xa2 && opcode != 0xc2 && opcode != 0xe2;
+}
+
+template <typename BusType, CpuVariant Variant>
+constexpr bool Cpu<BusType, Variant>::isControlFlow(IType type)
+{
+    if (isBranch(type))
+    {
+        return true;
+    }
+    switch (type)
+    {
+    case IType::BRK:
+    case IType::JMP:
+    case IType::JSR:
+    case IType::RTI:
+    case IType::RTS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+template <size_t opcode, bool fetch>
+void Cpu<BusType, Variant>::executeOpcode()
+{
+    constexpr Instruction instruction = _opcodeVector[opcode];
+    constexpr AMode addrMode = instruction.addrMode;
+    if constexpr (fetch)
+    {
+        fetchOperand<addrMode>();
+    }
+    _cycles += instruction.cycles;
+    if constexpr (isJamOpcode(opcode))
+    {
+        jam();
+    }
+    else
+    {
+        executeOperation<instruction.type, addrMode>();
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::IType type, typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::executeOperation()
+{
+    if constexpr (type == IType::ADC) Adc<addrMode>();
+    else if constexpr (type == IType::AND) And<addrMode>();
+    else if constexpr (type == IType::ASL) Asl<addrMode>();
+    else if constexpr (type == IType::BCC) Bcc();
+    else if constexpr (type == IType::BCS) Bcs();
+    else if constexpr (type == IType::BEQ) Beq();
+    else if constexpr (type == IType::BIT) Bit<addrMode>();
+    else if constexpr (type == IType::BMI) Bmi();
+    else if constexpr (type == IType::BNE) Bne();
+    else if constexpr (type == IType::BPL) Bpl();
+    else if constexpr (type == IType::BRK) Brk();
+    else if constexpr (type == IType::BVC) Bvc();
+    else if constexpr (type == IType::BVS) Bvs();
+    else if constexpr (type == IType::CLC) Clc();
+    else if constexpr (type == IType::CLD) Cld();
+    else if constexpr (type == IType::CLI) Cli();
+    else if constexpr (type == IType::CLV) Clv();
+    else if constexpr (type == IType::CMP) Cmp<addrMode>();
+    else if constexpr (type == IType::CPX) Cpx<addrMode>();
+    else if constexpr (type == IType::CPY) Cpy<addrMode>();
+    else if constexpr (type == IType::DEC) Dec<addrMode>();
+    else if constexpr (type == IType::DEX) Dex();
+    else if constexpr (type == IType::DEY) Dey();
+    else if constexpr (type == IType::EOR) Eor<addrMode>();
+    else if constexpr (type == IType::INC) Inc<addrMode>();
+    else if constexpr (type == IType::INX) Inx();
+    else if constexpr (type == IType::INY) Iny();
+    else if constexpr (type == IType::JMP) Jmp<addrMode>();
+    else if constexpr (type == IType::JSR) Jsr<addrMode>();
+    else if constexpr (type == IType::LDA) Lda<addrMode>();
+    else if constexpr (type == IType::LDX) Ldx<addrMode>();
+    else if constexpr (type == IType::LDY) Ldy<addrMode>();
+    else if constexpr (type == IType::LSR) Lsr<addrMode>();
+    else if constexpr (type == IType::NOP) Nop<addrMode>();
+    else if constexpr (type == IType::ORA) Ora<addrMode>();
+    else if constexpr (type == IType::PHA) Pha();
+    else if constexpr (type == IType::PHP) Php();
+    else if constexpr (type == IType::PLA) Pla();
+    else if constexpr (type == IType::PLP) Plp();
+    else if constexpr (type == IType::ROL) Rol<addrMode>();
+    else if constexpr (type == IType::ROR) Ror<addrMode>();
+    else if constexpr (type == IType::RTI) Rti();
+    else if constexpr (type == IType::RTS) Rts();
+    else if constexpr (type == IType::SBC) Sbc<addrMode>();
+    else if constexpr (type == IType::SEC) Sec();
+    else if constexpr (type == IType::SED) Sed();
+    else if constexpr (type == IType::SEI) Sei();
+    else if constexpr (type == IType::STA) Sta<addrMode>();
+    else if constexpr (type == IType::STX) Stx<addrMode>();
+    else if constexpr (type == IType::STY) Sty<addrMode>();
+    else if constexpr (type == IType::TAX) Tax();
+    else if constexpr (type == IType::TAY) Tay();
+    else if constexpr (type == IType::TSX) Tsx();
+    else if constexpr (type == IType::TXA) Txa();
+    else if constexpr (type == IType::TXS) Txs();
+    else if constexpr (type == IType::TYA) Tya();
+    else Nop<addrMode>(); // MIA
+}
+
+template <typename BusType, CpuVariant Variant>
+template <size_t opcode>
+void Cpu<BusType, Variant>::executeMicroOperation()
+{
+    constexpr Instruction instruction = _opcodeVector[opcode];
+    constexpr MicroProgram program = makeMicroProgram(instruction);
+    constexpr MicroOp last = program.ops[program.length - 1];
+    if constexpr (isJamOpcode(opcode))
+    {
+        jam();
+    }
+    else if constexpr (last == MicroOp::DUMMY_READ_EXECUTE)
+    {
+        executeOperation<instruction.type, instruction.addrMode>();
+    }
+    else if constexpr (last == MicroOp::READ_EXECUTE || last == MicroOp::READ_IMMEDIATE_EXECUTE)
+    {
+        // The data was already read into the operand so the immediate version of the instruction does the rest
+        executeOperation<instruction.type, AMode::IMM>();
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setCycleExactEnabled(bool enabled)
+{
+    _cycleExact = enabled;
+}
+
+template <typename BusType, CpuVariant Variant>
+bool Cpu<BusType, Variant>::isCycleExact() const
+{
+    return _cycleExact || _microProgram != nullptr;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::cpuExecuteCycle()
+{
+    _cycles++;
+    if (_microProgram == nullptr)
+    {
+        if (_interrupts.takeNmi())
+        {
+            startInterrupt(IrqType::NMI);
+        }
+        else if (_interrupts.isIrqAsserted() && !getFlag(INTERRUPT_DISABLE_FLAG_MASK))
+        {
+            startInterrupt(IrqType::NORMAL_IRQ);
+        }
+        else
+        {
+            _microOpcode = cpuFetch(_pc++);
+            _microProgram = &_microPrograms[_microOpcode];
+            _microStep = 0;
+            #ifdef CPU_STATISTICS
+            _statisticsOpcode = _microOpcode;
+            _executionStatistics.executions[_microOpcode]++;
+            #endif // CPU_STATISTICS
+            return;
+        }
+    }
+    executeMicroOp(_microProgram->ops[_microStep++]);
+    if (_microStep >= _microProgram->length)
+    {
+        _microProgram = nullptr;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::startInterrupt(IrqType type)
+{
+    _microProgram = &_interruptProgram;
+    _microStep = 0;
+    _microAddress = _irqVectorMap[type].first;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::executeMicroOp(MicroOp op)
+{
+    switch (op)
+    {
+    case MicroOp::DUMMY_READ_PC:
+        cpuRead(_pc);
+        break;
+    case MicroOp::DUMMY_READ_STACK:
+        cpuRead(STACK_OFFSET + _sp);
+        break;
+    case MicroOp::SKIP_PADDING:
+        cpuRead(_pc++);
+        break;
+    case MicroOp::FETCH_ADDRESS_LOW:
+        _microAddress = cpuRead(_pc++);
+        break;
+    case MicroOp::FETCH_ADDRESS_HIGH:
+        _microAddress |= cpuRead(_pc++) << 8;
+        break;
+    case MicroOp::FETCH_ADDRESS_HIGH_ADD_X:
+        _microBase = _microAddress | (cpuRead(_pc++) << 8);
+        _microAddress = _microBase + _x;
+        break;
+    case MicroOp::FETCH_ADDRESS_HIGH_ADD_Y:
+        _microBase = _microAddress | (cpuRead(_pc++) << 8);
+        _microAddress = _microBase + _y;
+        break;
+    case MicroOp::ADD_X_ZP:
+        cpuRead(_microAddress);
+        _microAddress = (_microAddress + _x) & 0xff;
+        break;
+    case MicroOp::ADD_Y_ZP:
+        cpuRead(_microAddress);
+        _microAddress = (_microAddress + _y) & 0xff;
+        break;
+    case MicroOp::FETCH_POINTER:
+        _microPointer = cpuRead(_pc++);
+        break;
+    case MicroOp::ADD_X_POINTER:
+        cpuRead(_microPointer);
+        _microPointer += _x;
+        break;
+    case MicroOp::READ_POINTER_LOW:
+        _microAddress = cpuRead(_microPointer);
+        break;
+    case MicroOp::READ_POINTER_HIGH:
+        _microAddress |= cpuRead(static_cast<uint8_t>(_microPointer + 1)) << 8;
+        break;
+    case MicroOp::READ_POINTER_HIGH_ADD_Y:
+        _microBase = _microAddress | (cpuRead(static_cast<uint8_t>(_microPointer + 1)) << 8);
+        _microAddress = _microBase + _y;
+        break;
+    case MicroOp::READ_INDEXED:
+        if ((_microBase ^ _microAddress) & 0xff00)
+        {
+            cpuRead((_microBase & 0xff00) | (_microAddress & 0xff));
+            #ifdef CPU_STATISTICS
+            _executionStatistics.pageCrosses[_statisticsOpcode]++;
+            #endif // CPU_STATISTICS
+        }
+        else
+        {
+            // No page was crossed so this is the real read and the fix cycle is skipped
+            _operand = cpuRead(_microAddress);
+            (this->*_microOperationTable[_microOpcode])();
+            _microStep = _microProgram->length;
+        }
+        break;
+    case MicroOp::DUMMY_READ_INDEXED:
+        cpuRead((_microBase & 0xff00) | (_microAddress & 0xff));
+        break;
+    case MicroOp::READ_EXECUTE:
+        _operand = cpuRead(_microAddress);
+        (this->*_microOperationTable[_microOpcode])();
+        break;
+    case MicroOp::READ_IMMEDIATE_EXECUTE:
+        _operand = cpuRead(_pc++);
+        (this->*_microOperationTable[_microOpcode])();
+        break;
+    case MicroOp::DUMMY_READ_EXECUTE:
+        cpuRead(_pc);
+        (this->*_microOperationTable[_microOpcode])();
+        break;
+    case MicroOp::WRITE_REGISTER:
+        switch (_opcodeVector[_microOpcode].type)
+        {
+        case IType::STA:
+            cpuWrite(_microAddress, _a);
+            break;
+        case IType::STX:
+            cpuWrite(_microAddress, _x);
+            break;
+        default:
+            cpuWrite(_microAddress, _y);
+            break;
+        }
+        break;
+    case MicroOp::READ_DATA:
+        _microData = cpuRead(_microAddress);
+        break;
+    case MicroOp::DUMMY_WRITE_MODIFY:
+        cpuWrite(_microAddress, _microData);
+        _microData = modifyData(_opcodeVector[_microOpcode].type, _microData);
+        break;
+    case MicroOp::WRITE_DATA:
+        cpuWrite(_microAddress, _microData);
+        break;
+    case MicroOp::FETCH_BRANCH_OFFSET:
+        _operand = cpuRead(_pc++);
+        if (!branchCondition(_opcodeVector[_microOpcode].type))
+        {
+            _microStep = _microProgram->length;
+        }
+        break;
+    case MicroOp::BRANCH_TAKEN:
+        cpuRead(_pc);
+        _microAddress = relativeAddr();
+        #ifdef CPU_STATISTICS
+        _executionStatistics.branchesTaken[_statisticsOpcode]++;
+        #endif // CPU_STATISTICS
+        if (((_microAddress ^ _pc) & 0xff00) == 0)
+        {
+            _pc = _microAddress;
+            _microStep = _microProgram->length;
+        }
+        else
+        {
+            // The low byte is added first, the high byte is fixed in the next cycle
+            _pc = (_pc & 0xff00) | (_microAddress & 0xff);
+        }
+        break;
+    case MicroOp::BRANCH_FIX_PAGE:
+        cpuRead(_pc);
+        _pc = _microAddress;
+        #ifdef CPU_STATISTICS
+        _executionStatistics.pageCrosses[_statisticsOpcode]++;
+        #endif // CPU_STATISTICS
+        break;
+    case MicroOp::JUMP_ABSOLUTE:
+        _pc = _microAddress | (cpuRead(_pc) << 8);
+        break;
+    case MicroOp::READ_JUMP_POINTER_LOW:
+        _microData = cpuRead(_microAddress);
+        break;
+    case MicroOp::READ_JUMP_POINTER_HIGH:
+        // The same page wrap bug indirectAddr emulates
+        _pc = _microData | (cpuRead((_microAddress & 0xff00) | ((_microAddress + 1) & 0xff)) << 8);
+        break;
+    case MicroOp::PUSH_PC_HIGH:
+        cpuWrite(STACK_OFFSET + _sp--, (_pc >> 8) & 0xff);
+        break;
+    case MicroOp::PUSH_PC_LOW:
+        cpuWrite(STACK_OFFSET + _sp--, _pc & 0xff);
+        break;
+    case MicroOp::PUSH_A:
+        Pha();
+        break;
+    case MicroOp::PUSH_STATUS:
+        Php();
+        break;
+    case MicroOp::PUSH_STATUS_BREAK:
+        setFlag(INTERRUPT_DISABLE_FLAG_MASK, true);
+        cpuWrite(STACK_OFFSET + _sp--, getStatus() | BREAK_COMMAND_FLAG_MASK);
+        _microAddress = _irqVectorMap[IrqType::BRK].first;
+        break;
+    case MicroOp::PUSH_STATUS_INTERRUPT:
+        cpuWrite(STACK_OFFSET + _sp--, getStatus() | RESERVED_FLAG_MASK);
+        setFlag(INTERRUPT_DISABLE_FLAG_MASK, true);
+        break;
+    case MicroOp::PULL_A:
+        Pla();
+        break;
+    case MicroOp::PULL_STATUS:
+        Plp();
+        break;
+    case MicroOp::PULL_PC_LOW:
+        _pc = (_pc & 0xff00) | cpuRead(STACK_OFFSET + ++_sp);
+        break;
+    case MicroOp::PULL_PC_HIGH:
+        _pc = (_pc & 0x00ff) | (cpuRead(STACK_OFFSET + ++_sp) << 8);
+        break;
+    case MicroOp::INCREMENT_PC:
+        cpuRead(_pc++);
+        break;
+    case MicroOp::READ_VECTOR_LOW:
+        _microData = cpuRead(_microAddress);
+        break;
+    case MicroOp::READ_VECTOR_HIGH:
+        _pc = _microData | (cpuRead(_microAddress + 1) << 8);
+        break;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+bool Cpu<BusType, Variant>::branchCondition(IType type) const
 {
-    _loop_running = false;
+    switch (type)
+    {
+    case IType::BCC:
+        return !getFlag(CARRY_FLAG_MASK);
+    case IType::BCS:
+        return getFlag(CARRY_FLAG_MASK);
+    case IType::BEQ:
+        return getFlag(ZERO_FLAG_MASK);
+    case IType::BMI:
+        return getFlag(NEGATIVE_FLAG_MASK);
+    case IType::BNE:
+        return !getFlag(ZERO_FLAG_MASK);
+    case IType::BPL:
+        return !getFlag(NEGATIVE_FLAG_MASK);
+    case IType::BVC:
+        return !getFlag(OVERFLOW_FLAG_MASK);
+    default:
+        return getFlag(OVERFLOW_FLAG_MASK);
+    }
 }
 
-void Cpu::cpuExecuteInstruction()
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::modifyData(IType type, uint8_t data)
 {
-    #ifdef NESTEST_DEBUG
-    static uint32_t index = 0;
-    #endif // NESTEST_DEBUG
-    uint8_t opcode = cpuRead(_pc++);
-    
-    #ifdef NESTEST_DEBUG
-    NestestLogTester::GetInstance()->DebugInstruction(*this, opcode, index);
-    index++;
-    #endif // NESTEST_DEBUG
-    _instructionTypeMapper[_opcodeVector[opcode].type](_opcodeVector[opcode].addrMode);
+    uint8_t result;
+    switch (type)
+    {
+    case IType::ASL:
+        result = data << 1;
+        setCarry(data & 0x80);
+        break;
+    case IType::LSR:
+        result = data >> 1;
+        setCarry(data & 0x01);
+        break;
+    case IType::ROL:
+        result = (data << 1) | getFlag(CARRY_FLAG_MASK);
+        setCarry(data & 0x80);
+        break;
+    case IType::ROR:
+        result = (data >> 1) | (getFlag(CARRY_FLAG_MASK) << 7);
+        setCarry(data & 0x01);
+        break;
+    case IType::INC:
+        result = data + 1;
+        break;
+    default:
+        result = data - 1;
+        break;
+    }
+    setZeroNegative(result);
+    return result;
 }
 
-void Cpu::cpuReset()
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::cpuReset()
 {
     #ifdef NESTEST_DEBUG
     //_pc = 0xc000;
@@ -139,35 +1276,214 @@ void Cpu::cpuReset()
     _a = 0;
     _x = 0;
     _y = 0;
-    _p = INTERRUPT_DISABLE_FLAG_MASK;
+    setStatus(INTERRUPT_DISABLE_FLAG_MASK);
     _sp = 0xfd; // this is done to simulate the hacked stack insertions
     _cycles = 7;
+    _microProgram = nullptr;
+    _interrupts.reset();
+    _jammed = false;
+}
+
+template <typename BusType, CpuVariant Variant>
+InterruptController& Cpu<BusType, Variant>::getInterruptController()
+{
+    return _interrupts;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::stall(uint32_t cycles)
+{
+    _cycles += cycles;
+}
+
+template <typename BusType, CpuVariant Variant>
+size_t Cpu<BusType, Variant>::getCycles() const
+{
+    return _cycles;
+}
+
+template <typename BusType, CpuVariant Variant>
+typename Cpu<BusType, Variant>::Registers Cpu<BusType, Variant>::getRegisters() const
+{
+    return {_pc, _a, _x, _y, getStatus(), _sp};
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setJamHandler(std::function<void()> handler)
+{
+    _jamHandler = std::move(handler);
+}
+
+template <typename BusType, CpuVariant Variant>
+bool Cpu<BusType, Variant>::isJammed() const
+{
+    return _jammed;
 }
 
-void Cpu::Irq()
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::jam()
 {
-    if (!getFlag(INTERRUPT_DISABLE_FLAG_MASK))
+    // The opcode is fetched again and again
+    _pc--;
+    if (!_jammed)
     {
-        setFlag(INTERRUPT_DISABLE_FLAG_MASK, true);
-        cpuWrite(STACK_OFFSET + _sp--, (_pc >> 8) & 0xff);
-        cpuWrite(STACK_OFFSET + _sp--, _pc & 0xff);
-        cpuWrite(STACK_OFFSET + _sp--, _p | RESERVED_FLAG_MASK);
-        _pc = cpuRead(_irqVectorMap[IrqType::NORMAL_IRQ].first) | (cpuRead(_irqVectorMap[IrqType::NORMAL_IRQ].second) << 8);
-        _cycles += 7;
+        _jammed = true;
+        if (_jamHandler)
+        {
+            _jamHandler();
+        }
+    }
+}
+
+#ifdef CPU_TRACE
+
+template <typename BusType, CpuVariant Variant>
+std::vector<TraceEntry> Cpu<BusType, Variant>::getTraceEntries() const
+{
+    std::vector<TraceEntry> entries;
+    for (const TraceRecord& record : _trace.getRecords())
+    {
+        TraceEntry entry = {};
+        entry.cycle = record.cycle;
+        entry.pc = record.pc;
+        entry.operand = record.operand;
+        entry.opcode = record.opcode;
+        entry.a = record.a;
+        entry.x = record.x;
+        entry.y = record.y;
+        entry.sp = record.sp;
+        #ifdef CPU_LAZY_FLAGS
+        entry.status = composeStatus(record.p, record.lazyCarry, record.lazyZero, record.lazyOverflow, record.lazyNegative);
+        #else
+        entry.status = record.p;
+        #endif // CPU_LAZY_FLAGS
+        entries.push_back(entry);
     }
+    return entries;
 }
 
-void Cpu::Nmi()
+#endif // CPU_TRACE
+
+template <typename BusType, CpuVariant Variant>
+bool Cpu<BusType, Variant>::takeInterrupt()
+{
+    if (_interrupts.takeNmi())
+    {
+        interrupt(IrqType::NMI);
+        return true;
+    }
+    if (_interrupts.isIrqAsserted() && !getFlag(INTERRUPT_DISABLE_FLAG_MASK))
+    {
+        interrupt(IrqType::NORMAL_IRQ);
+        return true;
+    }
+    return false;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::interrupt(IrqType type)
 {
-    setFlag(INTERRUPT_DISABLE_FLAG_MASK, true);
     cpuWrite(STACK_OFFSET + _sp--, (_pc >> 8) & 0xff);
     cpuWrite(STACK_OFFSET + _sp--, _pc & 0xff);
-    cpuWrite(STACK_OFFSET + _sp--, _p | RESERVED_FLAG_MASK);
-    _pc = cpuRead(_irqVectorMap[IrqType::NMI].first) | (cpuRead(_irqVectorMap[IrqType::NMI].second) << 8);
+    cpuWrite(STACK_OFFSET + _sp--, getStatus() | RESERVED_FLAG_MASK);
+    setFlag(INTERRUPT_DISABLE_FLAG_MASK, true);
+    _pc = cpuRead(_irqVectorMap[type].first) | (cpuRead(_irqVectorMap[type].second) << 8);
     _cycles += 7;
 }
 
-void Cpu::setFlag(uint8_t flagMask, bool val)
+#ifdef CPU_LAZY_FLAGS
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setFlag(uint8_t flagMask, bool val)
+{
+    switch (flagMask)
+    {
+    case CARRY_FLAG_MASK:
+        _lazyCarry = val;
+        break;
+    case ZERO_FLAG_MASK:
+        _lazyZero = !val;
+        break;
+    case OVERFLOW_FLAG_MASK:
+        _lazyOverflow = (val)? 0x80 : 0;
+        break;
+    case NEGATIVE_FLAG_MASK:
+        _lazyNegative = (val)? 0x80 : 0;
+        break;
+    default:
+        _p = (val)? (_p | flagMask) : (_p & ~flagMask);
+        break;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::getFlag(uint8_t flagMask) const
+{
+    switch (flagMask)
+    {
+    case CARRY_FLAG_MASK:
+        return _lazyCarry;
+    case ZERO_FLAG_MASK:
+        return _lazyZero == 0;
+    case OVERFLOW_FLAG_MASK:
+        return _lazyOverflow >> 7;
+    case NEGATIVE_FLAG_MASK:
+        return _lazyNegative >> 7;
+    default:
+        return (_p & flagMask)? 1 : 0;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setZeroNegative(uint8_t zeroSource, uint8_t negativeSource)
+{
+    _lazyZero = zeroSource;
+    _lazyNegative = negativeSource;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setCarry(bool val)
+{
+    _lazyCarry = val;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setOverflow(uint8_t overflowSource)
+{
+    _lazyOverflow = overflowSource;
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::getStatus() const
+{
+    return composeStatus(_p, _lazyCarry, _lazyZero, _lazyOverflow, _lazyNegative);
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::composeStatus(uint8_t p, uint8_t lazyCarry, uint8_t lazyZero, uint8_t lazyOverflow, uint8_t lazyNegative)
+{
+    uint8_t status = p & ~(CARRY_FLAG_MASK | ZERO_FLAG_MASK | OVERFLOW_FLAG_MASK | NEGATIVE_FLAG_MASK);
+    status |= lazyCarry;
+    status |= (lazyZero == 0)? ZERO_FLAG_MASK : 0;
+    status |= (lazyOverflow & 0x80)? OVERFLOW_FLAG_MASK : 0;
+    status |= lazyNegative & NEGATIVE_FLAG_MASK;
+    return status;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setStatus(uint8_t status)
+{
+    _p = status & ~(BREAK_COMMAND_FLAG_MASK | RESERVED_FLAG_MASK);
+    _lazyCarry = status & CARRY_FLAG_MASK;
+    _lazyZero = !(status & ZERO_FLAG_MASK);
+    _lazyOverflow = (status & OVERFLOW_FLAG_MASK) << 1;
+    _lazyNegative = status & NEGATIVE_FLAG_MASK;
+}
+
+#else
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setFlag(uint8_t flagMask, bool val)
 {
     if (val)
     {
@@ -175,129 +1491,245 @@ void Cpu::setFlag(uint8_t flagMask, bool val)
     }
     else
     {
-        clearFlag(flagMask);
+        _p &= ~(flagMask);
     }
 }
 
-void Cpu::clearFlag(uint8_t flagMask)
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::getFlag(uint8_t flagMask) const
 {
-    _p &= ~(flagMask);
+    return (_p & flagMask)? 1 : 0;
 }
 
-uint8_t Cpu::getFlag(uint8_t flagMask)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setZeroNegative(uint8_t zeroSource, uint8_t negativeSource)
 {
-    return (_p & flagMask)? 1 : 0;
+    setFlag(ZERO_FLAG_MASK, !zeroSource);
+    setFlag(NEGATIVE_FLAG_MASK, negativeSource & 0x80);
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setCarry(bool val)
+{
+    setFlag(CARRY_FLAG_MASK, val);
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setOverflow(uint8_t overflowSource)
+{
+    setFlag(OVERFLOW_FLAG_MASK, overflowSource & 0x80);
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::getStatus() const
+{
+    return _p;
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setStatus(uint8_t status)
+{
+    _p = status & ~(BREAK_COMMAND_FLAG_MASK | RESERVED_FLAG_MASK);
 }
 
-void Cpu::cpuWrite(uint16_t address, uint8_t data)
+#endif // CPU_LAZY_FLAGS
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::setZeroNegative(uint8_t result)
+{
+    setZeroNegative(result, result);
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::clearFlag(uint8_t flagMask)
+{
+    setFlag(flagMask, false);
+}
+
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::cpuWrite(uint16_t address, uint8_t data)
+{
+    _bus.cpuWrite(address, data);
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::cpuRead(uint16_t address)
+{
+    return _bus.cpuRead(address);
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::cpuFetch(uint16_t address)
+{
+    if constexpr (FetchBus<BusType>)
+    {
+        return _bus.cpuFetch(address);
+    }
+    else
+    {
+        return cpuRead(address);
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::fetchOperand()
+{
+    constexpr uint8_t length = operandLength(addrMode);
+    if constexpr (length == 1)
+    {
+        _operand = cpuRead(_pc++);
+    }
+    else if constexpr (length == 2)
+    {
+        _operand = cpuRead(_pc++);
+        _operand |= cpuRead(_pc++) << 8;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+uint8_t Cpu<BusType, Variant>::readOperand()
 {
-    _busWrite(address, data);
+    if constexpr (addrMode == AMode::IMM)
+    {
+        return _operand & 0xff;
+    }
+    else
+    {
+        return cpuRead(resolveAddress<addrMode>());
+    }
 }
 
-uint8_t Cpu::cpuRead(uint16_t address)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode, bool pagePenalty>
+uint16_t Cpu<BusType, Variant>::resolveAddress()
 {
-    return _busRead(address);
+    if constexpr (addrMode == AMode::ACCUM) return accumAddr();
+    else if constexpr (addrMode == AMode::IMM) return immAddr();
+    else if constexpr (addrMode == AMode::ABSOLUTE) return absoluteAddr();
+    else if constexpr (addrMode == AMode::ZP) return zpAddr();
+    else if constexpr (addrMode == AMode::I_ZP_X) return iZpXAddr();
+    else if constexpr (addrMode == AMode::I_ZP_Y) return iZpYAddr();
+    else if constexpr (addrMode == AMode::I_ABSOLUTE_X) return iAbsoluteAddrX(pagePenalty);
+    else if constexpr (addrMode == AMode::I_ABSOLUTE_Y) return iAbsoluteAddrY(pagePenalty);
+    else if constexpr (addrMode == AMode::IMPLIED) return impliedAddr();
+    else if constexpr (addrMode == AMode::RELATIVE) return relativeAddr();
+    else if constexpr (addrMode == AMode::I_INDIRECT) return iIndirectAddr();
+    else if constexpr (addrMode == AMode::INDIRECT_I) return indirectIAddr(pagePenalty);
+    else return indirectAddr();
 }
 
-uint16_t Cpu::accumAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::accumAddr()
 {
     return 0;
 }
 
-uint16_t Cpu::immAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::immAddr()
 {
-    return _pc++;
+    // The immediate byte was already fetched as the operand, this is its address
+    return _pc - 1;
 }
 
-uint16_t Cpu::absoluteAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::absoluteAddr()
 {
-    uint16_t lo = cpuRead(_pc++);
-    uint16_t hi = cpuRead(_pc++);
-    return lo | (hi << 8);
+    return _operand;
 }
 
-uint16_t Cpu::zpAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::zpAddr()
 {
-    return cpuRead(_pc++);
+    return _operand;
 }
 
-uint16_t Cpu::iZpXAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::iZpXAddr()
 {
-    return (cpuRead(_pc++) + _x) & 0x00ff;
+    return (_operand + _x) & 0x00ff;
 }
 
-uint16_t Cpu::iZpYAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::iZpYAddr()
 {
-    return (cpuRead(_pc++) + _y) & 0x00ff;
+    return (_operand + _y) & 0x00ff;
 }
 
-uint16_t Cpu::iAbsoluteAddrX()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::iAbsoluteAddrX(bool pagePenalty)
 {
-    uint16_t lo = cpuRead(_pc++);
-    uint16_t hi = cpuRead(_pc++);
-    uint16_t addr = lo;
-    addr |= (hi << 8);
-    addr += _x;
-    if ((addr & 0xff00) != hi)
+    uint16_t addr = _operand + _x;
+    if (pagePenalty && (addr & 0xff00) != (_operand & 0xff00))
     {
         _cycles++;
+        #ifdef CPU_STATISTICS
+        _executionStatistics.pageCrosses[_statisticsOpcode]++;
+        #endif // CPU_STATISTICS
     }
     return addr;
 }
 
-uint16_t Cpu::iAbsoluteAddrY()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::iAbsoluteAddrY(bool pagePenalty)
 {
-    uint16_t lo = cpuRead(_pc++);
-    uint16_t hi = cpuRead(_pc++);
-    uint16_t addr = lo;
-    addr |= (hi << 8);
-    addr += _y;
-    if ((addr & 0xff00) != hi)
+    uint16_t addr = _operand + _y;
+    if (pagePenalty && (addr & 0xff00) != (_operand & 0xff00))
     {
         _cycles++;
+        #ifdef CPU_STATISTICS
+        _executionStatistics.pageCrosses[_statisticsOpcode]++;
+        #endif // CPU_STATISTICS
     }
     return addr;
 }
 
-uint16_t Cpu::impliedAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::impliedAddr()
 {
     return 0;
 }
 
-uint16_t Cpu::relativeAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::relativeAddr()
 {
-    int8_t offset = cpuRead(_pc++);
+    int8_t offset = _operand;
     return _pc + offset;
 }
 
-uint16_t Cpu::iIndirectAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::iIndirectAddr()
 {
-    uint16_t zpg_addr = cpuRead(_pc++);
+    uint16_t zpg_addr = _operand;
     uint16_t addr = 0;
     addr |= cpuRead((zpg_addr++ + _x) & 0xff)  & 0xff;
     addr |= (cpuRead((zpg_addr + _x) & 0xff) << 8);
     return addr;
 }
 
-uint16_t Cpu::indirectIAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::indirectIAddr(bool pagePenalty)
 {
-    uint16_t zpg_addr = cpuRead(_pc++);
+    uint16_t zpg_addr = _operand;
     uint16_t addr = 0;
     addr |= cpuRead(zpg_addr++);
     addr |= (cpuRead(zpg_addr & 0xff) << 8);
-    if ((addr + _y) & 0xff00 != addr & 0xff00)
+    if (pagePenalty && ((addr + _y) & 0xff00) != (addr & 0xff00))
     {
         _cycles++;
+        #ifdef CPU_STATISTICS
+        _executionStatistics.pageCrosses[_statisticsOpcode]++;
+        #endif // CPU_STATISTICS
     }
     return addr + _y;
 }
 
-uint16_t Cpu::indirectAddr()
+template <typename BusType, CpuVariant Variant>
+uint16_t Cpu<BusType, Variant>::indirectAddr()
 {
-    uint16_t ind_addr = 0;
+    uint16_t ind_addr = _operand;
     uint16_t addr = 0;
-    ind_addr |= cpuRead(_pc++);
-    ind_addr |= cpuRead(_pc++) << 8;
     addr |= cpuRead(ind_addr);
     // This line is in order to emulate one of the 6502 bugs
     // In the 6502 advencing the ind_addr to read the hi bits of the address did not effect the hi bits of the ind_addr
@@ -306,45 +1738,115 @@ uint16_t Cpu::indirectAddr()
     return addr;
 }
 
-void Cpu::Adc(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::branch(bool condition)
+{
+    uint16_t addr = relativeAddr();
+    if (condition)
+    {
+        _cycles++;
+        #ifdef CPU_STATISTICS
+        _executionStatistics.branchesTaken[_statisticsOpcode]++;
+        #endif // CPU_STATISTICS
+        if ((addr & 0xff00) != (_pc & 0xff00))
+        {
+            _cycles++;
+            #ifdef CPU_STATISTICS
+            _executionStatistics.pageCrosses[_statisticsOpcode]++;
+            #endif // CPU_STATISTICS
+        }
+        _pc = addr;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::addDecimal(uint8_t data) requires (Variant::DECIMAL_MODE)
+{
+    // Like the NMOS 6502, Z comes from the binary sum and N and V from the sum before the high digit is adjusted
+    uint8_t carry = getFlag(CARRY_FLAG_MASK);
+    uint8_t binary = _a + data + carry;
+    uint16_t low = (_a & 0x0f) + (data & 0x0f) + carry;
+    if (low > 0x09)
+    {
+        low += 0x06;
+    }
+    uint16_t high = (_a >> 4) + (data >> 4) + (low > 0x0f);
+    uint8_t unadjusted = (high << 4) | (low & 0x0f);
+    setOverflow(~(_a ^ data) & (_a ^ unadjusted));
+    setZeroNegative(binary, unadjusted);
+    if (high > 0x09)
+    {
+        high += 0x06;
+    }
+    setCarry(high > 0x0f);
+    return (high << 4) | (low & 0x0f);
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t Cpu<BusType, Variant>::subtractDecimal(uint8_t data, uint8_t carry) requires (Variant::DECIMAL_MODE)
+{
+    int16_t low = (_a & 0x0f) - (data & 0x0f) - (1 - carry);
+    int16_t high = (_a >> 4) - (data >> 4);
+    if (low < 0)
+    {
+        low -= 0x06;
+        high--;
+    }
+    if (high < 0)
+    {
+        high -= 0x06;
+    }
+    return ((high << 4) | (low & 0x0f)) & 0xff;
+}
+
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Adc()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
+    if constexpr (Variant::DECIMAL_MODE)
+    {
+        if (getFlag(DECIMAL_MODE_FLAG_MASK))
+        {
+            _a = addDecimal(data);
+            return;
+        }
+    }
     uint16_t temp = getFlag(CARRY_FLAG_MASK) + data + _a;
-    setFlag(CARRY_FLAG_MASK, temp & 0xff00);
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(OVERFLOW_FLAG_MASK, (_a ^ temp) & (data ^ temp) & 0x80);
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
+    setCarry(temp & 0xff00);
+    setOverflow((_a ^ temp) & (data ^ temp));
+    setZeroNegative(temp & 0xff);
     _a = temp & 0xff;
 }
 
-void Cpu::And(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::And()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
     _a &= data;
-    setFlag(ZERO_FLAG_MASK, !(_a));
-    setFlag(NEGATIVE_FLAG_MASK, _a & 0x80);
+    setZeroNegative(_a);
 }
 
-void Cpu::Asl(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Asl()
 {
     uint8_t data;
     uint16_t addr;
-    if (addrMode == AMode::ACCUM)
+    if constexpr (addrMode == AMode::ACCUM)
     {
         data = _a;
     }
     else
     {
-        addr = _addressModeMapper[addrMode]();
+        addr = resolveAddress<addrMode, false>();
         data = cpuRead(addr);
     }
     uint16_t temp = data << 1;
-    setFlag(CARRY_FLAG_MASK, temp & 0xff00);
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
-    if (addrMode == AMode::ACCUM)
+    setCarry(temp & 0xff00);
+    setZeroNegative(temp & 0xff);
+    if constexpr (addrMode == AMode::ACCUM)
     {
         _a = temp & 0xff;
     }
@@ -354,300 +1856,248 @@ void Cpu::Asl(AMode addrMode)
     }
 }
 
-void Cpu::Bcc(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Bcc()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (!getFlag(CARRY_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(!getFlag(CARRY_FLAG_MASK));
 }
 
-void Cpu::Bcs(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Bcs()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (getFlag(CARRY_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(getFlag(CARRY_FLAG_MASK));
 }
 
-void Cpu::Beq(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Beq()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (getFlag(ZERO_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(getFlag(ZERO_FLAG_MASK));
 }
 
-void Cpu::Bit(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Bit()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
     uint16_t temp = _a & data;
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(OVERFLOW_FLAG_MASK, data & 1 << 6);
-    setFlag(NEGATIVE_FLAG_MASK, data & 1 << 7);
+    setOverflow(data << 1);
+    setZeroNegative(temp & 0xff, data);
 }
 
-void Cpu::Bmi(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Bmi()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (getFlag(NEGATIVE_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(getFlag(NEGATIVE_FLAG_MASK));
 }
 
-void Cpu::Bne(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Bne()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (!getFlag(ZERO_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(!getFlag(ZERO_FLAG_MASK));
 }
 
-void Cpu::Bpl(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Bpl()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (!getFlag(NEGATIVE_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(!getFlag(NEGATIVE_FLAG_MASK));
 }
 
-void Cpu::Brk(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Brk()
 {
     _pc++;
     setFlag(INTERRUPT_DISABLE_FLAG_MASK, true);
     cpuWrite(STACK_OFFSET + _sp--, (_pc >> 8) & 0xff);
     cpuWrite(STACK_OFFSET + _sp--, _pc & 0xff);
-    cpuWrite(STACK_OFFSET + _sp--, _p | BREAK_COMMAND_FLAG_MASK);
+    cpuWrite(STACK_OFFSET + _sp--, getStatus() | BREAK_COMMAND_FLAG_MASK);
     _pc = cpuRead(_irqVectorMap[IrqType::BRK].first) | (cpuRead(_irqVectorMap[IrqType::BRK].second) << 8);
 }
 
-void Cpu::Bvc(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Bvc()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (!getFlag(OVERFLOW_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(!getFlag(OVERFLOW_FLAG_MASK));
 }
 
-void Cpu::Bvs(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Bvs()
 {
-    
-    uint16_t addr = _addressModeMapper[addrMode]();
-    if (getFlag(OVERFLOW_FLAG_MASK))
-    {
-        if (addr & 0xff != _pc % 0xff)
-        {
-            _cycles++;
-        }
-        _pc = addr;
-    }
+    branch(getFlag(OVERFLOW_FLAG_MASK));
 }
 
-void Cpu::Clc(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Clc()
 {
     clearFlag(CARRY_FLAG_MASK);
 }
 
-void Cpu::Cld(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Cld()
 {
     clearFlag(DECIMAL_MODE_FLAG_MASK);
 }
 
-void Cpu::Cli(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Cli()
 {
     clearFlag(INTERRUPT_DISABLE_FLAG_MASK);
 }
 
-void Cpu::Clv(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Clv()
 {
     clearFlag(OVERFLOW_FLAG_MASK);
 }
 
-void Cpu::Cmp(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Cmp()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
     uint16_t temp = _a - data;
-    setFlag(CARRY_FLAG_MASK,(_a >= data));
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
+    setCarry((_a >= data));
+    setZeroNegative(temp & 0xff);
 }
 
-void Cpu::Cpx(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Cpx()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
     uint16_t temp = _x - data;
-    setFlag(CARRY_FLAG_MASK,(_x >= data));
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
+    setCarry((_x >= data));
+    setZeroNegative(temp & 0xff);
 }
 
-void Cpu::Cpy(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Cpy()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
     uint16_t temp = _y - data;
-    setFlag(CARRY_FLAG_MASK,(_y >= data));
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
+    setCarry((_y >= data));
+    setZeroNegative(temp & 0xff);
 }
 
-void Cpu::Dec(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Dec()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
+    uint16_t addr = resolveAddress<addrMode, false>();
     uint8_t data = cpuRead(addr) - 1;
-    setFlag(ZERO_FLAG_MASK, !(data));
-    setFlag(NEGATIVE_FLAG_MASK, data & 0x80);
+    setZeroNegative(data);
     cpuWrite(addr, data);
 }
 
-void Cpu::Dex(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Dex()
 {
     _x--;
-    setFlag(ZERO_FLAG_MASK, !(_x));
-    setFlag(NEGATIVE_FLAG_MASK, _x & 0x80);
+    setZeroNegative(_x);
 }
 
-void Cpu::Dey(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Dey()
 {
     _y--;
-    setFlag(ZERO_FLAG_MASK, !(_y));
-    setFlag(NEGATIVE_FLAG_MASK, _y & 0x80);
+    setZeroNegative(_y);
 }
 
-void Cpu::Eor(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Eor()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
     _a ^= data;
-    setFlag(ZERO_FLAG_MASK, !(_a));
-    setFlag(NEGATIVE_FLAG_MASK, _a & 0x80);
+    setZeroNegative(_a);
 }
 
-void Cpu::Inc(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Inc()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
+    uint16_t addr = resolveAddress<addrMode, false>();
     uint8_t data = cpuRead(addr) + 1;
-    setFlag(ZERO_FLAG_MASK, !(data));
-    setFlag(NEGATIVE_FLAG_MASK, data & 0x80);
+    setZeroNegative(data);
     cpuWrite(addr, data);
 }
 
-void Cpu::Inx(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Inx()
 {
     _x++;
-    setFlag(ZERO_FLAG_MASK, !(_x));
-    setFlag(NEGATIVE_FLAG_MASK, _x & 0x80);
+    setZeroNegative(_x);
 }
 
-void Cpu::Iny(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Iny()
 {
     _y++;
-    setFlag(ZERO_FLAG_MASK, !(_y));
-    setFlag(NEGATIVE_FLAG_MASK, _y & 0x80);
+    setZeroNegative(_y);
 }
 
-void Cpu::Jmp(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Jmp()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
+    uint16_t addr = resolveAddress<addrMode>();
     _pc = addr;
 }
 
-void Cpu::Jsr(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Jsr()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
+    uint16_t addr = resolveAddress<addrMode>();
     _pc--; // pc has jumped 3 times and now we need to go back once
     cpuWrite(STACK_OFFSET + _sp--, (_pc >> 8) & 0xff);
     cpuWrite(STACK_OFFSET + _sp--, _pc & 0xff);
     _pc = addr;
 }
 
-void Cpu::Lda(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Lda()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    _a = cpuRead(addr);
-    setFlag(ZERO_FLAG_MASK, !(_a));
-    setFlag(NEGATIVE_FLAG_MASK, _a & 0x80);
+    _a = readOperand<addrMode>();
+    setZeroNegative(_a);
 }
 
-void Cpu::Ldx(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Ldx()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    _x = cpuRead(addr);
-    setFlag(ZERO_FLAG_MASK, !(_x));
-    setFlag(NEGATIVE_FLAG_MASK, _x & 0x80);
+    _x = readOperand<addrMode>();
+    setZeroNegative(_x);
 }
 
-void Cpu::Ldy(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Ldy()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    _y = cpuRead(addr);
-    setFlag(ZERO_FLAG_MASK, !(_y));
-    setFlag(NEGATIVE_FLAG_MASK, _y & 0x80);
+    _y = readOperand<addrMode>();
+    setZeroNegative(_y);
 }
 
-void Cpu::Lsr(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Lsr()
 {
     uint8_t data;
     uint16_t addr;
-    if (addrMode == AMode::ACCUM)
+    if constexpr (addrMode == AMode::ACCUM)
     {
         data = _a;
     }
     else
     {
-        addr = _addressModeMapper[addrMode]();
+        addr = resolveAddress<addrMode, false>();
         data = cpuRead(addr);
     }
     uint16_t temp = data >> 1;
-    setFlag(CARRY_FLAG_MASK, data & 0x1);
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    clearFlag(NEGATIVE_FLAG_MASK);
-    if (addrMode == AMode::ACCUM)
+    setCarry(data & 0x1);
+    setZeroNegative(temp & 0xff);
+    if constexpr (addrMode == AMode::ACCUM)
     {
         _a = temp & 0xff;
     }
@@ -657,64 +2107,68 @@ void Cpu::Lsr(AMode addrMode)
     }
 }
 
-void Cpu::Nop(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Nop()
 {
     // This line is used to handle illegal nops that need to preform pc advencments  
-    _addressModeMapper[addrMode]();
+    resolveAddress<addrMode>();
 }
 
-void Cpu::Ora(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Ora()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
+    uint8_t data = readOperand<addrMode>();
     _a |= data;
-    setFlag(ZERO_FLAG_MASK, !(_a));
-    setFlag(NEGATIVE_FLAG_MASK, _a & 0x80);
+    setZeroNegative(_a);
 }
 
-void Cpu::Pha(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Pha()
 {
     cpuWrite(STACK_OFFSET + _sp--, _a);
 }
 
-void Cpu::Php(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Php()
 {
-    cpuWrite(STACK_OFFSET + _sp--, _p | BREAK_COMMAND_FLAG_MASK | RESERVED_FLAG_MASK);
+    cpuWrite(STACK_OFFSET + _sp--, getStatus() | BREAK_COMMAND_FLAG_MASK | RESERVED_FLAG_MASK);
 }
 
-void Cpu::Pla(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Pla()
 {
     _a = cpuRead(STACK_OFFSET + ++_sp);
-    setFlag(ZERO_FLAG_MASK, !(_a));
-    setFlag(NEGATIVE_FLAG_MASK, _a & 0x80);
+    setZeroNegative(_a);
 }
 
-void Cpu::Plp(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Plp()
 {
-    _p = cpuRead(STACK_OFFSET + ++_sp);
-    clearFlag(BREAK_COMMAND_FLAG_MASK);
-    clearFlag(RESERVED_FLAG_MASK);
+    setStatus(cpuRead(STACK_OFFSET + ++_sp));
 }
 
-void Cpu::Rol(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Rol()
 {
     uint8_t data;
     uint16_t addr;
-    if (addrMode == AMode::ACCUM)
+    if constexpr (addrMode == AMode::ACCUM)
     {
         data = _a;
     }
     else
     {
-        addr = _addressModeMapper[addrMode]();
+        addr = resolveAddress<addrMode, false>();
         data = cpuRead(addr);
     }
     uint16_t temp = data << 1;
     temp |= getFlag(CARRY_FLAG_MASK);
-    setFlag(CARRY_FLAG_MASK, temp & 0xff00);
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
-    if (addrMode == AMode::ACCUM)
+    setCarry(temp & 0xff00);
+    setZeroNegative(temp & 0xff);
+    if constexpr (addrMode == AMode::ACCUM)
     {
         _a = temp & 0xff;
     }
@@ -723,25 +2177,26 @@ void Cpu::Rol(AMode addrMode)
         cpuWrite(addr, temp & 0xff);
     }
 }
-void Cpu::Ror(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Ror()
 {
     uint8_t data;
     uint16_t addr;
-    if (addrMode == AMode::ACCUM)
+    if constexpr (addrMode == AMode::ACCUM)
     {
         data = _a;
     }
     else
     {
-        addr = _addressModeMapper[addrMode]();
+        addr = resolveAddress<addrMode, false>();
         data = cpuRead(addr);
     }
     uint16_t temp = data >> 1;
     temp |= getFlag(CARRY_FLAG_MASK) << 7;
-    setFlag(CARRY_FLAG_MASK, data & 0x1);
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
-    if (addrMode == AMode::ACCUM)
+    setCarry(data & 0x1);
+    setZeroNegative(temp & 0xff);
+    if constexpr (addrMode == AMode::ACCUM)
     {
         _a = temp & 0xff;
     }
@@ -751,198 +2206,127 @@ void Cpu::Ror(AMode addrMode)
     }
 }
 
-void Cpu::Rti(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Rti()
 {
-    _p = cpuRead(STACK_OFFSET + ++_sp);
+    setStatus(cpuRead(STACK_OFFSET + ++_sp));
     _pc = cpuRead(STACK_OFFSET + ++_sp);
     _pc |= cpuRead(STACK_OFFSET + ++_sp) << 8;
-    clearFlag(BREAK_COMMAND_FLAG_MASK);
-    clearFlag(RESERVED_FLAG_MASK);
 }
 
-void Cpu::Rts(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Rts()
 {
     _pc = cpuRead(STACK_OFFSET + ++_sp);
     _pc |= cpuRead(STACK_OFFSET + ++_sp) << 8;
     _pc++;
 }
 
-void Cpu::Sbc(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Sbc()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
-    uint8_t data = cpuRead(addr);
-    uint16_t temp = _a + (data ^ 0xff) + getFlag(CARRY_FLAG_MASK);
-    setFlag(CARRY_FLAG_MASK, temp & 0xff00);
-    setFlag(ZERO_FLAG_MASK, !(temp & 0xff));
-    setFlag(OVERFLOW_FLAG_MASK, (_a ^ temp) & ((data ^ 0xff) ^ temp) & 0x80);
-    setFlag(NEGATIVE_FLAG_MASK, temp & 0x80);
+    uint8_t data = readOperand<addrMode>();
+    uint8_t carry = getFlag(CARRY_FLAG_MASK);
+    uint16_t temp = _a + (data ^ 0xff) + carry;
+    setCarry(temp & 0xff00);
+    setOverflow((_a ^ temp) & ((data ^ 0xff) ^ temp));
+    setZeroNegative(temp & 0xff);
+    if constexpr (Variant::DECIMAL_MODE)
+    {
+        if (getFlag(DECIMAL_MODE_FLAG_MASK))
+        {
+            // The flags are the ones of the binary subtraction, only the result is adjusted
+            _a = subtractDecimal(data, carry);
+            return;
+        }
+    }
     _a = temp & 0xff;
 }
 
-void Cpu::Sec(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Sec()
 {
     setFlag(CARRY_FLAG_MASK, true);
 }
 
-void Cpu::Sed(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Sed()
 {
     setFlag(DECIMAL_MODE_FLAG_MASK, true);
 }
 
-void Cpu::Sei(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Sei()
 {
     setFlag(INTERRUPT_DISABLE_FLAG_MASK, true);
 }
 
-void Cpu::Sta(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Sta()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
+    uint16_t addr = resolveAddress<addrMode, false>();
     cpuWrite(addr, _a);
 }
 
-void Cpu::Stx(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Stx()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
+    uint16_t addr = resolveAddress<addrMode, false>();
     cpuWrite(addr, _x);
 }
 
-void Cpu::Sty(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+template <typename Cpu<BusType, Variant>::AMode addrMode>
+void Cpu<BusType, Variant>::Sty()
 {
-    uint16_t addr = _addressModeMapper[addrMode]();
+    uint16_t addr = resolveAddress<addrMode, false>();
     cpuWrite(addr, _y);
 }
 
-void Cpu::Tax(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Tax()
 {
     _x = _a;
-    setFlag(ZERO_FLAG_MASK, !(_x));
-    setFlag(NEGATIVE_FLAG_MASK, _x & 0x80);
+    setZeroNegative(_x);
 }
 
-void Cpu::Tay(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Tay()
 {
     _y = _a;
-    setFlag(ZERO_FLAG_MASK, !(_y));
-    setFlag(NEGATIVE_FLAG_MASK, _y & 0x80);
+    setZeroNegative(_y);
 }
 
-void Cpu::Tsx(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Tsx()
 {
     _x = _sp;
-    setFlag(ZERO_FLAG_MASK, !(_x));
-    setFlag(NEGATIVE_FLAG_MASK, _x & 0x80);
+    setZeroNegative(_x);
 }
 
-void Cpu::Txa(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Txa()
 {
     _a = _x;
-    setFlag(ZERO_FLAG_MASK, !(_a));
-    setFlag(NEGATIVE_FLAG_MASK, _a & 0x80);
+    setZeroNegative(_a);
 }
 
-void Cpu::Txs(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Txs()
 {
     _sp = _x;
 }
 
-void Cpu::Tya(AMode addrMode)
+template <typename BusType, CpuVariant Variant>
+void Cpu<BusType, Variant>::Tya()
 {
     _a = _y;
-    setFlag(ZERO_FLAG_MASK, !(_a));
-    setFlag(NEGATIVE_FLAG_MASK, _a & 0x80);
+    setZeroNegative(_a);
 }
 
-std::map<uint16_t, std::string> Cpu::disassemble()
-{
-    std::map<uint16_t, std::string> diss_map;
-    uint16_t addr = 0xc000;
-    uint16_t orig_addr = addr;
-    uint16_t temp_addr;
-    int8_t temp_data;
-    uint8_t data;
-    while (addr < 0xffff && orig_addr <= addr)
-    {
-        std::string asm_line;
-        asm_line = "Address: " + NumToHexStringConvertor::Convert(addr, 4) + ",   ";
-        orig_addr = addr;
-        data = _busRead(addr++);
-        if (_opcodeVector[data].type == IType::BRK)
-        {
-            addr++;
-        }
-        asm_line += "Instruction opcode:" + NumToHexStringConvertor::Convert(data, 2);
-        asm_line += ",  Instruction:" + _iTypeNameMapper[static_cast<int>(_opcodeVector[data].type)];
-        switch (_opcodeVector[data].addrMode)
-        {
-        case AMode::ACCUM :
-        break;
-        case AMode::IMM :
-            temp_addr = _busRead(addr++);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4);
-                
-        break;
-        case AMode::IMPLIED :
-        break;
-        case AMode::ABSOLUTE :
-            temp_addr = _busRead(addr++);
-            temp_addr |= (_busRead(addr++) << 8);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4);
-                
-        break;
-        case AMode::ZP:
-            temp_addr = _busRead(addr++);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4);
-                
-        break;
-        case AMode::I_ZP_X:
-            temp_addr = _busRead(addr++);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4) + ", x";
-                
-        break;
-        case AMode::I_ZP_Y:
-            temp_addr = _busRead(addr++);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4) + ", y";
-                
-        break;
-        case AMode::I_ABSOLUTE_X:
-            temp_addr = _busRead(addr++);
-            temp_addr |= (_busRead(addr++) << 8);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4) + ", x";
-                
-        break;
-        case AMode::I_ABSOLUTE_Y:
-            temp_addr = _busRead(addr++);
-            temp_addr |= (_busRead(addr++) << 8);
-            asm_line += "  " +  NumToHexStringConvertor::Convert(temp_addr, 4) + ", y";
-                
-        break;
-        case AMode::RELATIVE:
-            temp_data = _busRead(addr++);
-            temp_addr = temp_data;
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4) + " [Rel Address:" + NumToHexStringConvertor::Convert(temp_data + addr, 4) + "]";
-                
-        break;
-        case AMode::I_INDIRECT:
-            temp_addr = _busRead(addr++);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4) + ", x";
-                
-        break;
-        case AMode::INDIRECT_I:
-            temp_addr = _busRead(addr++);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4) + ", y";
-                
-        break;
-        case AMode::INDIRECT:
-            temp_addr = _busRead(addr++);
-            temp_addr |= (_busRead(addr++) << 8);
-            asm_line += "  " + NumToHexStringConvertor::Convert(temp_addr, 4);
-                
-        break;
-        default:
-            break;
-        }
-        asm_line += ",  Address mode:" + _aModeNameMapper[static_cast<int>(_opcodeVector[data].addrMode)];
-        diss_map[orig_addr] = asm_line;
-    }
-    return std::move(diss_map);
-}
\ No newline at end of file
+template class Cpu<Bus>;
+template class Cpu<FunctionalCpuBus>;
+template class Cpu<FunctionalCpuBus, Mos6502>;
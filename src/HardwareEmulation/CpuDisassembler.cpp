@@ -0,0 +1,187 @@
+#include "NumToHexStringConvertor.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "HardwareEmulation/CpuDisassembler.hpp"
+#include "HardwareEmulation/Bus.hpp"
+
+template <typename BusType, CpuVariant Variant>
+CpuDisassembler<BusType, Variant>::CpuDisassembler(Cpu<BusType, Variant>& cpu) :
+    _cpu(cpu)
+{
+    std::fill(_rom.begin(), _rom.end(), 0);
+    std::fill(_isRom.begin(), _isRom.end(), false);
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuDisassembler<BusType, Variant>::captureRom()
+{
+    for (uint32_t address = ROM_START; address < ROM_START + ROM_SIZE; address++)
+    {
+        if constexpr (std::is_same_v<BusType, Bus>)
+        {
+            // The copy comes from the cartridge and the mapped pages so it isn't counted, logged or watched as cpu reads
+            const std::shared_ptr<Cartridge>& cartridge = _cpu._bus._cartridge;
+            const uint8_t* rom = _cpu._bus.cpuRomPointer(address);
+            _isRom[address - ROM_START] = cartridge.get() != nullptr && cartridge->getPrgBankId(address) >= 0 && rom != nullptr;
+            _rom[address - ROM_START] = (_isRom[address - ROM_START])? *rom : 0;
+        }
+        else
+        {
+            _isRom[address - ROM_START] = true;
+            _rom[address - ROM_START] = _cpu.cpuRead(address);
+        }
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuDisassembler<BusType, Variant>::disassemble()
+{
+    using CpuType = Cpu<BusType, Variant>;
+    _records.clear();
+    std::vector<bool> visited(ROM_SIZE, false);
+    std::vector<uint32_t> targets;
+    for (uint32_t vector : {CpuType::RESET_LSB, CpuType::NMI_LSB, CpuType::NORMAL_IRQ_LSB})
+    {
+        if (isRom(vector) && isRom(vector + 1))
+        {
+            targets.push_back(romReadWord(vector));
+        }
+    }
+    while (!targets.empty())
+    {
+        uint32_t pc = targets.back();
+        targets.pop_back();
+        // Runs straight through the code until it stops or reaches code that was already visited
+        bool endOfCode = false;
+        while (!endOfCode && isRom(pc) && !visited[pc - ROM_START])
+        {
+            uint8_t opcode = romRead(pc);
+            const typename CpuType::Instruction& instruction = CpuType::_opcodeVector[opcode];
+            uint8_t length = CpuType::getInstructionLength(opcode);
+            if (instruction.type == IType::MIA || !isRom(pc + length - 1))
+            {
+                // Illegal opcodes are most likely data the code ran into
+                break;
+            }
+            visited[pc - ROM_START] = true;
+            Record record = {static_cast<uint16_t>(pc), 0, opcode};
+            if (length == 2)
+            {
+                record.operand = romRead(pc + 1);
+            }
+            else if (length == 3)
+            {
+                record.operand = romReadWord(pc + 1);
+            }
+            _records.push_back(record);
+            pc += length;
+            if (CpuType::isBranch(instruction.type))
+            {
+                targets.push_back(static_cast<uint16_t>(pc + static_cast<int8_t>(record.operand)));
+                continue;
+            }
+            switch (instruction.type)
+            {
+            case IType::JSR:
+                targets.push_back(record.operand);
+                break;
+            case IType::JMP:
+                if (instruction.addrMode == AMode::ABSOLUTE)
+                {
+                    targets.push_back(record.operand);
+                }
+                else if (isRom(record.operand) && isRom((record.operand & 0xff00) | ((record.operand + 1) & 0xff)))
+                {
+                    // A jump table in rom, the pointer has the same page wrap bug the cpu has
+                    targets.push_back(romRead(record.operand) | (romRead((record.operand & 0xff00) | ((record.operand + 1) & 0xff)) << 8));
+                }
+                endOfCode = true;
+                break;
+            case IType::BRK:
+            case IType::RTI:
+            case IType::RTS:
+                endOfCode = true;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    std::sort(_records.begin(), _records.end(), [](const Record& first, const Record& second)
+    {
+        return first.address < second.address;
+    });
+}
+
+template <typename BusType, CpuVariant Variant>
+const std::vector<typename CpuDisassembler<BusType, Variant>::Record>& CpuDisassembler<BusType, Variant>::getRecords() const
+{
+    return _records;
+}
+
+template <typename BusType, CpuVariant Variant>
+std::string CpuDisassembler<BusType, Variant>::format(const Record& record) const
+{
+    const auto& instruction = Cpu<BusType, Variant>::_opcodeVector[record.opcode];
+    std::string line = "Address: " + NumToHexStringConvertor::Convert(record.address, 4) + ",   ";
+    line += "Instruction opcode:" + NumToHexStringConvertor::Convert(record.opcode, 2);
+    line += ",  Instruction:" + _cpu._iTypeNameMapper[static_cast<int>(instruction.type)];
+    switch (instruction.addrMode)
+    {
+    case AMode::ACCUM:
+    case AMode::IMPLIED:
+        break;
+    case AMode::I_ZP_X:
+    case AMode::I_ABSOLUTE_X:
+    case AMode::I_INDIRECT:
+        line += "  " + NumToHexStringConvertor::Convert(record.operand, 4) + ", x";
+        break;
+    case AMode::I_ZP_Y:
+    case AMode::I_ABSOLUTE_Y:
+    case AMode::INDIRECT_I:
+        line += "  " + NumToHexStringConvertor::Convert(record.operand, 4) + ", y";
+        break;
+    case AMode::RELATIVE:
+        line += "  " + NumToHexStringConvertor::Convert(static_cast<uint16_t>(static_cast<int8_t>(record.operand)), 4) +
+            " [Rel Address:" + NumToHexStringConvertor::Convert(static_cast<uint16_t>(record.address + 2 + static_cast<int8_t>(record.operand)), 4) + "]";
+        break;
+    default:
+        line += "  " + NumToHexStringConvertor::Convert(record.operand, 4);
+        break;
+    }
+    line += ",  Address mode:" + _cpu._aModeNameMapper[static_cast<int>(instruction.addrMode)];
+    return line;
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuDisassembler<BusType, Variant>::writeLog(std::ostream& stream) const
+{
+    for (const Record& record : _records)
+    {
+        stream << format(record) << std::endl;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+bool CpuDisassembler<BusType, Variant>::isRom(uint32_t address) const
+{
+    return address >= ROM_START && address < ROM_START + ROM_SIZE && _isRom[address - ROM_START];
+}
+
+template <typename BusType, CpuVariant Variant>
+uint8_t CpuDisassembler<BusType, Variant>::romRead(uint32_t address) const
+{
+    return _rom[address - ROM_START];
+}
+
+template <typename BusType, CpuVariant Variant>
+uint16_t CpuDisassembler<BusType, Variant>::romReadWord(uint32_t address) const
+{
+    return romRead(address) | (romRead(address + 1) << 8);
+}
+
+template class CpuDisassembler<Bus, Ricoh2A03>;
+template class CpuDisassembler<FunctionalCpuBus, Ricoh2A03>;
+template class CpuDisassembler<FunctionalCpuBus, Mos6502>;
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "HardwareEmulation/CpuTrace.hpp"
+
+CpuTrace::CpuTrace()
+{
+    clear();
+}
+
+std::vector<TraceRecord> CpuTrace::getRecords() const
+{
+    std::vector<TraceRecord> records;
+    uint64_t count = std::min<uint64_t>(_count, CAPACITY);
+    records.reserve(count);
+    for (uint64_t index = _count - count; index < _count; index++)
+    {
+        records.push_back(_records[index & INDEX_MASK]);
+    }
+    return records;
+}
+
+void CpuTrace::clear()
+{
+    _records = {};
+    _count = 0;
+}
+
+bool CpuTrace::WriteDump(const std::string& path, std::span<const TraceEntry> entries, std::span<const uint32_t> screen)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    DumpHeader header = {};
+    std::memcpy(header.magic, DUMP_MAGIC, sizeof(DUMP_MAGIC));
+    header.entrySize = sizeof(TraceEntry);
+    header.entryCount = entries.size();
+    header.screenSize = screen.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size_bytes());
+    file.write(reinterpret_cast<const char*>(screen.data()), screen.size_bytes());
+    return file.good();
+}
+
+bool CpuTrace::ReadDump(const std::string& path, std::vector<TraceEntry>& entries, std::vector<uint32_t>& screen)
+{
+    std::ifstream file(path, std::ios::binary);
+    DumpHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    // The dump is only read back by builds with the same entry layout
+    if (!file.good() || std::memcmp(header.magic, DUMP_MAGIC, sizeof(DUMP_MAGIC)) != 0 || header.entrySize != sizeof(TraceEntry))
+    {
+        return false;
+    }
+    entries.resize(header.entryCount);
+    screen.resize(header.screenSize);
+    file.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(TraceEntry));
+    file.read(reinterpret_cast<char*>(screen.data()), screen.size() * sizeof(uint32_t));
+    return file.good();
+}
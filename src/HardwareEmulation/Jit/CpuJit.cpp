@@ -0,0 +1,893 @@
+#ifdef CPU_JIT
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+
+#include "NumToHexStringConvertor.hpp"
+
+#include "HardwareEmulation/Jit/CpuJit.hpp"
+#include "HardwareEmulation/Bus.hpp"
+
+// Register assignment of the translated code, nothing is called from it so the caller saved registers are free to use
+// rax, rcx and rdx are scratch registers
+using Reg = X86Emitter::Reg;
+using AluOp = X86Emitter::AluOp;
+using Condition = X86Emitter::Condition;
+static constexpr Reg REG_STATE = Reg::RDI;
+static constexpr Reg REG_RAM = Reg::RSI;
+static constexpr Reg REG_A = Reg::R8;
+static constexpr Reg REG_X = Reg::R9;
+static constexpr Reg REG_Y = Reg::R10;
+static constexpr Reg REG_SP = Reg::R11;
+static constexpr Reg REG_CARRY = Reg::R12;
+static constexpr Reg REG_ZERO = Reg::R13;
+static constexpr Reg REG_OVERFLOW = Reg::R14;
+static constexpr Reg REG_NEGATIVE = Reg::R15;
+static constexpr Reg REG_CYCLES = Reg::RBX;
+static constexpr Reg REG_INSTRUCTIONS = Reg::RBP;
+
+static constexpr std::array<Reg, 6> CALLEE_SAVED = {Reg::RBX, Reg::RBP, Reg::R12, Reg::R13, Reg::R14, Reg::R15};
+
+static constexpr uint16_t RAM_MEMORY_RANGE = 0x2000;
+static constexpr uint16_t TRUE_RAM_MASK = 0x7ff;
+
+template <typename BusType, CpuVariant Variant>
+CpuJit<BusType, Variant>::CpuJit(Cpu<BusType, Variant>& cpu) :
+    _cpu(cpu),
+    _recentBlocks(0x10000, nullptr)
+{
+    _enabled = false;
+    _differentialMode = false;
+    _statistics = {};
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuJit<BusType, Variant>::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+    invalidate();
+}
+
+template <typename BusType, CpuVariant Variant>
+bool CpuJit<BusType, Variant>::isEnabled() const
+{
+    return _enabled;
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuJit<BusType, Variant>::setDifferentialMode(bool enabled)
+{
+    _differentialMode = enabled;
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuJit<BusType, Variant>::invalidate()
+{
+    _blocks.clear();
+    std::fill(_recentBlocks.begin(), _recentBlocks.end(), nullptr);
+    if (_codeMemory)
+    {
+        _codeMemory->reset();
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+typename CpuJit<BusType, Variant>::Statistics CpuJit<BusType, Variant>::getStatistics() const
+{
+    Statistics statistics = _statistics;
+    statistics.codeSize = (_codeMemory)? _codeMemory->used() : 0;
+    return statistics;
+}
+
+template <typename BusType, CpuVariant Variant>
+uint32_t CpuJit<BusType, Variant>::run(uint32_t maxInstructions)
+{
+    if constexpr (JitBus<BusType>)
+    {
+        if (!_differentialMode)
+        {
+            return runTranslated(maxInstructions);
+        }
+        CpuSnapshot before = takeSnapshot();
+        uint32_t instructions = runTranslated(maxInstructions);
+        if (instructions == 0)
+        {
+            return 0;
+        }
+        // Translated code only touches the ram so running the same instructions again in the interpreter is safe
+        CpuSnapshot translated = takeSnapshot();
+        restoreSnapshot(before);
+        for (uint32_t i = 0; i < instructions; i++)
+        {
+            _cpu.executeInstruction();
+        }
+        CpuSnapshot interpreted = takeSnapshot();
+        _statistics.differentialChecks++;
+        if (!(translated == interpreted))
+        {
+            _statistics.differentialMismatches++;
+            std::cerr << "Jit mismatch after " << instructions << " instructions from " << NumToHexStringConvertor::Convert(before.pc, 4) << std::endl;
+            std::cerr << "jit:         PC:" << NumToHexStringConvertor::Convert(translated.pc, 4) << " A:" << NumToHexStringConvertor::Convert(translated.a, 2) <<
+                " X:" << NumToHexStringConvertor::Convert(translated.x, 2) << " Y:" << NumToHexStringConvertor::Convert(translated.y, 2) <<
+                " P:" << NumToHexStringConvertor::Convert(translated.status, 2) << " SP:" << NumToHexStringConvertor::Convert(translated.sp, 2) <<
+                " CYC:" << translated.cycles << ((translated.ram != interpreted.ram)? " RAM DIFFERS" : "") << std::endl;
+            std::cerr << "interpreter: PC:" << NumToHexStringConvertor::Convert(interpreted.pc, 4) << " A:" << NumToHexStringConvertor::Convert(interpreted.a, 2) <<
+                " X:" << NumToHexStringConvertor::Convert(interpreted.x, 2) << " Y:" << NumToHexStringConvertor::Convert(interpreted.y, 2) <<
+                " P:" << NumToHexStringConvertor::Convert(interpreted.status, 2) << " SP:" << NumToHexStringConvertor::Convert(interpreted.sp, 2) <<
+                " CYC:" << interpreted.cycles << std::endl;
+        }
+        // The interpreter result is the one that is kept
+        return instructions;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+uint32_t CpuJit<BusType, Variant>::runTranslated(uint32_t maxInstructions)
+{
+    // Most calls are for code that isn't translated so the state is only loaded once there is something to run
+    JitFunction code = lookup(_cpu._pc);
+    if (code == nullptr)
+    {
+        return 0;
+    }
+    JitState state;
+    loadState(state);
+    state.maxInstructions = maxInstructions;
+    state.instructions = 0;
+    while (state.instructions < maxInstructions)
+    {
+        if (state.instructions > 0)
+        {
+            code = lookup(state.pc);
+            if (code == nullptr)
+            {
+                break;
+            }
+        }
+        uint32_t instructions = state.instructions;
+        state.mmioExit = 0;
+        code(&state);
+        if (state.mmioExit)
+        {
+            // The instruction that touches the mmio runs in the interpreter
+            _statistics.mmioExits++;
+            break;
+        }
+        if (state.instructions == instructions)
+        {
+            break;
+        }
+    }
+    if (state.instructions > 0)
+    {
+        storeState(state);
+        _statistics.instructions += state.instructions;
+    }
+    return state.instructions;
+}
+
+template <typename BusType, CpuVariant Variant>
+typename CpuJit<BusType, Variant>::JitFunction CpuJit<BusType, Variant>::lookup(uint16_t pc)
+{
+    if constexpr (JitBus<BusType>)
+    {
+        if (!_cpu._bus.cpuCodeBypassAllowed())
+        {
+            return nullptr;
+        }
+        // Code that runs from ram (or anything that isn't rom) is never translated since it may modify itself
+        int32_t bank = _cpu._bus.cpuCodeBank(pc);
+        if (bank < 0)
+        {
+            return nullptr;
+        }
+        JitBlock* recent = _recentBlocks[pc];
+        if (recent == nullptr || recent->bank != bank)
+        {
+            uint32_t key = (static_cast<uint32_t>(bank) << 16) | pc;
+            recent = &_blocks.try_emplace(key, JitBlock{bank, 0, nullptr, true}).first->second;
+            _recentBlocks[pc] = recent;
+        }
+        JitBlock& block = *recent;
+        if (block.code != nullptr || !block.translatable || ++block.executions < HOT_BLOCK_THRESHOLD)
+        {
+            return block.code;
+        }
+        X86Emitter emitter;
+        if (!translate(pc, bank, emitter))
+        {
+            block.translatable = false;
+            return nullptr;
+        }
+        if (!_codeMemory)
+        {
+            _codeMemory = std::make_unique<ExecutableMemory>(CODE_MEMORY_SIZE);
+        }
+        const uint8_t* code = _codeMemory->commit(emitter.code());
+        if (code == nullptr)
+        {
+            // Start over once the code memory is full, hot blocks will be translated again
+            invalidate();
+            return nullptr;
+        }
+        _statistics.translatedBlocks++;
+        block.code = reinterpret_cast<JitFunction>(code);
+        return block.code;
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuJit<BusType, Variant>::loadState(JitState& state)
+{
+    if constexpr (JitBus<BusType>)
+    {
+        uint8_t status = _cpu.getStatus();
+        state.cycles = _cpu._cycles;
+        state.ram = _cpu._bus.cpuRam().data();
+        state.pc = _cpu._pc;
+        state.a = _cpu._a;
+        state.x = _cpu._x;
+        state.y = _cpu._y;
+        state.sp = _cpu._sp;
+        state.carry = status & Cpu<BusType, Variant>::CARRY_FLAG_MASK;
+        state.zero = (status & Cpu<BusType, Variant>::ZERO_FLAG_MASK)? 0 : 1;
+        state.overflow = (status & Cpu<BusType, Variant>::OVERFLOW_FLAG_MASK) << 1;
+        state.negative = status & Cpu<BusType, Variant>::NEGATIVE_FLAG_MASK;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuJit<BusType, Variant>::storeState(const JitState& state)
+{
+    uint8_t status = _cpu.getStatus() & ~(Cpu<BusType, Variant>::CARRY_FLAG_MASK | Cpu<BusType, Variant>::ZERO_FLAG_MASK |
+        Cpu<BusType, Variant>::OVERFLOW_FLAG_MASK | Cpu<BusType, Variant>::NEGATIVE_FLAG_MASK);
+    status |= state.carry & Cpu<BusType, Variant>::CARRY_FLAG_MASK;
+    status |= (state.zero == 0)? Cpu<BusType, Variant>::ZERO_FLAG_MASK : 0;
+    status |= (state.overflow & 0x80)? Cpu<BusType, Variant>::OVERFLOW_FLAG_MASK : 0;
+    status |= state.negative & Cpu<BusType, Variant>::NEGATIVE_FLAG_MASK;
+    _cpu._cycles = state.cycles;
+    _cpu._pc = state.pc;
+    _cpu._a = state.a;
+    _cpu._x = state.x;
+    _cpu._y = state.y;
+    _cpu._sp = state.sp;
+    _cpu.setStatus(status);
+}
+
+template <typename BusType, CpuVariant Variant>
+typename CpuJit<BusType, Variant>::CpuSnapshot CpuJit<BusType, Variant>::takeSnapshot()
+{
+    CpuSnapshot snapshot = {_cpu._pc, _cpu._sp, _cpu._a, _cpu._x, _cpu._y, _cpu.getStatus(), _cpu._cycles, {}};
+    if constexpr (JitBus<BusType>)
+    {
+        auto ram = _cpu._bus.cpuRam();
+        snapshot.ram.assign(ram.begin(), ram.end());
+    }
+    return snapshot;
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuJit<BusType, Variant>::restoreSnapshot(const CpuSnapshot& snapshot)
+{
+    _cpu._pc = snapshot.pc;
+    _cpu._sp = snapshot.sp;
+    _cpu._a = snapshot.a;
+    _cpu._x = snapshot.x;
+    _cpu._y = snapshot.y;
+    _cpu.setStatus(snapshot.status);
+    _cpu._cycles = snapshot.cycles;
+    if constexpr (JitBus<BusType>)
+    {
+        std::copy(snapshot.ram.begin(), snapshot.ram.end(), _cpu._bus.cpuRam().begin());
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+bool CpuJit<BusType, Variant>::isTranslatable(uint8_t opcode, uint16_t operand)
+{
+    using IType = typename Cpu<BusType, Variant>::IType;
+    using AMode = typename Cpu<BusType, Variant>::AMode;
+    const auto& instruction = Cpu<BusType, Variant>::_opcodeVector[opcode];
+    switch (instruction.type)
+    {
+    // Interrupts and anything that touches the I and D flags stay in the interpreter
+    case IType::BRK:
+    case IType::RTI:
+    case IType::PHP:
+    case IType::PLP:
+    case IType::CLI:
+    case IType::SEI:
+    case IType::CLD:
+    case IType::SED:
+    case IType::MIA:
+        return false;
+    case IType::JMP:
+    case IType::JSR:
+        return instruction.addrMode == AMode::ABSOLUTE;
+    case IType::NOP:
+        return instruction.addrMode == AMode::IMPLIED;
+    default:
+        // Absolute accesses outside of the ram and rom are known at translation time
+        return instruction.addrMode != AMode::ABSOLUTE || operand < RAM_MEMORY_RANGE ||
+            (Cpu<BusType, Variant>::isReadInstruction(instruction.type) && romPointer(operand, 1) != nullptr);
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+const uint8_t* CpuJit<BusType, Variant>::romPointer(uint16_t address, uint32_t length)
+{
+    if constexpr (JitBus<BusType>)
+    {
+        uint32_t last = address + length - 1;
+        if (last > 0xffff)
+        {
+            return nullptr;
+        }
+        const uint8_t* first = _cpu._bus.cpuRomPointer(address);
+        if (first == nullptr || _cpu._bus.cpuRomPointer(last) != first + (length - 1))
+        {
+            return nullptr;
+        }
+        return first;
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+template <typename BusType, CpuVariant Variant>
+bool CpuJit<BusType, Variant>::translate(uint16_t pc, int32_t bank, X86Emitter& emitter)
+{
+    auto block = _cpu.decodeBlock(pc, bank);
+    uint32_t length = 0;
+    while (length < block.instructions.size() && isTranslatable(block.instructions[length].opcode, block.instructions[length].operand))
+    {
+        length++;
+    }
+    if (length == 0)
+    {
+        return false;
+    }
+    if (length < MIN_BLOCK_LENGTH)
+    {
+        using IType = typename Cpu<BusType, Variant>::IType;
+        using AMode = typename Cpu<BusType, Variant>::AMode;
+        const auto& last = block.instructions[length - 1];
+        const auto& instruction = Cpu<BusType, Variant>::_opcodeVector[last.opcode];
+        bool loops = false;
+        if (instruction.addrMode == AMode::RELATIVE)
+        {
+            loops = static_cast<uint16_t>(last.pc + 2 + static_cast<int8_t>(last.operand)) == pc;
+        }
+        else if (instruction.type == IType::JMP || instruction.type == IType::JSR)
+        {
+            loops = last.operand == pc;
+        }
+        if (!loops)
+        {
+            return false;
+        }
+    }
+    std::vector<PendingExit> exits;
+
+    for (Reg reg : CALLEE_SAVED)
+    {
+        emitter.push(reg);
+    }
+    emitter.load64(REG_RAM, REG_STATE, offsetof(JitState, ram));
+    emitter.load64(REG_CYCLES, REG_STATE, offsetof(JitState, cycles));
+    emitter.load32(REG_INSTRUCTIONS, REG_STATE, offsetof(JitState, instructions));
+    emitter.loadByte(REG_A, REG_STATE, offsetof(JitState, a));
+    emitter.loadByte(REG_X, REG_STATE, offsetof(JitState, x));
+    emitter.loadByte(REG_Y, REG_STATE, offsetof(JitState, y));
+    emitter.loadByte(REG_SP, REG_STATE, offsetof(JitState, sp));
+    emitter.loadByte(REG_CARRY, REG_STATE, offsetof(JitState, carry));
+    emitter.loadByte(REG_ZERO, REG_STATE, offsetof(JitState, zero));
+    emitter.loadByte(REG_OVERFLOW, REG_STATE, offsetof(JitState, overflow));
+    emitter.loadByte(REG_NEGATIVE, REG_STATE, offsetof(JitState, negative));
+
+    // Every pass over the block checks that the whole block fits in the instruction budget
+    size_t loopStart = emitter.size();
+    emitter.load32(Reg::RCX, REG_STATE, offsetof(JitState, maxInstructions));
+    emitter.mov(Reg::RAX, REG_INSTRUCTIONS);
+    emitter.aluImm(AluOp::ADD, Reg::RAX, length);
+    emitter.alu(AluOp::CMP, Reg::RAX, Reg::RCX);
+    exits.push_back({emitter.jcc(Condition::A), pc, 0, false, false});
+
+    bool leftBlock = false;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        const auto& decoded = block.instructions[i];
+        leftBlock = emitInstruction(emitter, decoded.opcode, decoded.pc, decoded.operand, i, pc, length, loopStart, exits);
+    }
+    if (!leftBlock)
+    {
+        const auto& last = block.instructions[length - 1];
+        exits.push_back({emitter.jmp(), static_cast<uint16_t>(last.pc + last.length), length, false, false});
+    }
+
+    size_t commonExit = emitter.size();
+    emitter.storeWord(REG_STATE, offsetof(JitState, pc), Reg::RAX);
+    emitter.storeByte(REG_STATE, offsetof(JitState, a), REG_A);
+    emitter.storeByte(REG_STATE, offsetof(JitState, x), REG_X);
+    emitter.storeByte(REG_STATE, offsetof(JitState, y), REG_Y);
+    emitter.storeByte(REG_STATE, offsetof(JitState, sp), REG_SP);
+    emitter.storeByte(REG_STATE, offsetof(JitState, carry), REG_CARRY);
+    emitter.storeByte(REG_STATE, offsetof(JitState, zero), REG_ZERO);
+    emitter.storeByte(REG_STATE, offsetof(JitState, overflow), REG_OVERFLOW);
+    emitter.storeByte(REG_STATE, offsetof(JitState, negative), REG_NEGATIVE);
+    emitter.store64(REG_STATE, offsetof(JitState, cycles), REG_CYCLES);
+    emitter.store32(REG_STATE, offsetof(JitState, instructions), REG_INSTRUCTIONS);
+    for (auto reg = CALLEE_SAVED.rbegin(); reg != CALLEE_SAVED.rend(); reg++)
+    {
+        emitter.pop(*reg);
+    }
+    emitter.ret();
+
+    for (const PendingExit& exit : exits)
+    {
+        emitter.bind(exit.patch);
+        if (!exit.dynamicPc)
+        {
+            emitter.movImm(Reg::RAX, exit.pc);
+        }
+        if (exit.instructions > 0)
+        {
+            emitter.aluImm(AluOp::ADD, REG_INSTRUCTIONS, exit.instructions);
+        }
+        if (exit.mmio)
+        {
+            emitter.movImm(Reg::RCX, 1);
+            emitter.storeByte(REG_STATE, offsetof(JitState, mmioExit), Reg::RCX);
+        }
+        emitter.jmpTo(commonExit);
+    }
+    return true;
+}
+
+template <typename BusType, CpuVariant Variant>
+bool CpuJit<BusType, Variant>::emitInstruction(X86Emitter& emitter, uint8_t opcode, uint16_t pc, uint16_t operand, uint32_t index,
+    uint16_t blockStart, uint32_t blockLength, size_t loopStart, std::vector<PendingExit>& exits)
+{
+    using IType = typename Cpu<BusType, Variant>::IType;
+    using AMode = typename Cpu<BusType, Variant>::AMode;
+    const auto& instruction = Cpu<BusType, Variant>::_opcodeVector[opcode];
+    AMode addrMode = instruction.addrMode;
+    IType type = instruction.type;
+
+    bool accessesMemory = type != IType::JMP && type != IType::JSR && addrMode != AMode::IMM && addrMode != AMode::IMPLIED &&
+        addrMode != AMode::ACCUM && addrMode != AMode::RELATIVE;
+    Reg base = REG_RAM;
+    if (accessesMemory)
+    {
+        base = emitAddress(emitter, opcode, pc, operand, index, Cpu<BusType, Variant>::isReadInstruction(instruction.type), exits);
+    }
+    // From here on the instruction can't exit anymore so its cycles are accounted
+    emitter.aluImm64(AluOp::ADD, REG_CYCLES, instruction.cycles);
+
+    auto loadValue = [&]()
+    {
+        if (addrMode == AMode::IMM)
+        {
+            emitter.movImm(Reg::RCX, operand & 0xff);
+        }
+        else
+        {
+            emitter.loadByteIndexed(Reg::RCX, base, Reg::RAX);
+        }
+    };
+    auto setZeroNegative = [&](Reg reg)
+    {
+        emitter.mov(REG_ZERO, reg);
+        emitter.mov(REG_NEGATIVE, reg);
+    };
+    auto compare = [&](Reg reg)
+    {
+        loadValue();
+        emitter.alu(AluOp::XOR, REG_CARRY, REG_CARRY);
+        emitter.mov(Reg::RAX, reg);
+        emitter.alu(AluOp::SUB, Reg::RAX, Reg::RCX);
+        emitter.setcc(Condition::AE, REG_CARRY);
+        emitter.aluImm(AluOp::AND, Reg::RAX, 0xff);
+        setZeroNegative(Reg::RAX);
+    };
+    auto load = [&](Reg reg)
+    {
+        loadValue();
+        emitter.mov(reg, Reg::RCX);
+        setZeroNegative(reg);
+    };
+    auto increment = [&](Reg reg, AluOp op)
+    {
+        emitter.aluImm(op, reg, 1);
+        emitter.aluImm(AluOp::AND, reg, 0xff);
+        setZeroNegative(reg);
+    };
+    auto transfer = [&](Reg dst, Reg src)
+    {
+        emitter.mov(dst, src);
+        setZeroNegative(dst);
+    };
+    auto push = [&](Reg reg)
+    {
+        emitter.mov(Reg::RAX, REG_SP);
+        emitter.aluImm(AluOp::ADD, Reg::RAX, Cpu<BusType, Variant>::STACK_OFFSET);
+        emitter.storeByteIndexed(REG_RAM, Reg::RAX, reg);
+        emitter.aluImm(AluOp::SUB, REG_SP, 1);
+        emitter.aluImm(AluOp::AND, REG_SP, 0xff);
+    };
+    auto pull = [&](Reg reg)
+    {
+        emitter.aluImm(AluOp::ADD, REG_SP, 1);
+        emitter.aluImm(AluOp::AND, REG_SP, 0xff);
+        emitter.mov(Reg::RAX, REG_SP);
+        emitter.aluImm(AluOp::ADD, Reg::RAX, Cpu<BusType, Variant>::STACK_OFFSET);
+        emitter.loadByteIndexed(reg, REG_RAM, Reg::RAX);
+    };
+    // Shifts work on ecx and write the result back to where it was read from
+    auto shift = [&](auto operation)
+    {
+        if (addrMode == AMode::ACCUM)
+        {
+            emitter.mov(Reg::RCX, REG_A);
+        }
+        else
+        {
+            emitter.loadByteIndexed(Reg::RCX, REG_RAM, Reg::RAX);
+        }
+        operation();
+        setZeroNegative(Reg::RCX);
+        if (addrMode == AMode::ACCUM)
+        {
+            emitter.mov(REG_A, Reg::RCX);
+        }
+        else
+        {
+            emitter.storeByteIndexed(REG_RAM, Reg::RAX, Reg::RCX);
+        }
+    };
+    auto branch = [&](Condition notTaken)
+    {
+        uint16_t next = pc + 2;
+        uint16_t target = next + static_cast<int8_t>(operand);
+        exits.push_back({emitter.jcc(notTaken), next, index + 1, false, false});
+        emitter.aluImm64(AluOp::ADD, REG_CYCLES, ((target & 0xff00) != (next & 0xff00))? 2 : 1);
+        emitJump(emitter, target, blockStart, blockLength, loopStart, exits);
+    };
+
+    switch (type)
+    {
+    case IType::ADC:
+    case IType::SBC:
+        loadValue();
+        if (type == IType::SBC)
+        {
+            emitter.aluImm(AluOp::XOR, Reg::RCX, 0xff);
+        }
+        emitter.mov(Reg::RAX, REG_A);
+        emitter.alu(AluOp::ADD, Reg::RAX, Reg::RCX);
+        emitter.alu(AluOp::ADD, Reg::RAX, REG_CARRY);
+        emitter.mov(REG_CARRY, Reg::RAX);
+        emitter.shrImm(REG_CARRY, 8);
+        emitter.mov(Reg::RDX, REG_A);
+        emitter.alu(AluOp::XOR, Reg::RDX, Reg::RAX);
+        emitter.alu(AluOp::XOR, Reg::RCX, Reg::RAX);
+        emitter.alu(AluOp::AND, Reg::RDX, Reg::RCX);
+        emitter.mov(REG_OVERFLOW, Reg::RDX);
+        emitter.aluImm(AluOp::AND, Reg::RAX, 0xff);
+        transfer(REG_A, Reg::RAX);
+        break;
+    case IType::AND:
+    case IType::ORA:
+    case IType::EOR:
+        loadValue();
+        emitter.alu((type == IType::AND)? AluOp::AND : (type == IType::ORA)? AluOp::OR : AluOp::XOR, REG_A, Reg::RCX);
+        setZeroNegative(REG_A);
+        break;
+    case IType::BIT:
+        loadValue();
+        emitter.mov(REG_OVERFLOW, Reg::RCX);
+        emitter.shlImm(REG_OVERFLOW, 1);
+        emitter.mov(REG_NEGATIVE, Reg::RCX);
+        emitter.mov(REG_ZERO, REG_A);
+        emitter.alu(AluOp::AND, REG_ZERO, Reg::RCX);
+        break;
+    case IType::CMP:
+        compare(REG_A);
+        break;
+    case IType::CPX:
+        compare(REG_X);
+        break;
+    case IType::CPY:
+        compare(REG_Y);
+        break;
+    case IType::LDA:
+        load(REG_A);
+        break;
+    case IType::LDX:
+        load(REG_X);
+        break;
+    case IType::LDY:
+        load(REG_Y);
+        break;
+    case IType::STA:
+        emitter.storeByteIndexed(REG_RAM, Reg::RAX, REG_A);
+        break;
+    case IType::STX:
+        emitter.storeByteIndexed(REG_RAM, Reg::RAX, REG_X);
+        break;
+    case IType::STY:
+        emitter.storeByteIndexed(REG_RAM, Reg::RAX, REG_Y);
+        break;
+    case IType::INC:
+    case IType::DEC:
+        emitter.loadByteIndexed(Reg::RCX, REG_RAM, Reg::RAX);
+        increment(Reg::RCX, (type == IType::INC)? AluOp::ADD : AluOp::SUB);
+        emitter.storeByteIndexed(REG_RAM, Reg::RAX, Reg::RCX);
+        break;
+    case IType::INX:
+        increment(REG_X, AluOp::ADD);
+        break;
+    case IType::INY:
+        increment(REG_Y, AluOp::ADD);
+        break;
+    case IType::DEX:
+        increment(REG_X, AluOp::SUB);
+        break;
+    case IType::DEY:
+        increment(REG_Y, AluOp::SUB);
+        break;
+    case IType::ASL:
+        shift([&]()
+        {
+            emitter.shlImm(Reg::RCX, 1);
+            emitter.mov(REG_CARRY, Reg::RCX);
+            emitter.shrImm(REG_CARRY, 8);
+            emitter.aluImm(AluOp::AND, Reg::RCX, 0xff);
+        });
+        break;
+    case IType::LSR:
+        shift([&]()
+        {
+            emitter.mov(REG_CARRY, Reg::RCX);
+            emitter.aluImm(AluOp::AND, REG_CARRY, 1);
+            emitter.shrImm(Reg::RCX, 1);
+        });
+        break;
+    case IType::ROL:
+        shift([&]()
+        {
+            emitter.shlImm(Reg::RCX, 1);
+            emitter.alu(AluOp::OR, Reg::RCX, REG_CARRY);
+            emitter.mov(REG_CARRY, Reg::RCX);
+            emitter.shrImm(REG_CARRY, 8);
+            emitter.aluImm(AluOp::AND, Reg::RCX, 0xff);
+        });
+        break;
+    case IType::ROR:
+        shift([&]()
+        {
+            emitter.mov(Reg::RDX, REG_CARRY);
+            emitter.shlImm(Reg::RDX, 7);
+            emitter.mov(REG_CARRY, Reg::RCX);
+            emitter.aluImm(AluOp::AND, REG_CARRY, 1);
+            emitter.shrImm(Reg::RCX, 1);
+            emitter.alu(AluOp::OR, Reg::RCX, Reg::RDX);
+        });
+        break;
+    case IType::TAX:
+        transfer(REG_X, REG_A);
+        break;
+    case IType::TAY:
+        transfer(REG_Y, REG_A);
+        break;
+    case IType::TXA:
+        transfer(REG_A, REG_X);
+        break;
+    case IType::TYA:
+        transfer(REG_A, REG_Y);
+        break;
+    case IType::TSX:
+        transfer(REG_X, REG_SP);
+        break;
+    case IType::TXS:
+        emitter.mov(REG_SP, REG_X);
+        break;
+    case IType::CLC:
+        emitter.alu(AluOp::XOR, REG_CARRY, REG_CARRY);
+        break;
+    case IType::SEC:
+        emitter.movImm(REG_CARRY, 1);
+        break;
+    case IType::CLV:
+        emitter.alu(AluOp::XOR, REG_OVERFLOW, REG_OVERFLOW);
+        break;
+    case IType::PHA:
+        push(REG_A);
+        break;
+    case IType::PLA:
+        pull(REG_A);
+        setZeroNegative(REG_A);
+        break;
+    case IType::BCC:
+        emitter.test(REG_CARRY, REG_CARRY);
+        branch(Condition::NE);
+        return true;
+    case IType::BCS:
+        emitter.test(REG_CARRY, REG_CARRY);
+        branch(Condition::E);
+        return true;
+    case IType::BEQ:
+        emitter.test(REG_ZERO, REG_ZERO);
+        branch(Condition::NE);
+        return true;
+    case IType::BNE:
+        emitter.test(REG_ZERO, REG_ZERO);
+        branch(Condition::E);
+        return true;
+    case IType::BMI:
+        emitter.testImm(REG_NEGATIVE, 0x80);
+        branch(Condition::E);
+        return true;
+    case IType::BPL:
+        emitter.testImm(REG_NEGATIVE, 0x80);
+        branch(Condition::NE);
+        return true;
+    case IType::BVS:
+        emitter.testImm(REG_OVERFLOW, 0x80);
+        branch(Condition::E);
+        return true;
+    case IType::BVC:
+        emitter.testImm(REG_OVERFLOW, 0x80);
+        branch(Condition::NE);
+        return true;
+    case IType::JMP:
+        emitJump(emitter, operand, blockStart, blockLength, loopStart, exits);
+        return true;
+    case IType::JSR:
+        // The return address pushed is the last byte of the jsr
+        emitter.movImm(Reg::RCX, ((pc + 2) >> 8) & 0xff);
+        push(Reg::RCX);
+        emitter.movImm(Reg::RCX, (pc + 2) & 0xff);
+        push(Reg::RCX);
+        emitJump(emitter, operand, blockStart, blockLength, loopStart, exits);
+        return true;
+    case IType::RTS:
+        pull(Reg::RDX);
+        pull(Reg::RCX);
+        emitter.shlImm(Reg::RCX, 8);
+        emitter.alu(AluOp::OR, Reg::RDX, Reg::RCX);
+        emitter.aluImm(AluOp::ADD, Reg::RDX, 1);
+        emitter.aluImm(AluOp::AND, Reg::RDX, 0xffff);
+        emitter.mov(Reg::RAX, Reg::RDX);
+        exits.push_back({emitter.jmp(), 0, index + 1, false, true});
+        return true;
+    default:
+        // NOP
+        break;
+    }
+    return false;
+}
+
+template <typename BusType, CpuVariant Variant>
+X86Emitter::Reg CpuJit<BusType, Variant>::emitAddress(X86Emitter& emitter, uint8_t opcode, uint16_t pc, uint16_t operand, uint32_t index,
+    bool pagePenalty, std::vector<PendingExit>& exits)
+{
+    using AMode = typename Cpu<BusType, Variant>::AMode;
+    AMode addrMode = Cpu<BusType, Variant>::_opcodeVector[opcode].addrMode;
+    Reg indexReg = (addrMode == AMode::I_ZP_Y || addrMode == AMode::I_ABSOLUTE_Y || addrMode == AMode::INDIRECT_I)? REG_Y : REG_X;
+    // Only read instructions pay the page penalty so they are also the only ones that may read the rom
+    const uint8_t* rom = nullptr;
+    switch (addrMode)
+    {
+    case AMode::ZP:
+        emitter.movImm(Reg::RAX, operand & 0xff);
+        return REG_RAM;
+    case AMode::ABSOLUTE:
+        if (operand >= RAM_MEMORY_RANGE)
+        {
+            emitter.movImm64(Reg::RCX, reinterpret_cast<uint64_t>(romPointer(operand, 1)));
+            emitter.movImm(Reg::RAX, 0);
+            return Reg::RCX;
+        }
+        emitter.movImm(Reg::RAX, operand & TRUE_RAM_MASK);
+        return REG_RAM;
+    case AMode::I_ZP_X:
+    case AMode::I_ZP_Y:
+        emitter.mov(Reg::RAX, indexReg);
+        emitter.aluImm(AluOp::ADD, Reg::RAX, operand & 0xff);
+        emitter.aluImm(AluOp::AND, Reg::RAX, 0xff);
+        return REG_RAM;
+    case AMode::I_ABSOLUTE_X:
+    case AMode::I_ABSOLUTE_Y:
+        if (pagePenalty)
+        {
+            // The page is crossed when the index carries out of the low byte of the operand
+            emitter.alu(AluOp::XOR, Reg::RDX, Reg::RDX);
+            emitter.aluImm(AluOp::CMP, indexReg, 0xff - (operand & 0xff));
+            emitter.setcc(Condition::A, Reg::RDX);
+            rom = romPointer(operand, 0x100);
+        }
+        if (rom != nullptr)
+        {
+            // Every address the index can reach is in the same rom so the index is the offset
+            emitter.mov(Reg::RAX, indexReg);
+            emitter.movImm64(Reg::RCX, reinterpret_cast<uint64_t>(rom));
+            emitter.alu64(AluOp::ADD, REG_CYCLES, Reg::RDX);
+            return Reg::RCX;
+        }
+        emitter.mov(Reg::RAX, indexReg);
+        emitter.aluImm(AluOp::ADD, Reg::RAX, operand);
+        emitter.aluImm(AluOp::AND, Reg::RAX, 0xffff);
+        break;
+    case AMode::I_INDIRECT:
+        emitter.mov(Reg::RCX, REG_X);
+        emitter.aluImm(AluOp::ADD, Reg::RCX, operand & 0xff);
+        emitter.aluImm(AluOp::AND, Reg::RCX, 0xff);
+        emitter.loadByteIndexed(Reg::RAX, REG_RAM, Reg::RCX);
+        emitter.aluImm(AluOp::ADD, Reg::RCX, 1);
+        emitter.aluImm(AluOp::AND, Reg::RCX, 0xff);
+        emitter.loadByteIndexed(Reg::RCX, REG_RAM, Reg::RCX);
+        emitter.shlImm(Reg::RCX, 8);
+        emitter.alu(AluOp::OR, Reg::RAX, Reg::RCX);
+        break;
+    case AMode::INDIRECT_I:
+        emitter.loadByte(Reg::RAX, REG_RAM, operand & 0xff);
+        emitter.loadByte(Reg::RCX, REG_RAM, (operand + 1) & 0xff);
+        emitter.shlImm(Reg::RCX, 8);
+        emitter.alu(AluOp::OR, Reg::RAX, Reg::RCX);
+        if (pagePenalty)
+        {
+            emitter.mov(Reg::RDX, Reg::RAX);
+            emitter.aluImm(AluOp::AND, Reg::RDX, 0xff);
+            emitter.alu(AluOp::ADD, Reg::RDX, REG_Y);
+            emitter.shrImm(Reg::RDX, 8);
+        }
+        emitter.alu(AluOp::ADD, Reg::RAX, REG_Y);
+        emitter.aluImm(AluOp::AND, Reg::RAX, 0xffff);
+        break;
+    default:
+        return REG_RAM;
+    }
+    // Anything that isn't ram is left for the interpreter, the instruction hasn't changed any state yet
+    emitter.aluImm(AluOp::CMP, Reg::RAX, RAM_MEMORY_RANGE);
+    exits.push_back({emitter.jcc(Condition::AE), pc, index, true, false});
+    emitter.aluImm(AluOp::AND, Reg::RAX, TRUE_RAM_MASK);
+    if (pagePenalty && addrMode != AMode::I_INDIRECT)
+    {
+        emitter.alu64(AluOp::ADD, REG_CYCLES, Reg::RDX);
+    }
+    return REG_RAM;
+}
+
+template <typename BusType, CpuVariant Variant>
+void CpuJit<BusType, Variant>::emitJump(X86Emitter& emitter, uint16_t target, uint16_t blockStart, uint32_t blockLength, size_t loopStart,
+    std::vector<PendingExit>& exits)
+{
+    if (target == blockStart)
+    {
+        emitter.aluImm(AluOp::ADD, REG_INSTRUCTIONS, blockLength);
+        emitter.jmpTo(loopStart);
+    }
+    else
+    {
+        exits.push_back({emitter.jmp(), target, blockLength, false, false});
+    }
+}
+
+template class CpuJit<Bus, Ricoh2A03>;
+template class CpuJit<FunctionalCpuBus, Ricoh2A03>;
+template class CpuJit<FunctionalCpuBus, Mos6502>;
+
+#endif // CPU_JIT
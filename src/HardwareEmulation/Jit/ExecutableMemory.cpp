@@ -0,0 +1,58 @@
+#ifdef CPU_JIT
+
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+#include "HardwareEmulation/Jit/ExecutableMemory.hpp"
+
+ExecutableMemory::ExecutableMemory(size_t size)
+{
+    _size = size;
+    _used = 0;
+    void* memory = mmap(nullptr, _size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map jit code memory");
+    }
+    _memory = static_cast<uint8_t*>(memory);
+}
+
+ExecutableMemory::~ExecutableMemory()
+{
+    munmap(_memory, _size);
+}
+
+const uint8_t* ExecutableMemory::commit(const std::vector<uint8_t>& code)
+{
+    // Keep every block 16 byte aligned
+    size_t start = (_used + 15) & ~static_cast<size_t>(15);
+    if (start + code.size() > _size)
+    {
+        return nullptr;
+    }
+    if (mprotect(_memory, _size, PROT_READ | PROT_WRITE) != 0)
+    {
+        throw std::runtime_error("Failed to make the jit code memory writable");
+    }
+    std::memcpy(_memory + start, code.data(), code.size());
+    if (mprotect(_memory, _size, PROT_READ | PROT_EXEC) != 0)
+    {
+        throw std::runtime_error("Failed to make the jit code memory executable");
+    }
+    _used = start + code.size();
+    return _memory + start;
+}
+
+void ExecutableMemory::reset()
+{
+    _used = 0;
+}
+
+size_t ExecutableMemory::used() const
+{
+    return _used;
+}
+
+#endif // CPU_JIT
@@ -0,0 +1,284 @@
+#include "HardwareEmulation/Jit/X86Emitter.hpp"
+
+static uint8_t Index(X86Emitter::Reg reg)
+{
+    return static_cast<uint8_t>(reg);
+}
+
+const std::vector<uint8_t>& X86Emitter::code() const
+{
+    return _code;
+}
+
+size_t X86Emitter::size() const
+{
+    return _code.size();
+}
+
+void X86Emitter::mov(Reg dst, Reg src)
+{
+    rex(false, Index(src), 0, Index(dst));
+    emit8(0x89);
+    modRmReg(Index(src), Index(dst));
+}
+
+void X86Emitter::movImm(Reg dst, uint32_t imm)
+{
+    rex(false, 0, 0, Index(dst));
+    emit8(0xb8 + (Index(dst) & 7));
+    emit32(imm);
+}
+
+void X86Emitter::movImm64(Reg dst, uint64_t imm)
+{
+    rex(true, 0, 0, Index(dst));
+    emit8(0xb8 + (Index(dst) & 7));
+    emit32(imm & 0xffffffff);
+    emit32(imm >> 32);
+}
+
+void X86Emitter::alu(AluOp op, Reg dst, Reg src)
+{
+    rex(false, Index(src), 0, Index(dst));
+    emit8((static_cast<uint8_t>(op) << 3) | 0x01);
+    modRmReg(Index(src), Index(dst));
+}
+
+void X86Emitter::aluImm(AluOp op, Reg dst, int32_t imm)
+{
+    rex(false, 0, 0, Index(dst));
+    emit8(0x81);
+    modRmReg(static_cast<uint8_t>(op), Index(dst));
+    emit32(imm);
+}
+
+void X86Emitter::alu64(AluOp op, Reg dst, Reg src)
+{
+    rex(true, Index(src), 0, Index(dst));
+    emit8((static_cast<uint8_t>(op) << 3) | 0x01);
+    modRmReg(Index(src), Index(dst));
+}
+
+void X86Emitter::aluImm64(AluOp op, Reg dst, int32_t imm)
+{
+    rex(true, 0, 0, Index(dst));
+    emit8(0x81);
+    modRmReg(static_cast<uint8_t>(op), Index(dst));
+    emit32(imm);
+}
+
+void X86Emitter::shlImm(Reg dst, uint8_t count)
+{
+    rex(false, 0, 0, Index(dst));
+    emit8(0xc1);
+    modRmReg(4, Index(dst));
+    emit8(count);
+}
+
+void X86Emitter::shrImm(Reg dst, uint8_t count)
+{
+    rex(false, 0, 0, Index(dst));
+    emit8(0xc1);
+    modRmReg(5, Index(dst));
+    emit8(count);
+}
+
+void X86Emitter::test(Reg dst, Reg src)
+{
+    rex(false, Index(src), 0, Index(dst));
+    emit8(0x85);
+    modRmReg(Index(src), Index(dst));
+}
+
+void X86Emitter::testImm(Reg dst, uint32_t imm)
+{
+    rex(false, 0, 0, Index(dst));
+    emit8(0xf7);
+    modRmReg(0, Index(dst));
+    emit32(imm);
+}
+
+void X86Emitter::setcc(Condition condition, Reg dst)
+{
+    rex(false, 0, 0, Index(dst), true);
+    emit8(0x0f);
+    emit8(0x90 | static_cast<uint8_t>(condition));
+    modRmReg(0, Index(dst));
+}
+
+void X86Emitter::loadByte(Reg dst, Reg base, int32_t disp)
+{
+    rex(false, Index(dst), 0, Index(base));
+    emit8(0x0f);
+    emit8(0xb6);
+    modRmMemory(Index(dst), Index(base), disp);
+}
+
+void X86Emitter::loadByteIndexed(Reg dst, Reg base, Reg index)
+{
+    rex(false, Index(dst), Index(index), Index(base));
+    emit8(0x0f);
+    emit8(0xb6);
+    modRmIndexed(Index(dst), Index(base), Index(index));
+}
+
+void X86Emitter::storeByte(Reg base, int32_t disp, Reg src)
+{
+    rex(false, Index(src), 0, Index(base), true);
+    emit8(0x88);
+    modRmMemory(Index(src), Index(base), disp);
+}
+
+void X86Emitter::storeByteIndexed(Reg base, Reg index, Reg src)
+{
+    rex(false, Index(src), Index(index), Index(base), true);
+    emit8(0x88);
+    modRmIndexed(Index(src), Index(base), Index(index));
+}
+
+void X86Emitter::loadWord(Reg dst, Reg base, int32_t disp)
+{
+    rex(false, Index(dst), 0, Index(base));
+    emit8(0x0f);
+    emit8(0xb7);
+    modRmMemory(Index(dst), Index(base), disp);
+}
+
+void X86Emitter::storeWord(Reg base, int32_t disp, Reg src)
+{
+    emit8(0x66);
+    rex(false, Index(src), 0, Index(base));
+    emit8(0x89);
+    modRmMemory(Index(src), Index(base), disp);
+}
+
+void X86Emitter::load32(Reg dst, Reg base, int32_t disp)
+{
+    rex(false, Index(dst), 0, Index(base));
+    emit8(0x8b);
+    modRmMemory(Index(dst), Index(base), disp);
+}
+
+void X86Emitter::store32(Reg base, int32_t disp, Reg src)
+{
+    rex(false, Index(src), 0, Index(base));
+    emit8(0x89);
+    modRmMemory(Index(src), Index(base), disp);
+}
+
+void X86Emitter::load64(Reg dst, Reg base, int32_t disp)
+{
+    rex(true, Index(dst), 0, Index(base));
+    emit8(0x8b);
+    modRmMemory(Index(dst), Index(base), disp);
+}
+
+void X86Emitter::store64(Reg base, int32_t disp, Reg src)
+{
+    rex(true, Index(src), 0, Index(base));
+    emit8(0x89);
+    modRmMemory(Index(src), Index(base), disp);
+}
+
+void X86Emitter::push(Reg reg)
+{
+    rex(false, 0, 0, Index(reg));
+    emit8(0x50 + (Index(reg) & 7));
+}
+
+void X86Emitter::pop(Reg reg)
+{
+    rex(false, 0, 0, Index(reg));
+    emit8(0x58 + (Index(reg) & 7));
+}
+
+void X86Emitter::ret()
+{
+    emit8(0xc3);
+}
+
+size_t X86Emitter::jcc(Condition condition)
+{
+    emit8(0x0f);
+    emit8(0x80 | static_cast<uint8_t>(condition));
+    emit32(0);
+    return _code.size() - 4;
+}
+
+size_t X86Emitter::jmp()
+{
+    emit8(0xe9);
+    emit32(0);
+    return _code.size() - 4;
+}
+
+void X86Emitter::bind(size_t patch)
+{
+    patch32(patch, _code.size() - (patch + 4));
+}
+
+void X86Emitter::jccTo(Condition condition, size_t target)
+{
+    size_t patch = jcc(condition);
+    patch32(patch, target - (patch + 4));
+}
+
+void X86Emitter::jmpTo(size_t target)
+{
+    size_t patch = jmp();
+    patch32(patch, target - (patch + 4));
+}
+
+void X86Emitter::emit8(uint8_t value)
+{
+    _code.push_back(value);
+}
+
+void X86Emitter::emit32(uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        _code.push_back((value >> (8 * i)) & 0xff);
+    }
+}
+
+void X86Emitter::rex(bool wide, uint8_t reg, uint8_t index, uint8_t base, bool byteOperand)
+{
+    uint8_t prefix = 0x40 | (wide << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+    // Byte operands always get a prefix so registers 4-7 mean spl, bpl, sil and dil instead of ah, ch, dh and bh
+    if (prefix != 0x40 || byteOperand)
+    {
+        emit8(prefix);
+    }
+}
+
+void X86Emitter::modRmReg(uint8_t reg, uint8_t rm)
+{
+    emit8(0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void X86Emitter::modRmMemory(uint8_t reg, uint8_t base, int32_t disp)
+{
+    emit8(0x80 | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == Index(Reg::RSP))
+    {
+        emit8(0x24);
+    }
+    emit32(disp);
+}
+
+void X86Emitter::modRmIndexed(uint8_t reg, uint8_t base, uint8_t index)
+{
+    // Always uses an 8 bit displacement of 0 since rbp and r13 can't be a base without one
+    emit8(0x44 | ((reg & 7) << 3));
+    emit8(((index & 7) << 3) | (base & 7));
+    emit8(0);
+}
+
+void X86Emitter::patch32(size_t position, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        _code[position + i] = (value >> (8 * i)) & 0xff;
+    }
+}
@@ -51,4 +51,42 @@ bool Mapper0::ppuReadMap(uint16_t address, uint8_t& data)
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
+
+int32_t Mapper0::getPrgBankId(uint16_t address)
+{
+    if (address >= 0x8000 && address <= 0xffff)
+    {
+        return (_prgRomBankVector.size() > 1 && address >= 0xc000)? 1 : 0;
+    }
+    return -1;
+}
+
+const uint8_t* Mapper0::getPrgPointer(uint16_t address)
+{
+    int32_t bank = getPrgBankId(address);
+    if (bank < 0)
+    {
+        return nullptr;
+    }
+    return &_prgRomBankVector[bank][(address - 0x8000) % 0x4000];
+}
+
+int32_t Mapper0::getPrgRomOffset(uint16_t address)
+{
+    int32_t bank = getPrgBankId(address);
+    if (bank < 0)
+    {
+        return -1;
+    }
+    return bank * PRG_ROM_BANK_SIZE + (address - 0x8000) % 0x4000;
+}
+
+int32_t Mapper0::getChrRomOffset(uint16_t address)
+{
+    if (address <= 0x1fff && !_chrRomBankVector.empty())
+    {
+        return address;
+    }
+    return -1;
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+#include "HardwareEmulation/MemoryHeatmap.hpp"
+
+MemoryHeatmap::MemoryHeatmap(uint32_t size) :
+    _reads(size, 0),
+    _writes(size, 0),
+    _executes(size, 0)
+{
+}
+
+uint32_t MemoryHeatmap::getSize() const
+{
+    return _reads.size();
+}
+
+const std::vector<uint32_t>& MemoryHeatmap::getReads() const
+{
+    return _reads;
+}
+
+const std::vector<uint32_t>& MemoryHeatmap::getWrites() const
+{
+    return _writes;
+}
+
+const std::vector<uint32_t>& MemoryHeatmap::getExecutes() const
+{
+    return _executes;
+}
+
+void MemoryHeatmap::reset()
+{
+    std::fill(_reads.begin(), _reads.end(), 0);
+    std::fill(_writes.begin(), _writes.end(), 0);
+    std::fill(_executes.begin(), _executes.end(), 0);
+}
+
+void MemoryHeatmap::writeCsv(std::ostream& stream) const
+{
+    stream << "address,reads,writes,executes" << std::endl;
+    for (uint32_t address = 0; address < _reads.size(); address++)
+    {
+        if (_reads[address] == 0 && _writes[address] == 0 && _executes[address] == 0)
+        {
+            continue;
+        }
+        stream << std::hex << std::setw(4) << std::setfill('0') << address << std::dec << "," << _reads[address] << "," <<
+            _writes[address] << "," << _executes[address] << "\n";
+    }
+    stream.flush();
+}
+
+void MemoryHeatmap::writeBinary(std::ostream& stream) const
+{
+    BinaryHeader header = {};
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.size = _reads.size();
+    header.counterSize = sizeof(uint32_t);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const std::vector<uint32_t>* counters : {&_reads, &_writes, &_executes})
+    {
+        stream.write(reinterpret_cast<const char*>(counters->data()), counters->size() * sizeof(uint32_t));
+    }
+}
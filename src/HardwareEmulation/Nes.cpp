@@ -15,17 +15,32 @@ Nes::Nes() :
 {
     _wm.AddNewWindow(std::make_shared<FileLoadingWindow>(std::bind(&Nes::InsertNewCartridge, this ,std::placeholders::_1)));
     _wm.AddNewWindow(std::make_shared<MemoryWindow>(_bus.getRamView()));
-    //_wm.AddNewWindow(std::make_shared<PaletteWindow>(_bus._ppu.getPalette(), std::bind(&Ppu::getWorkPaletteRgb, &(_bus._ppu),std::placeholders::_1)));
-    _screen = std::make_shared<ScreenWindow>(_bus._ppu.getScreen());
+    //_wm.AddNewWindow(std::make_shared<PaletteWindow>(_bus._ppu.getPalette(), std::bind(&Ppu<Bus>::getWorkPaletteRgb, &(_bus._ppu),std::placeholders::_1)));
+    // The window thread publishes the buttons, the emulation thread latches them when the game strobes the joypad
+    _screen = std::make_shared<ScreenWindow>(_bus._ppu.getScreen(), std::bind(&Controller::setButtons, &_bus.getController(0), std::placeholders::_1));
     _wm.AddNewWindow(_screen);
-    //_wm.AddNewWindow(std::make_shared<PatternWindow>(std::bind(&Ppu::getPatternTable, &(_bus._ppu),std::placeholders::_1)));
+    //_wm.AddNewWindow(std::make_shared<PatternWindow>(std::bind(&Ppu<Bus>::getPatternTable, &(_bus._ppu),std::placeholders::_1)));
     _runMasterClock = false;
+    #ifdef CPU_TRACE
+    _bus._cpu.setJamHandler([this]()
+    {
+        std::cerr << "The cpu jammed, the trace was written to " << TRACE_DUMP_PATH << std::endl;
+        _bus.writeTraceDump(TRACE_DUMP_PATH);
+    });
+    #endif // CPU_TRACE
+}
+
+Nes::~Nes()
+{
+    if (_disassemblyThread.joinable())
+    {
+        _disassemblyThread.join();
+    }
 }
 
 void Nes::StartNesEmulation()
 {
     bool run_flag = true;
-    uint32_t clc = 0;
     _wmThread = std::thread([&]()
     {
         _wm.EmuWindowManagerEventLoop();
@@ -40,23 +55,24 @@ void Nes::StartNesEmulation()
     //Nes::InsertNewCartridge("/home/a/Desktop/smb.nes");
     //#endif // NESTEST_DEBUG
 
-    while (run_flag)
+    try
     {
-        if (_runMasterClock)
+        while (run_flag)
         {
-            _bus._ppu.clock();
-            if (clc % 3 == 0)
+            if (_runMasterClock)
             {
-                _bus._cpu.cpuExecuteInstruction();
+                _bus.clockLazy();
             }
-            if (_bus._ppu.nmi)
-            {
-                _bus._ppu.nmi = false;
-                _bus._cpu.Nmi();
-            }
-            clc++;
         }
     }
+    catch (const std::exception& e)
+    {
+        #ifdef CPU_TRACE
+        std::cerr << e.what() << ", the trace was written to " << TRACE_DUMP_PATH << std::endl;
+        _bus.writeTraceDump(TRACE_DUMP_PATH);
+        #endif // CPU_TRACE
+        throw;
+    }
 }
 
 void Nes::InsertNewCartridge(std::string file_path)
@@ -67,15 +83,20 @@ void Nes::InsertNewCartridge(std::string file_path)
     _bus.removeCartridge();
     _bus.insertCartridge(std::move(file));
     
-    auto diss = _bus._cpu.disassemble();
-    // replace w_bus.ith dissasmbly window
-    std::ofstream fs(DISSASMBLY_LOG_PATH);
-    for (auto line = diss.begin(); line != diss.end(); ++line)
-    {  
-        //std::cout << line->second << std::endl;
-        fs << line->second << std::endl;
+    // Only copying the rom holds up the load, the disassembly and the log are written in the background
+    auto disassembler = std::make_shared<CpuDisassembler<Bus>>(_bus._cpu);
+    disassembler->captureRom();
+    if (_disassemblyThread.joinable())
+    {
+        _disassemblyThread.join();
     }
-    fs.close();
+    _disassemblyThread = std::thread([disassembler]()
+    {
+        disassembler->disassemble();
+        // replace with dissasmbly window
+        std::ofstream fs(DISSASMBLY_LOG_PATH);
+        disassembler->writeLog(fs);
+    });
     _bus._cpu.cpuReset();
     _runMasterClock = true;
     // reset cpu
@@ -1,14 +1,40 @@
 #include <fstream>
+#include <algorithm>
 #include <cstring>
+#include <stdexcept>
 #include "HardwareEmulation/Ppu.hpp"
+#include "HardwareEmulation/Bus.hpp"
 
-Ppu::Ppu(WriteFunction bus_write, ReadFunction bus_read) :
-    _busRead(std::move(bus_read)), _busWrite(std::move(bus_write))
+// Spreads the bits of a bitplane to the even bits of a decoded row
+static uint16_t SpreadPlane(uint8_t plane)
+{
+    uint16_t bits = plane;
+    bits = (bits | (bits << 4)) & 0x0f0f;
+    bits = (bits | (bits << 2)) & 0x3333;
+    bits = (bits | (bits << 1)) & 0x5555;
+    return bits;
+}
+
+// The bitplane of a decoded row, plane 0 holds the low bits of the pixels
+static uint8_t GatherPlane(uint16_t row, uint8_t plane)
+{
+    uint16_t bits = (row >> plane) & 0x5555;
+    bits = (bits | (bits >> 1)) & 0x3333;
+    bits = (bits | (bits >> 2)) & 0x0f0f;
+    bits = (bits | (bits >> 4)) & 0x00ff;
+    return bits;
+}
+
+template <typename BusType>
+Ppu<BusType>::Ppu(BusType& bus) requires PpuBus<BusType> :
+    _bus(bus)
 {
     std::memset(_workPaletteSet.data(), 0, sizeof(_workPaletteSet));
     std::memset(_paletteTable.data(), 0, sizeof(_paletteTable));
     std::memset(_patternTable.data(), 0, sizeof(_patternTable));
+    std::memset(_decodedTileValid.data(), 0, sizeof(_decodedTileValid));
     std::memset(_screen.data(), 0, sizeof(_screen));
+    std::memset(_oam.data(), 0, sizeof(_oam));
     
     std::ifstream pFile(std::string(RESOURCE_PATH) + "/palettes/NES_Classic.pal", std::ios::binary);
     std::array<uint8_t, 3> pBuffer;
@@ -25,14 +51,23 @@ Ppu::Ppu(WriteFunction bus_write, ReadFunction bus_read) :
         throw std::runtime_error("Palette file is too small");
     }
     reset();
+    setScanlineRendererEnabled(true);
 }
 
-void Ppu::reset()
+template <typename BusType>
+void Ppu<BusType>::reset()
 {
     _ignoreCtrlFlagW = false;
+    _ctrl.data = 0;
+    _mask.data = 0;
+    _status.data = 0;
+    _readBuffer = 0;
+    _w = false;
+    _immediateRead = false;
     _oddFrame = true;
     _scanLine = 0;
     _cycle = 0;
+    _lineDeferred = false;
     _loPtShift = 0;
     _hiPtShift = 0;
     _loAtShift = 0;
@@ -45,48 +80,49 @@ void Ppu::reset()
     _nmi = false;
     _ntByte = 0;
     _atByte = 0;
+    _oamAddr = 0;
 }
 
-std::span<const uint32_t> Ppu::getPalette()
+template <typename BusType>
+std::span<const uint32_t> Ppu<BusType>::getPalette()
 {
     return std::span<uint32_t>(_paletteTable.begin(), _paletteTable.size());
 }
 
-std::array<std::array<uint32_t, 0x4000>, 2> Ppu::getPatternTable(uint8_t paletteId)
+template <typename BusType>
+std::array<std::array<uint32_t, 0x4000>, 2> Ppu<BusType>::getPatternTable(uint8_t paletteId)
 {
     std::array<std::array<uint32_t, 0x4000>, 2> arr;
-    uint8_t vecI = 0;
-    uint32_t tileY = 0;
-    for (uint32_t i = PPU_PATTERN_ADDR_START; i < PPU_PATTERN_ADDR_END;)
+    std::array<uint32_t, 4> colors;
+    for (uint8_t i = 0; i < colors.size(); i++)
+    {
+        colors[i] = getRgbForPixel(paletteId, i);
+    }
+    for (uint32_t tile = 0; tile < _decodedTiles.size(); tile++)
     {
-        for (uint32_t tile = 0; tile < 16; tile++)
+        #ifdef MEMORY_HEATMAP
+        for (uint32_t i = 0; i < 16; i++)
         {
-            for (uint32_t y = 0; y < 8; y++)
-            {
-                uint8_t lo = ppuRead(i, false);
-                uint8_t hi = ppuRead(i + 8, false);
-                for (uint32_t x = 0; x < 8; x++)
-                {
-                    uint8_t colorInPal = (lo & 0x1) | ((hi & 0x1) << 1);
-                    arr[vecI][7 - x + tile * 8 + 128 * y + tileY * 0x400] = getRgbForPixel(paletteId, colorInPal);
-                    lo >>= 1;
-                    hi >>= 1;
-                }
-                i++;
-            }
-            i += 8;
+            _heatmap.countRead(tile * 16 + i);
         }
-        tileY++;
-        if (i == 0x1000)
+        #endif // MEMORY_HEATMAP
+        const DecodedTile& rows = getDecodedTile(tile);
+        // Each table is 16 by 16 tiles
+        uint32_t tileX = tile % 16;
+        uint32_t tileY = (tile / 16) % 16;
+        for (uint32_t y = 0; y < 8; y++)
         {
-            vecI = 1;
-            tileY = 0;
+            for (uint32_t x = 0; x < 8; x++)
+            {
+                arr[tile / 256][x + tileX * 8 + 128 * y + tileY * 0x400] = colors[(rows[y] >> (14 - x * 2)) & 0x3];
+            }
         }
     }
     return arr;
 }
 
-std::array<uint32_t, 4> Ppu::getWorkPaletteRgb(uint8_t paletteId)
+template <typename BusType>
+std::array<uint32_t, 4> Ppu<BusType>::getWorkPaletteRgb(uint8_t paletteId)
 {
     std::array<uint32_t, 4> arr;
     paletteId %= 8;
@@ -98,14 +134,46 @@ std::array<uint32_t, 4> Ppu::getWorkPaletteRgb(uint8_t paletteId)
     return arr;
 }
 
-std::span<const uint32_t> Ppu::getScreen()
+template <typename BusType>
+std::span<const uint32_t> Ppu<BusType>::getScreen()
 {
     return std::span<uint32_t>(_screen.begin(), _screen.size());
 }
 
-void Ppu::writeToRegister(uint16_t address, uint8_t data)
+#ifdef MEMORY_HEATMAP
+
+template <typename BusType>
+MemoryHeatmap& Ppu<BusType>::getHeatmap()
+{
+    return _heatmap;
+}
+
+#endif // MEMORY_HEATMAP
+
+template <typename BusType>
+void Ppu<BusType>::writeOam(std::span<const uint8_t, 0x100> page)
+{
+    // The copy wraps around the end of the oam back to its start
+    auto split = page.begin() + (_oam.size() - _oamAddr);
+    std::copy(page.begin(), split, _oam.begin() + _oamAddr);
+    std::copy(split, page.end(), _oam.begin());
+}
+
+template <typename BusType>
+std::span<const uint8_t> Ppu<BusType>::getOam() const
 {
-    address &= 0xf;
+    return std::span<const uint8_t>(_oam.begin(), _oam.size());
+}
+
+template <typename BusType>
+void Ppu<BusType>::writeToRegister(uint16_t address, uint8_t data)
+{
+    if (_lineDeferred)
+    {
+        runDeferredDots();
+    }
+    // The 8 registers are mirrored over $2000-$3fff
+    address &= 0x7;
     switch (address)
     {
     case PPU_CTRL_OFFSET:
@@ -121,10 +189,10 @@ void Ppu::writeToRegister(uint16_t address, uint8_t data)
         _mask.data = data;
         break;
     case PPU_OAM_ADDR_OFFSET:
-        // TODO: impl
+        _oamAddr = data;
         break;
     case PPU_OAM_DATA_OFFSET:
-        // TODO: impl
+        _oam[_oamAddr++] = data;
         break;
     case PPU_SCROLL_OFFSET:
         if (_w == 0)
@@ -162,10 +230,15 @@ void Ppu::writeToRegister(uint16_t address, uint8_t data)
     }
 }
 
-uint8_t Ppu::readFromRegister(uint16_t address)
+template <typename BusType>
+uint8_t Ppu<BusType>::readFromRegister(uint16_t address)
 {
+    if (_lineDeferred)
+    {
+        runDeferredDots();
+    }
     uint8_t data = _readBuffer;
-    address &= 0xf;
+    address &= 0x7;
     switch (address)
     {
     case PPU_STATUS_OFFSET:
@@ -175,11 +248,20 @@ uint8_t Ppu::readFromRegister(uint16_t address)
         _status.verticalBank = 0;
         break;
     case PPU_OAM_DATA_OFFSET:
-        // TODO: impl
+        // Reads don't increment the oam address
+        data = _oam[_oamAddr];
+        if ((_oamAddr & 0x3) == 2)
+        {
+            data &= OAM_ATTRIBUTE_MASK;
+        }
         break;
     case PPU_DATA_OFFSET:
         data = _readBuffer;
         _readBuffer = ppuRead(_v.data);
+        if constexpr (ChrLogBus<BusType>)
+        {
+            _bus.chrRead(_v.data & 0x3fff);
+        }
         _v.data += (_ctrl.vramInc)? 32 : 1;
         if (_immediateRead)
         {
@@ -194,10 +276,18 @@ uint8_t Ppu::readFromRegister(uint16_t address)
 }
 
 
-void Ppu::ppuWrite(uint16_t address, uint8_t data)
+template <typename BusType>
+void Ppu<BusType>::ppuWrite(uint16_t address, uint8_t data)
 {
     address &= 0x3FFF;
-    if (_busWrite(address, data))
+    #ifdef MEMORY_HEATMAP
+    _heatmap.countWrite(address);
+    #endif // MEMORY_HEATMAP
+    if (address <= PPU_PATTERN_ADDR_END)
+    {
+        _decodedTileValid[address / 16] = false;
+    }
+    if (_bus.ppuWrite(address, data))
     {
         // overriden by the bus
     }
@@ -230,11 +320,15 @@ void Ppu::ppuWrite(uint16_t address, uint8_t data)
     }
 }
 
-uint8_t Ppu::ppuRead(uint16_t address, bool active)
+template <typename BusType>
+uint8_t Ppu<BusType>::ppuRead(uint16_t address, bool active)
 {
     uint8_t data = 0;
     address &= 0x3fff;
-    if (_busRead(address, data))
+    #ifdef MEMORY_HEATMAP
+    _heatmap.countRead(address);
+    #endif // MEMORY_HEATMAP
+    if (_bus.ppuRead(address, data))
     {
         // overriden by the bus
     }
@@ -272,8 +366,55 @@ uint8_t Ppu::ppuRead(uint16_t address, bool active)
     return data;
 }
 
-void Ppu::executeCycle()
+template <typename BusType>
+uint8_t Ppu<BusType>::patternRead(uint16_t address)
+{
+    uint8_t data = 0;
+    if (!_bus.ppuRead(address, data))
+    {
+        PatternTableAddr addr(address);
+        data = _patternTable[addr.h][addr.r * 16 + addr.c][addr.p][addr.t];
+    }
+    return data;
+}
+
+template <typename BusType>
+const typename Ppu<BusType>::DecodedTile& Ppu<BusType>::getDecodedTile(uint16_t tile)
+{
+    DecodedTile& rows = _decodedTiles[tile];
+    if (!_decodedTileValid[tile])
+    {
+        for (uint16_t y = 0; y < rows.size(); y++)
+        {
+            rows[y] = SpreadPlane(patternRead(tile * 16 + y)) | (SpreadPlane(patternRead(tile * 16 + 8 + y)) << 1);
+        }
+        _decodedTileValid[tile] = true;
+    }
+    return rows;
+}
+
+template <typename BusType>
+void Ppu<BusType>::invalidateTiles(uint16_t address, uint16_t size)
 {
+    uint32_t end = std::min<uint32_t>(address + size, PPU_PATTERN_ADDR_END + 1);
+    for (uint32_t tile = address / 16; tile * 16 < end; tile++)
+    {
+        _decodedTileValid[tile] = false;
+    }
+}
+
+template <typename BusType>
+void Ppu<BusType>::executeCycle()
+{
+    if (_lineDeferred)
+    {
+        if (_cycle <= 256)
+        {
+            _cycle++;
+            return;
+        }
+        renderScanline();
+    }
     if (_scanLine == 261 && _cycle == 1)
     {
         // Effectively start of new frame, so clear vertical blank flag
@@ -292,7 +433,11 @@ void Ppu::executeCycle()
     }
     if (_scanLine >= 0 && _scanLine < 240)
     {
-        if (_cycle >= 1 && _cycle <= 256)
+        if (_cycle == 1 && _scanlineRendererEnabled)
+        {
+            _lineDeferred = true;
+        }
+        else if (_cycle >= 1 && _cycle <= 256)
         {
             // normal fetch
             activeCycleSwitch();
@@ -311,7 +456,10 @@ void Ppu::executeCycle()
             }
         }
     }
-    progressY();
+    if (!_lineDeferred)
+    {
+        progressY();
+    }
     if (_cycle == 257)
     {
         // reset to row start
@@ -327,9 +475,20 @@ void Ppu::executeCycle()
     { 
         // frame complete
         _status.verticalBank = 1;
+        if constexpr (VblankBus<BusType>)
+        {
+            _bus.vblankStarted();
+        }
         if (_ctrl.genNmi)
         {
-            _nmi = true;
+            if constexpr (InterruptBus<BusType>)
+            {
+                _bus.interruptController().triggerNmi();
+            }
+            else
+            {
+                _nmi = true;
+            }
         }
     }
     _cycle++;
@@ -344,22 +503,96 @@ void Ppu::executeCycle()
     }
 }
 
-bool Ppu::getNmiStatus()
+template <typename BusType>
+void Ppu<BusType>::executeCycles(uint32_t cycles)
+{
+    for (uint32_t i = 0; i < cycles; i++)
+    {
+        executeCycle();
+    }
+}
+
+template <typename BusType>
+bool Ppu<BusType>::getNmiStatus()
 {
     return _nmi;
 }
 
-void Ppu::clearNmiStatus()
+template <typename BusType>
+void Ppu<BusType>::clearNmiStatus()
 {
     _nmi = false;
 }
 
-void Ppu::setMirroringMode(uint8_t mode)
+template <typename BusType>
+uint32_t Ppu<BusType>::getPosition() const
+{
+    return (static_cast<uint32_t>(_scanLine) << 16) | static_cast<uint16_t>(_cycle);
+}
+
+template <typename BusType>
+uint32_t Ppu<BusType>::positionAfter(uint32_t position, int64_t cycles)
+{
+    // Dot 0 of scanline 0 runs as dot 1 so a frame is a cycle short and dot 1 is never the position between cycles
+    constexpr int64_t frameCycles = 262 * 341 - 1;
+    int64_t dot = (position >> 16) * 341 + (position & 0xffff);
+    int64_t step = (dot == 0)? 0 : dot - 1;
+    step = ((step + cycles) % frameCycles + frameCycles) % frameCycles;
+    dot = (step == 0)? 0 : step + 1;
+    return ((dot / 341) << 16) | (dot % 341);
+}
+
+template <typename BusType>
+uint32_t Ppu<BusType>::cyclesUntilNmi() const
+{
+    // The nmi is raised by the cycle that starts at scanline 241 cycle 1
+    constexpr uint32_t nmiPosition = 241 * 341 + 1;
+    constexpr uint32_t framePosition = 262 * 341;
+    uint32_t position = _scanLine * 341 + _cycle;
+    if (position <= nmiPosition)
+    {
+        return nmiPosition - position;
+    }
+    // The frame can be a cycle shorter because of the skipped cycle at the start of the first scanline
+    return framePosition - position + nmiPosition - 1;
+}
+
+template <typename BusType>
+uint32_t Ppu<BusType>::cyclesUntilStatusChange() const
+{
+    // Other than the vblank flag that is set with the nmi, the flags are cleared at scanline 261 cycle 1
+    constexpr uint32_t preRenderPosition = 261 * 341 + 1;
+    uint32_t position = _scanLine * 341 + _cycle;
+    uint32_t cycles = cyclesUntilNmi();
+    if (position <= preRenderPosition)
+    {
+        cycles = std::min(cycles, preRenderPosition - position);
+    }
+    return cycles;
+}
+
+template <typename BusType>
+void Ppu<BusType>::setMirroringMode(uint8_t mode)
 {
     _mirroringMode = mode;
 }
 
-uint32_t Ppu::getRgbForPixel(uint8_t paletteId, uint8_t pixelValue)
+template <typename BusType>
+void Ppu<BusType>::setScanlineRendererEnabled(bool enabled)
+{
+    if (_lineDeferred)
+    {
+        runDeferredDots();
+    }
+    #ifdef MEMORY_HEATMAP
+    // The line pass reads every palette entry once instead of once a dot
+    enabled = false;
+    #endif // MEMORY_HEATMAP
+    _scanlineRendererEnabled = enabled;
+}
+
+template <typename BusType>
+uint32_t Ppu<BusType>::getRgbForPixel(uint8_t paletteId, uint8_t pixelValue)
 {
     paletteId %= 8;
     pixelValue &= 0x3;
@@ -367,7 +600,8 @@ uint32_t Ppu::getRgbForPixel(uint8_t paletteId, uint8_t pixelValue)
     return _paletteTable[ppuRead(palAddr + pixelValue, false)];
 }
 
-void Ppu::fetchNextTile()
+template <typename BusType>
+void Ppu<BusType>::fetchNextTile()
 {
     // load old data into the shift registers
     _loPtShift = (_loPtShift & 0xff00) | _loBgTileByte;
@@ -379,7 +613,8 @@ void Ppu::fetchNextTile()
     _ntByte = ppuRead(PPU_NAME_TABLE_ADDR_START + (_v.data & 0xfff));
 }
 
-void Ppu::fetchNextTileAttribute()
+template <typename BusType>
+void Ppu<BusType>::fetchNextTileAttribute()
 {
     uint8_t shift = 0;
     _atByte = ppuRead((PPU_NAME_TABLE_ADDR_START + PPU_ATTRIBUTE_TABLE_OFFSET) | 
@@ -396,25 +631,54 @@ void Ppu::fetchNextTileAttribute()
     _atByte = (_atByte >> shift) & 0x3;
 }
 
-void Ppu::fetchPatternForTile(bool isLow)
+template <typename BusType>
+typename Ppu<BusType>::PatternTableAddr Ppu<BusType>::patternAddress() const
 {
     PatternTableAddr addr(0);
     addr.c = _ntByte % 0x32;
     addr.r = _ntByte / 32;
     addr.h = _ctrl.bptAddr;
     addr.t = _v.fineY;
+    return addr;
+}
+
+template <typename BusType>
+void Ppu<BusType>::fetchPatternForTile(bool isLow)
+{
+    PatternTableAddr addr = patternAddress();
+    addr.p = (isLow)? 0 : 1;
+    #ifdef MEMORY_HEATMAP
+    _heatmap.countRead(addr.data);
+    #endif // MEMORY_HEATMAP
+    uint8_t plane = GatherPlane(getDecodedTile(addr.data / 16)[addr.t], addr.p);
     if (isLow)
     {
-        _loBgTileByte = ppuRead(addr.data);
+        _loBgTileByte = plane;
     }
     else
     {
-        addr.p = 1;
-        _hiBgTileByte = ppuRead(addr.data);
+        _hiBgTileByte = plane;
+    }
+    if constexpr (ChrLogBus<BusType>)
+    {
+        _bus.chrRendered(addr.data);
     }
 }
 
-void Ppu::updateShiftRegisters()
+template <typename BusType>
+uint16_t Ppu<BusType>::fetchTileRow()
+{
+    PatternTableAddr addr = patternAddress();
+    if constexpr (ChrLogBus<BusType>)
+    {
+        _bus.chrRendered(addr.data);
+        _bus.chrRendered(addr.data | 0x8);
+    }
+    return getDecodedTile(addr.data / 16)[addr.t];
+}
+
+template <typename BusType>
+void Ppu<BusType>::updateShiftRegisters()
 {
     if (_mask.shBackground)
     {
@@ -425,7 +689,8 @@ void Ppu::updateShiftRegisters()
     }
 }
 
-void Ppu::progressX()
+template <typename BusType>
+void Ppu<BusType>::progressX()
 {
     if (_mask.shBackground | _mask.shSprite)
     {
@@ -441,7 +706,8 @@ void Ppu::progressX()
     }
 }
 
-void Ppu::progressY()
+template <typename BusType>
+void Ppu<BusType>::progressY()
 {
     if (_mask.shBackground | _mask.shSprite)
     {
@@ -469,7 +735,8 @@ void Ppu::progressY()
     }
 }
 
-void Ppu::activeCycleSwitch()
+template <typename BusType>
+void Ppu<BusType>::activeCycleSwitch()
 {
     updateShiftRegisters();
     switch ((_cycle - 1) % 8)
@@ -491,7 +758,8 @@ void Ppu::activeCycleSwitch()
     }
 }
 
-void Ppu::renderPixelsToScreen()
+template <typename BusType>
+void Ppu<BusType>::renderPixelsToScreen()
 {
     if (_mask.shBackground)
     {
@@ -505,4 +773,93 @@ void Ppu::renderPixelsToScreen()
         _screen[_cycle - 1 + _scanLine * 256] = getRgbForPixel(lp | hp, lPix | hPix);
         // _screen[_cycle - 1 + _scanLine * 256] = _paletteTable[(rand() % 2) ? 0x3F : 0x30];
     }
-}
\ No newline at end of file
+}
+
+template <typename BusType>
+void Ppu<BusType>::runDeferredDots()
+{
+    int16_t cycle = _cycle;
+    _lineDeferred = false;
+    for (_cycle = 1; _cycle < cycle; _cycle++)
+    {
+        activeCycleSwitch();
+        renderPixelsToScreen();
+        progressY();
+    }
+}
+
+template <typename BusType>
+void Ppu<BusType>::renderScanline()
+{
+    // The bytes that pass through the shift registers during the line, the first is what is left of the registers at dot 1
+    // and every other one is loaded at the start of a tile, a dot shows the bit at the dot + fine x
+    // The pattern bytes are kept as decoded rows
+    constexpr uint32_t TILE_COUNT = 32;
+    std::array<uint16_t, TILE_COUNT + 1> pattern;
+    std::array<uint8_t, TILE_COUNT + 1> loAttribute;
+    std::array<uint8_t, TILE_COUNT + 1> hiAttribute;
+    pattern[0] = SpreadPlane((_loPtShift << 1) >> 8) | (SpreadPlane((_hiPtShift << 1) >> 8) << 1);
+    loAttribute[0] = (_loAtShift << 1) >> 8;
+    hiAttribute[0] = (_hiAtShift << 1) >> 8;
+    uint16_t highBytes[4] = {
+        static_cast<uint16_t>(_loPtShift & 0xff00), static_cast<uint16_t>(_hiPtShift & 0xff00),
+        static_cast<uint16_t>(_loAtShift & 0xff00), static_cast<uint16_t>(_hiAtShift & 0xff00)};
+
+    // The fetches of every tile in the order the dots make them
+    uint16_t row = SpreadPlane(_loBgTileByte) | (SpreadPlane(_hiBgTileByte) << 1);
+    for (uint32_t tile = 0; tile < TILE_COUNT; tile++)
+    {
+        pattern[tile + 1] = row;
+        loAttribute[tile + 1] = (_atByte & 0x1)? 0xff : 0;
+        hiAttribute[tile + 1] = (_atByte & 0x2)? 0xff : 0;
+        _ntByte = ppuRead(PPU_NAME_TABLE_ADDR_START + (_v.data & 0xfff));
+        fetchNextTileAttribute();
+        row = fetchTileRow();
+        // The last two dots of a tile both move to the next one
+        progressX();
+        progressX();
+    }
+    _loBgTileByte = GatherPlane(row, 0);
+    _hiBgTileByte = GatherPlane(row, 1);
+
+    if (_mask.shBackground)
+    {
+        std::array<uint32_t, 16> colors;
+        for (uint8_t i = 0; i < colors.size(); i++)
+        {
+            colors[i] = getRgbForPixel(i >> 2, i & 0x3);
+        }
+        uint32_t* screenRow = &_screen[_scanLine * 256];
+        for (uint32_t x = 0; x < 256; x++)
+        {
+            uint32_t position = x + _fineX;
+            uint32_t tile = position / 8;
+            uint32_t shift = 7 - position % 8;
+            uint8_t pixel = (pattern[tile] >> (shift * 2)) & 0x3;
+            uint8_t palette = ((loAttribute[tile] >> shift) & 0x1) | (((hiAttribute[tile] >> shift) & 0x1) << 1);
+            screenRow[x] = colors[palette * 4 + pixel];
+        }
+        // The last tile was loaded 7 dots before the end of the line
+        _loPtShift = ((GatherPlane(pattern[TILE_COUNT - 1], 0) << 8) | GatherPlane(pattern[TILE_COUNT], 0)) << 7;
+        _hiPtShift = ((GatherPlane(pattern[TILE_COUNT - 1], 1) << 8) | GatherPlane(pattern[TILE_COUNT], 1)) << 7;
+        _loAtShift = ((loAttribute[TILE_COUNT - 1] << 8) | loAttribute[TILE_COUNT]) << 7;
+        _hiAtShift = ((hiAttribute[TILE_COUNT - 1] << 8) | hiAttribute[TILE_COUNT]) << 7;
+    }
+    else
+    {
+        // Without the background the registers don't shift and only their low byte is loaded
+        _loPtShift = highBytes[0] | GatherPlane(pattern[TILE_COUNT], 0);
+        _hiPtShift = highBytes[1] | GatherPlane(pattern[TILE_COUNT], 1);
+        _loAtShift = highBytes[2] | loAttribute[TILE_COUNT];
+        _hiAtShift = highBytes[3] | hiAttribute[TILE_COUNT];
+    }
+
+    int16_t cycle = _cycle;
+    _cycle = 256;
+    progressY();
+    _cycle = cycle;
+    _lineDeferred = false;
+}
+
+template class Ppu<Bus>;
+template class Ppu<FunctionalPpuBus>;
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#include "HardwareEmulation/RamSearch.hpp"
+
+#ifdef __SSE2__
+template <SearchFilter Filter>
+static __m128i Match(__m128i older, __m128i newer, __m128i operand)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_cmpeq_epi8(zero, zero);
+    if constexpr (Filter == SearchFilter::EQUAL)
+    {
+        return _mm_cmpeq_epi8(newer, operand);
+    }
+    else if constexpr (Filter == SearchFilter::NOT_EQUAL)
+    {
+        return _mm_xor_si128(_mm_cmpeq_epi8(newer, operand), ones);
+    }
+    else if constexpr (Filter == SearchFilter::CHANGED)
+    {
+        return _mm_xor_si128(_mm_cmpeq_epi8(newer, older), ones);
+    }
+    else if constexpr (Filter == SearchFilter::UNCHANGED)
+    {
+        return _mm_cmpeq_epi8(newer, older);
+    }
+    else if constexpr (Filter == SearchFilter::INCREASED)
+    {
+        // There is no unsigned byte compare, the saturating difference is only 0 when the value didn't grow
+        return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(newer, older), zero), ones);
+    }
+    else if constexpr (Filter == SearchFilter::DECREASED)
+    {
+        return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(older, newer), zero), ones);
+    }
+    else if constexpr (Filter == SearchFilter::INCREASED_BY)
+    {
+        return _mm_cmpeq_epi8(_mm_sub_epi8(newer, older), operand);
+    }
+    else
+    {
+        return _mm_cmpeq_epi8(_mm_sub_epi8(older, newer), operand);
+    }
+}
+
+template <SearchFilter Filter>
+static void FilterCandidates(uint8_t* candidates, const uint8_t* older, const uint8_t* newer, uint8_t operand, uint32_t size)
+{
+    const __m128i operandVector = _mm_set1_epi8(static_cast<char>(operand));
+    for (uint32_t i = 0; i < size; i += 16)
+    {
+        __m128i match = Match<Filter>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(older + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(newer + i)), operandVector);
+        __m128i* candidate = reinterpret_cast<__m128i*>(candidates + i);
+        _mm_storeu_si128(candidate, _mm_and_si128(_mm_loadu_si128(candidate), match));
+    }
+}
+#else
+template <SearchFilter Filter>
+static bool Match(uint8_t older, uint8_t newer, uint8_t operand)
+{
+    switch (Filter)
+    {
+        case SearchFilter::EQUAL: return newer == operand;
+        case SearchFilter::NOT_EQUAL: return newer != operand;
+        case SearchFilter::CHANGED: return newer != older;
+        case SearchFilter::UNCHANGED: return newer == older;
+        case SearchFilter::INCREASED: return newer > older;
+        case SearchFilter::DECREASED: return newer < older;
+        case SearchFilter::INCREASED_BY: return static_cast<uint8_t>(newer - older) == operand;
+        case SearchFilter::DECREASED_BY: return static_cast<uint8_t>(older - newer) == operand;
+    }
+    return false;
+}
+
+// Branch free so the compiler can vectorize it on its own
+template <SearchFilter Filter>
+static void FilterCandidates(uint8_t* candidates, const uint8_t* older, const uint8_t* newer, uint8_t operand, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        candidates[i] &= -static_cast<uint8_t>(Match<Filter>(older[i], newer[i], operand));
+    }
+}
+#endif // __SSE2__
+
+using FilterFunction = void (*)(uint8_t* candidates, const uint8_t* older, const uint8_t* newer, uint8_t operand, uint32_t size);
+
+static FilterFunction GetFilterFunction(SearchFilter filter)
+{
+    switch (filter)
+    {
+        case SearchFilter::EQUAL: return FilterCandidates<SearchFilter::EQUAL>;
+        case SearchFilter::NOT_EQUAL: return FilterCandidates<SearchFilter::NOT_EQUAL>;
+        case SearchFilter::CHANGED: return FilterCandidates<SearchFilter::CHANGED>;
+        case SearchFilter::UNCHANGED: return FilterCandidates<SearchFilter::UNCHANGED>;
+        case SearchFilter::INCREASED: return FilterCandidates<SearchFilter::INCREASED>;
+        case SearchFilter::DECREASED: return FilterCandidates<SearchFilter::DECREASED>;
+        case SearchFilter::INCREASED_BY: return FilterCandidates<SearchFilter::INCREASED_BY>;
+        case SearchFilter::DECREASED_BY: return FilterCandidates<SearchFilter::DECREASED_BY>;
+    }
+    throw std::invalid_argument("Unknown ram search filter");
+}
+
+RamSearch::RamSearch(uint32_t size) :
+    _size(size),
+    _stride((size + VECTOR_SIZE - 1) & ~(VECTOR_SIZE - 1))
+{
+    resetCandidates();
+}
+
+void RamSearch::capture(std::span<const uint8_t> memory)
+{
+    if (memory.size() != _size)
+    {
+        throw std::invalid_argument("The snapshot isn't the size of the searched memory");
+    }
+    size_t offset = _snapshots.size();
+    _snapshots.resize(offset + _stride, 0);
+    std::copy(memory.begin(), memory.end(), _snapshots.begin() + offset);
+}
+
+uint32_t RamSearch::getSnapshotCount() const
+{
+    return _snapshots.size() / _stride;
+}
+
+uint8_t RamSearch::getValue(uint32_t snapshot, uint32_t address) const
+{
+    return this->snapshot(snapshot)[address];
+}
+
+void RamSearch::filter(SearchFilter filter, uint8_t operand, uint32_t older, uint32_t newer)
+{
+    GetFilterFunction(filter)(_candidates.data(), snapshot(older), snapshot(newer), operand, _stride);
+}
+
+void RamSearch::filterHistory(SearchFilter filter, uint8_t operand)
+{
+    FilterFunction function = GetFilterFunction(filter);
+    uint32_t count = getSnapshotCount();
+    // The value filters don't look at the older snapshot so the first one is compared with itself
+    for (uint32_t i = (filter == SearchFilter::EQUAL || filter == SearchFilter::NOT_EQUAL)? 0 : 1; i < count; i++)
+    {
+        function(_candidates.data(), snapshot((i > 0)? i - 1 : 0), snapshot(i), operand, _stride);
+    }
+}
+
+uint32_t RamSearch::getCandidateCount() const
+{
+    return std::count(_candidates.begin(), _candidates.begin() + _size, CANDIDATE);
+}
+
+std::vector<uint32_t> RamSearch::getCandidates() const
+{
+    std::vector<uint32_t> candidates;
+    for (uint32_t address = 0; address < _size; address++)
+    {
+        if (_candidates[address] == CANDIDATE)
+        {
+            candidates.push_back(address);
+        }
+    }
+    return candidates;
+}
+
+void RamSearch::resetCandidates()
+{
+    _candidates.assign(_stride, CANDIDATE);
+}
+
+void RamSearch::clearSnapshots()
+{
+    _snapshots.clear();
+}
+
+const uint8_t* RamSearch::snapshot(uint32_t index) const
+{
+    if (index >= getSnapshotCount())
+    {
+        throw std::out_of_range("No such ram search snapshot");
+    }
+    return _snapshots.data() + static_cast<size_t>(index) * _stride;
+}
@@ -0,0 +1,66 @@
+#include <algorithm>
+
+#include "HardwareEmulation/Watchpoints.hpp"
+
+Watchpoints::Watchpoints() :
+    _nextId(0)
+{
+}
+
+uint32_t Watchpoints::add(const Watchpoint& watchpoint)
+{
+    _entries.push_back({_nextId, watchpoint});
+    return _nextId++;
+}
+
+bool Watchpoints::remove(uint32_t id)
+{
+    auto iter = std::find_if(_entries.begin(), _entries.end(), [id](const Entry& entry) { return entry.id == id; });
+    if (iter == _entries.end())
+    {
+        return false;
+    }
+    _entries.erase(iter);
+    return true;
+}
+
+void Watchpoints::clear()
+{
+    _entries.clear();
+}
+
+bool Watchpoints::empty() const
+{
+    return _entries.empty();
+}
+
+void Watchpoints::setHitHandler(HitHandler handler)
+{
+    _hitHandler = std::move(handler);
+}
+
+uint8_t Watchpoints::getPageAccesses(uint32_t page) const
+{
+    uint8_t accesses = 0;
+    for (const Entry& entry : _entries)
+    {
+        if ((entry.watchpoint.start >> 8) <= page && page <= (entry.watchpoint.end >> 8))
+        {
+            accesses |= entry.watchpoint.accesses;
+        }
+    }
+    return accesses;
+}
+
+void Watchpoints::check(uint16_t address, uint8_t data, WatchAccess access) const
+{
+    for (const Entry& entry : _entries)
+    {
+        const Watchpoint& watchpoint = entry.watchpoint;
+        if ((watchpoint.accesses & access) && watchpoint.start <= address && address <= watchpoint.end &&
+            (!watchpoint.value.has_value() || *watchpoint.value == data) && _hitHandler)
+        {
+            _hitHandler(watchpoint, address, data, access);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#include "WindowUtilities/JoypadInputHelper.hpp"
+
+#include "HardwareEmulation/Controller.hpp"
+
+JoypadInputHelper::JoypadInputHelper(EventMapper& event_mapper, ButtonsFunction on_buttons_change)
+    :
+    _on_buttons_change(std::move(on_buttons_change)),
+    _buttons(0)
+{
+    event_mapper.insert(std::make_pair(SDL_EventType::SDL_KEYDOWN, std::bind(&JoypadInputHelper::KeyHandler, this, std::placeholders::_1)));
+    event_mapper.insert(std::make_pair(SDL_EventType::SDL_KEYUP, std::bind(&JoypadInputHelper::KeyHandler, this, std::placeholders::_1)));
+}
+
+void JoypadInputHelper::KeyHandler(const SDL_Event& e)
+{
+    uint8_t button = KeyToButton(e.key.keysym.sym);
+    uint8_t buttons = (e.type == SDL_KEYDOWN)? (_buttons | button) : (_buttons & ~button);
+    if (buttons != _buttons)
+    {
+        _buttons = buttons;
+        _on_buttons_change(_buttons);
+    }
+}
+
+uint8_t JoypadInputHelper::KeyToButton(SDL_Keycode key)
+{
+    switch (key)
+    {
+    case SDLK_x:
+        return Controller::BUTTON_A;
+    case SDLK_z:
+        return Controller::BUTTON_B;
+    case SDLK_RSHIFT:
+        return Controller::BUTTON_SELECT;
+    case SDLK_RETURN:
+        return Controller::BUTTON_START;
+    case SDLK_UP:
+        return Controller::BUTTON_UP;
+    case SDLK_DOWN:
+        return Controller::BUTTON_DOWN;
+    case SDLK_LEFT:
+        return Controller::BUTTON_LEFT;
+    case SDLK_RIGHT:
+        return Controller::BUTTON_RIGHT;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,99 @@
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "HardwareEmulation/Cpu.hpp"
+
+// Runs a generic 6502 test binary (like the Klaus Dormann functional tests) on the NMOS 6502 variant of the core
+// The binary is loaded into a flat 64KB memory image and runs until it traps, a jump or branch to itself
+// usage: BinaryRunner [options] <binary> [load address] [start address] [success address]
+// addresses are hex, the run succeeds when the trap address is the success address
+// options:
+//   --cycle-exact       run the cycle exact core
+
+static constexpr uint64_t MAX_INSTRUCTIONS = 1000000000;
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> positional;
+    bool cycleExact = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--cycle-exact")
+        {
+            cycleExact = true;
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.empty())
+    {
+        std::cerr << "usage: BinaryRunner [--cycle-exact] <binary> [load address] [start address] [success address]" << std::endl;
+        return 1;
+    }
+    uint16_t loadAddress = (positional.size() > 1)? std::stoul(positional[1], nullptr, 16) : 0x0000;
+    uint16_t startAddress = (positional.size() > 2)? std::stoul(positional[2], nullptr, 16) : 0x0400;
+    bool checkSuccess = positional.size() > 3;
+    uint16_t successAddress = (checkSuccess)? std::stoul(positional[3], nullptr, 16) : 0;
+
+    std::array<uint8_t, 0x10000> memory = {};
+    std::ifstream binary(positional[0], std::ios::binary);
+    if (!binary.is_open())
+    {
+        std::cerr << "Failed to open " << positional[0] << std::endl;
+        return 1;
+    }
+    binary.read(reinterpret_cast<char*>(memory.data() + loadAddress), memory.size() - loadAddress);
+
+    // The first access of every instruction is its opcode fetch, that is how the runner follows the pc
+    bool instructionStart = false;
+    uint16_t opcodeAddress = 0;
+    bool resetting = true;
+    FunctionalCpuBus bus([&](uint16_t address, uint8_t data)
+    {
+        instructionStart = false;
+        memory[address] = data;
+    },
+    [&](uint16_t address) -> uint8_t
+    {
+        if (resetting && (address == 0xfffc || address == 0xfffd))
+        {
+            return (address == 0xfffc)? startAddress & 0xff : startAddress >> 8;
+        }
+        if (instructionStart)
+        {
+            opcodeAddress = address;
+            instructionStart = false;
+        }
+        return memory[address];
+    });
+    Cpu<FunctionalCpuBus, Mos6502> cpu(bus);
+    cpu.setCycleExactEnabled(cycleExact);
+    cpu.cpuReset();
+    resetting = false;
+
+    uint64_t instructions = 0;
+    uint16_t lastAddress = startAddress;
+    bool trapped = false;
+    while (!trapped && instructions < MAX_INSTRUCTIONS)
+    {
+        instructionStart = true;
+        cpu.cpuExecuteInstruction();
+        instructions++;
+        trapped = instructions > 1 && opcodeAddress == lastAddress;
+        lastAddress = opcodeAddress;
+    }
+    if (!trapped)
+    {
+        std::cout << "No trap after " << instructions << " instructions" << std::endl;
+        return 1;
+    }
+    std::cout << "Trapped at " << std::hex << opcodeAddress << std::dec << " after " << instructions << " instructions" << std::endl;
+    return (!checkSuccess || opcodeAddress == successAddress)? 0 : 1;
+}
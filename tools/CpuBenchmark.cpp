@@ -0,0 +1,203 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NumToHexStringConvertor.hpp"
+
+#include "HardwareEmulation/Bus.hpp"
+#include "HardwareEmulation/Cpu.hpp"
+#include "HardwareEmulation/Mappers/Mapper.hpp"
+
+// Instructions per second benchmark for the cpu core
+// The nestest rom is run in its automation mode (starting at C000) over a flat memory image,
+// so only the cpu itself is measured and not the rest of the bus
+// The memory image is connected through the type erased FunctionalCpuBus adapter
+// With --bus the cpu side memory map of the real Bus is measured instead, ram and rom are swept with the access mix of an instruction stream
+// With --nestest the instruction core and the cycle exact core are both checked against nestest.log up to the illegal opcodes,
+// the exit code is 0 when the registers and cycle counts of every instruction match
+
+static constexpr uint32_t NESTEST_HEADER_SIZE = 16;
+static constexpr uint32_t NESTEST_INSTRUCTION_COUNT = 8991; // The length of nestest.log
+static constexpr uint16_t AUTOMATION_ENTRY = 0xc000;
+
+using NestestPrgRom = std::array<uint8_t, Mapper::PRG_ROM_BANK_SIZE>;
+using NestestRam = std::array<uint8_t, 0x800>;
+
+static bool LoadNestestPrgRom(const std::string& romPath, NestestPrgRom& prgRom)
+{
+    std::ifstream rom(romPath, std::ios::binary);
+    if (!rom.is_open())
+    {
+        std::cerr << "Failed to open " << romPath << std::endl;
+        return false;
+    }
+    rom.seekg(NESTEST_HEADER_SIZE);
+    rom.read(reinterpret_cast<char*>(prgRom.data()), prgRom.size());
+    return true;
+}
+
+// Ram and the rom with the reset vector pointing at the automation entry, nothing else is mapped
+static FunctionalCpuBus MakeNestestBus(NestestRam& ram, const NestestPrgRom& prgRom)
+{
+    return FunctionalCpuBus([&ram](uint16_t address, uint8_t data)
+    {
+        if (address < 0x2000)
+        {
+            ram[address % ram.size()] = data;
+        }
+    },
+    [&ram, &prgRom](uint16_t address) -> uint8_t
+    {
+        if (address < 0x2000)
+        {
+            return ram[address % ram.size()];
+        }
+        if (address == 0xfffc)
+        {
+            return AUTOMATION_ENTRY & 0xff;
+        }
+        if (address == 0xfffd)
+        {
+            return AUTOMATION_ENTRY >> 8;
+        }
+        if (address >= 0x8000)
+        {
+            return prgRom[address % prgRom.size()];
+        }
+        return 0;
+    });
+}
+
+static int NestestTest(const std::string& romPath, const std::string& logPath)
+{
+    // The columns of a nestest.log line
+    static constexpr size_t ILLEGAL_MARK_COLUMN = 15;
+    static constexpr size_t A_COLUMN = 50;
+    static constexpr size_t X_COLUMN = 55;
+    static constexpr size_t Y_COLUMN = 60;
+    static constexpr size_t P_COLUMN = 65;
+    static constexpr size_t SP_COLUMN = 71;
+    static constexpr size_t CYCLE_COLUMN = 90;
+    static constexpr uint8_t RESERVED_FLAG_MASK = 0x20;
+
+    NestestPrgRom prgRom = {};
+    if (!LoadNestestPrgRom(romPath, prgRom))
+    {
+        return 1;
+    }
+    std::ifstream log(logPath);
+    if (!log.is_open())
+    {
+        std::cerr << "Failed to open " << logPath << std::endl;
+        return 1;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    // The illegal opcodes at the end of the log aren't emulated
+    while (std::getline(log, line) && line.size() > CYCLE_COLUMN && line[ILLEGAL_MARK_COLUMN] != '*')
+    {
+        lines.push_back(line);
+    }
+
+    for (bool cycleExact : {false, true})
+    {
+        NestestRam ram = {};
+        FunctionalCpuBus bus = MakeNestestBus(ram, prgRom);
+        Cpu<FunctionalCpuBus> cpu(bus);
+        cpu.setCycleExactEnabled(cycleExact);
+        cpu.cpuReset();
+        size_t startCycles = cpu.getCycles() - std::stoul(lines.front().substr(CYCLE_COLUMN));
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            auto hex = [&](size_t column, size_t digits) { return std::stoul(lines[i].substr(column, digits), nullptr, 16); };
+            auto registers = cpu.getRegisters();
+            if (registers.pc != hex(0, 4) || registers.a != hex(A_COLUMN, 2) || registers.x != hex(X_COLUMN, 2) ||
+                registers.y != hex(Y_COLUMN, 2) || (registers.status | RESERVED_FLAG_MASK) != hex(P_COLUMN, 2) ||
+                registers.sp != hex(SP_COLUMN, 2) || cpu.getCycles() - startCycles != std::stoul(lines[i].substr(CYCLE_COLUMN)))
+            {
+                std::cerr << ((cycleExact)? "The cycle exact core" : "The instruction core") << " differs from line " << i + 1 << " of the log" << std::endl;
+                std::cerr << "expected: " << lines[i] << std::endl;
+                auto byte = [](uint8_t value) { return NumToHexStringConvertor::Convert(value, 2); };
+                std::cerr << "result:   " << NumToHexStringConvertor::Convert(registers.pc, 4) << " A:" << byte(registers.a) << " X:" << byte(registers.x) <<
+                    " Y:" << byte(registers.y) << " P:" << byte(registers.status | RESERVED_FLAG_MASK) << " SP:" << byte(registers.sp) <<
+                    " CYC:" << cpu.getCycles() - startCycles << std::endl;
+                return 1;
+            }
+            cpu.cpuExecuteInstruction();
+        }
+    }
+    std::cout << "Both cores match the " << lines.size() << " documented instructions of the log" << std::endl;
+    return 0;
+}
+
+static int BusBenchmark(const std::string& romPath, uint64_t accessCount)
+{
+    auto bus = std::make_unique<Bus>();
+    bus->insertCartridge(std::fstream(romPath, std::ios::in | std::ios::binary));
+
+    // Every step fetches two rom bytes, reads back a stack byte an earlier step wrote and writes a stack byte
+    static constexpr uint32_t ACCESSES_PER_STEP = 4;
+    uint32_t checksum = 0;
+    uint16_t pc = 0x8000;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < accessCount; i += ACCESSES_PER_STEP)
+    {
+        uint8_t opcode = bus->cpuRead(pc);
+        uint8_t operand = bus->cpuRead(pc + 1);
+        checksum += opcode + bus->cpuRead(0x100 | operand);
+        bus->cpuWrite(0x100 | opcode, operand);
+        pc = (pc + 2) | 0x8000;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Executed " << accessCount << " bus accesses in " << elapsed.count() << "s (checksum " << checksum << ")" << std::endl;
+    std::cout << "Bus accesses per second: " << static_cast<uint64_t>(accessCount / elapsed.count()) << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--bus")
+    {
+        std::string romPath = (argc > 2)? argv[2] : std::string(RESOURCE_PATH) + "/nestest_rom/nestest.nes";
+        return BusBenchmark(romPath, (argc > 3)? std::stoull(argv[3]) : 200000000);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--nestest")
+    {
+        std::string romPath = (argc > 2)? argv[2] : std::string(RESOURCE_PATH) + "/nestest_rom/nestest.nes";
+        std::string logPath = (argc > 3)? argv[3] : std::string(RESOURCE_PATH) + "/nestest_rom/nestest.log";
+        return NestestTest(romPath, logPath);
+    }
+    std::string romPath = (argc > 1)? argv[1] : std::string(RESOURCE_PATH) + "/nestest_rom/nestest.nes";
+    uint64_t instructionCount = (argc > 2)? std::stoull(argv[2]) : 50000000;
+
+    NestestRam ram = {};
+    NestestPrgRom prgRom = {};
+    if (!LoadNestestPrgRom(romPath, prgRom))
+    {
+        return 1;
+    }
+    FunctionalCpuBus bus = MakeNestestBus(ram, prgRom);
+    Cpu<FunctionalCpuBus> cpu(bus);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < instructionCount; i += NESTEST_INSTRUCTION_COUNT)
+    {
+        cpu.cpuReset();
+        for (uint32_t j = 0; j < NESTEST_INSTRUCTION_COUNT; j++)
+        {
+            cpu.cpuExecuteInstruction();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    uint64_t executed = ((instructionCount + NESTEST_INSTRUCTION_COUNT - 1) / NESTEST_INSTRUCTION_COUNT) * NESTEST_INSTRUCTION_COUNT;
+    std::cout << "Executed " << executed << " instructions in " << elapsed.count() << "s" << std::endl;
+    std::cout << "Instructions per second: " << static_cast<uint64_t>(executed / elapsed.count()) << std::endl;
+    return 0;
+}
@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HardwareEmulation/Bus.hpp"
+#include "HardwareEmulation/RamSearch.hpp"
+#include "HardwareEmulation/Aot/RecompiledProgram.hpp"
+
+// Runs a rom without any window for a fixed amount of frames and prints the core statistics
+// usage: HeadlessRunner [options] [rom path] [frame count]
+// options:
+//   --no-block-cache    run without the predecoded block cache
+//   --jit               run hot rom code as translated x86-64 code
+//   --jit-differential  check every run of translated code against the interpreter (implies --jit)
+//   --aot               run the code the static recompiler generated for this rom at build time
+//   --no-idle-skip      interpret idle loops instead of skipping them
+//   --cycle-exact       run the cpu one bus cycle at a time interleaved with the ppu
+//   --lazy              run the cpu up to the next ppu status change and catch the ppu up when the cpu accesses it (the model the emulator runs)
+//   --no-scanline-renderer  draw every dot on its own instead of whole scanlines
+//   --batch             run the cpu for cycle budgets and catch the ppu up after each one
+//   --stats <path>      write the executed instruction mix of the rom to path, needs a build with CPU_STATISTICS
+//   --trace-dump <path> write the instruction trace and the screen to path when the cpu jams, the run throws or the run ends, needs a build with CPU_TRACE
+//   --heatmap <prefix>  write the cpu and ppu access counters to <prefix>_cpu.csv/.bin and <prefix>_ppu.csv/.bin, needs a build with MEMORY_HEATMAP
+//   --heatmap-last-frame  reset the counters at the start of every frame so only the last frame is written, needs a build with MEMORY_HEATMAP
+//   --watch <spec>      print the accesses that hit a watchpoint, spec is <r|w|x...>:<start>[-<end>][=<value>] in hex, e.g. w:0300-03ff=00
+//   --game-genie <code> apply a 6 or 8 letter Game Genie code
+//   --freeze <spec>     write a ram byte at the start of every vblank, spec is <address>=<value> in hex, e.g. 075a=09
+//   --cdl <path>        log how every prg and chr rom byte was used and write it to path in the .cdl format
+//   --ram-search <spec> snapshot the ram every frame and print the addresses that match the filter between every frame and the one before it
+//                       spec is eq=<value>, ne=<value>, changed, unchanged, inc, dec, inc-by=<value> or dec-by=<value> in hex, it can be repeated
+
+// FNV-1a over the ram and the screen so runs with different core options can be compared
+template <typename Container>
+static uint64_t Checksum(const Container& data, uint64_t hash = 0xcbf29ce484222325)
+{
+    for (auto value : data)
+    {
+        hash = (hash ^ value) * 0x100000001b3;
+    }
+    return hash;
+}
+
+static bool ParseWatchpoint(const std::string& spec, Watchpoint& watchpoint)
+{
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos || colon == 0)
+    {
+        return false;
+    }
+    watchpoint = {};
+    for (char access : spec.substr(0, colon))
+    {
+        switch (access)
+        {
+        case 'r':
+            watchpoint.accesses |= WATCH_READ;
+            break;
+        case 'w':
+            watchpoint.accesses |= WATCH_WRITE;
+            break;
+        case 'x':
+            watchpoint.accesses |= WATCH_EXECUTE;
+            break;
+        default:
+            return false;
+        }
+    }
+    std::string range = spec.substr(colon + 1);
+    size_t equals = range.find('=');
+    if (equals != std::string::npos)
+    {
+        watchpoint.value = std::stoul(range.substr(equals + 1), nullptr, 16);
+        range = range.substr(0, equals);
+    }
+    size_t dash = range.find('-');
+    watchpoint.start = std::stoul(range.substr(0, dash), nullptr, 16);
+    watchpoint.end = (dash != std::string::npos)? std::stoul(range.substr(dash + 1), nullptr, 16) : watchpoint.start;
+    return watchpoint.start <= watchpoint.end;
+}
+static bool ParseSearchFilter(const std::string& spec, std::pair<SearchFilter, uint8_t>& filter)
+{
+    static const std::pair<const char*, SearchFilter> FILTER_NAMES[] = {
+        {"eq", SearchFilter::EQUAL}, {"ne", SearchFilter::NOT_EQUAL}, {"changed", SearchFilter::CHANGED}, {"unchanged", SearchFilter::UNCHANGED},
+        {"inc", SearchFilter::INCREASED}, {"dec", SearchFilter::DECREASED}, {"inc-by", SearchFilter::INCREASED_BY}, {"dec-by", SearchFilter::DECREASED_BY}};
+    size_t equals = spec.find('=');
+    std::string name = spec.substr(0, equals);
+    for (const auto& [filterName, searchFilter] : FILTER_NAMES)
+    {
+        if (name == filterName)
+        {
+            filter = {searchFilter, (equals != std::string::npos)? static_cast<uint8_t>(std::stoul(spec.substr(equals + 1), nullptr, 16)) : 0};
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> positional;
+    bool blockCache = true;
+    bool jit = false;
+    bool jitDifferential = false;
+    bool aot = false;
+    bool idleSkip = true;
+    bool cycleExact = false;
+    bool batch = false;
+    bool lazy = false;
+    bool scanlineRenderer = true;
+    std::string statsPath;
+    std::string traceDumpPath;
+    std::vector<Watchpoint> watchpoints;
+    std::vector<std::string> gameGenieCodes;
+    std::vector<RamFreeze> ramFreezes;
+    std::vector<std::pair<SearchFilter, uint8_t>> searchFilters;
+    std::string heatmapPrefix;
+    std::string cdlPath;
+    #ifdef MEMORY_HEATMAP
+    bool heatmapLastFrame = false;
+    #endif // MEMORY_HEATMAP
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--no-block-cache")
+        {
+            blockCache = false;
+        }
+        else if (arg == "--jit")
+        {
+            jit = true;
+        }
+        else if (arg == "--jit-differential")
+        {
+            jit = true;
+            jitDifferential = true;
+        }
+        else if (arg == "--aot")
+        {
+            aot = true;
+        }
+        else if (arg == "--no-idle-skip")
+        {
+            idleSkip = false;
+        }
+        else if (arg == "--cycle-exact")
+        {
+            cycleExact = true;
+        }
+        else if (arg == "--batch")
+        {
+            batch = true;
+        }
+        else if (arg == "--lazy")
+        {
+            lazy = true;
+        }
+        else if (arg == "--no-scanline-renderer")
+        {
+            scanlineRenderer = false;
+        }
+        else if (arg == "--stats" && i + 1 < argc)
+        {
+            statsPath = argv[++i];
+        }
+        else if (arg == "--trace-dump" && i + 1 < argc)
+        {
+            traceDumpPath = argv[++i];
+        }
+        else if (arg == "--heatmap" && i + 1 < argc)
+        {
+            heatmapPrefix = argv[++i];
+        }
+        else if (arg == "--cdl" && i + 1 < argc)
+        {
+            cdlPath = argv[++i];
+        }
+        #ifdef MEMORY_HEATMAP
+        else if (arg == "--heatmap-last-frame")
+        {
+            heatmapLastFrame = true;
+        }
+        #endif // MEMORY_HEATMAP
+        else if (arg == "--watch" && i + 1 < argc)
+        {
+            Watchpoint watchpoint;
+            if (!ParseWatchpoint(argv[++i], watchpoint))
+            {
+                std::cerr << "Bad watchpoint " << argv[i] << std::endl;
+                return 1;
+            }
+            watchpoints.push_back(watchpoint);
+        }
+        else if (arg == "--game-genie" && i + 1 < argc)
+        {
+            gameGenieCodes.push_back(argv[++i]);
+        }
+        else if (arg == "--freeze" && i + 1 < argc)
+        {
+            std::string spec = argv[++i];
+            size_t equals = spec.find('=');
+            if (equals == std::string::npos)
+            {
+                std::cerr << "Bad ram freeze " << spec << std::endl;
+                return 1;
+            }
+            ramFreezes.push_back({static_cast<uint16_t>(std::stoul(spec.substr(0, equals), nullptr, 16)),
+                static_cast<uint8_t>(std::stoul(spec.substr(equals + 1), nullptr, 16))});
+        }
+        else if (arg == "--ram-search" && i + 1 < argc)
+        {
+            std::pair<SearchFilter, uint8_t> filter;
+            if (!ParseSearchFilter(argv[++i], filter))
+            {
+                std::cerr << "Bad ram search filter " << argv[i] << std::endl;
+                return 1;
+            }
+            searchFilters.push_back(filter);
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+    std::string romPath = (positional.size() > 0)? positional[0] : std::string(RESOURCE_PATH) + "/nestest_rom/DK.nes";
+    uint32_t frameCount = (positional.size() > 1)? std::stoul(positional[1]) : 600;
+
+    std::fstream file(romPath, std::fstream::in | std::fstream::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open " << romPath << std::endl;
+        return 1;
+    }
+    auto bus = std::make_unique<Bus>();
+    bus->insertCartridge(std::move(file));
+    bus->getCpu().setBlockCacheEnabled(blockCache);
+    if (jit && !bus->getCpu().setJitEnabled(true))
+    {
+        std::cerr << "The jit isn't available in this build" << std::endl;
+        return 1;
+    }
+    bus->getCpu().setJitDifferentialMode(jitDifferential);
+    bus->getCpu().setIdleLoopDetectionEnabled(idleSkip);
+    bus->getCpu().setCycleExactEnabled(cycleExact);
+    bus->getPpu().setScanlineRendererEnabled(scanlineRenderer);
+    #ifndef CPU_STATISTICS
+    if (!statsPath.empty())
+    {
+        std::cerr << "Execution statistics aren't available in this build" << std::endl;
+        return 1;
+    }
+    #endif // CPU_STATISTICS
+    #ifdef MEMORY_HEATMAP
+    if (!heatmapPrefix.empty() && aot)
+    {
+        std::cerr << "The heatmap can't count the accesses of recompiled code" << std::endl;
+        return 1;
+    }
+    #else
+    if (!heatmapPrefix.empty())
+    {
+        std::cerr << "The memory heatmap isn't available in this build" << std::endl;
+        return 1;
+    }
+    #endif // MEMORY_HEATMAP
+    #ifdef CPU_TRACE
+    if (!traceDumpPath.empty())
+    {
+        bus->getCpu().setJamHandler([&bus, &traceDumpPath]()
+        {
+            std::cerr << "The cpu jammed, the trace was written to " << traceDumpPath << std::endl;
+            bus->writeTraceDump(traceDumpPath);
+        });
+    }
+    #else
+    if (!traceDumpPath.empty())
+    {
+        std::cerr << "The instruction trace isn't available in this build" << std::endl;
+        return 1;
+    }
+    #endif // CPU_TRACE
+    if (!watchpoints.empty())
+    {
+        if (aot)
+        {
+            std::cerr << "Watchpoints can't see the accesses of recompiled code" << std::endl;
+            return 1;
+        }
+        bus->setWatchpointHandler([&bus](const Watchpoint&, uint16_t address, uint8_t data, WatchAccess access)
+        {
+            static const char* ACCESS_NAMES[] = {"", "read", "write", "", "execute"};
+            uint32_t position = bus->getPpu().getPosition();
+            std::cout << "Watchpoint: " << ACCESS_NAMES[access] << std::hex << " $" << address << " = $" << static_cast<uint32_t>(data) << std::dec <<
+                " at scanline " << (position >> 16) << " dot " << (position & 0xffff) << std::endl;
+        });
+        for (const Watchpoint& watchpoint : watchpoints)
+        {
+            bus->addWatchpoint(watchpoint);
+        }
+    }
+    if (!gameGenieCodes.empty() && aot)
+    {
+        std::cerr << "Recompiled code reads the rom banks without the patches" << std::endl;
+        return 1;
+    }
+    for (const std::string& code : gameGenieCodes)
+    {
+        if (!bus->addGameGenieCode(code))
+        {
+            std::cerr << "Bad Game Genie code " << code << std::endl;
+            return 1;
+        }
+    }
+    for (const RamFreeze& freeze : ramFreezes)
+    {
+        if (!bus->addRamFreeze(freeze))
+        {
+            std::cerr << "Only the internal ram can be frozen" << std::endl;
+            return 1;
+        }
+    }
+    if (!cdlPath.empty())
+    {
+        if (aot)
+        {
+            std::cerr << "The code/data logger can't see the accesses of recompiled code" << std::endl;
+            return 1;
+        }
+        bus->setCodeDataLoggerEnabled(true);
+    }
+    if (aot)
+    {
+        const RecompiledProgram* program = RecompiledProgramRegistry::Find(RecompiledProgramRegistry::PrgChecksum(*bus));
+        if (program == nullptr || !bus->getCpu().setRecompiledProgram(program))
+        {
+            std::cerr << "No recompiled program was linked for " << romPath << std::endl;
+            return 1;
+        }
+    }
+    bus->getCpu().cpuReset();
+
+    RamSearch ramSearch(bus->getRamView().size());
+    auto start = std::chrono::steady_clock::now();
+    uint32_t frames = 0;
+    #ifdef MEMORY_HEATMAP
+    uint32_t heatmapFrame = 0;
+    #endif // MEMORY_HEATMAP
+    try
+    {
+        while (frames < frameCount)
+        {
+            #ifdef MEMORY_HEATMAP
+            if (heatmapLastFrame && frames != heatmapFrame)
+            {
+                bus->getCpuHeatmap().reset();
+                bus->getPpu().getHeatmap().reset();
+                heatmapFrame = frames;
+            }
+            #endif // MEMORY_HEATMAP
+            if (batch || lazy)
+            {
+                // A batch ends right after the vblank starts
+                uint32_t cyclesUntilNmi = bus->getPpu().cyclesUntilNmi();
+                if (lazy)
+                {
+                    bus->clockLazy();
+                }
+                else
+                {
+                    bus->clockBatch();
+                }
+                if (bus->getPpu().cyclesUntilNmi() > cyclesUntilNmi)
+                {
+                    frames++;
+                    if (!searchFilters.empty())
+                    {
+                        ramSearch.capture(bus->getRamView());
+                    }
+                }
+                continue;
+            }
+            bus->clock();
+            // A frame ends right before the vblank starts, the cpu never runs ahead past that point so the state can be compared
+            if (bus->getPpu().cyclesUntilNmi() == 0)
+            {
+                frames++;
+                if (!searchFilters.empty())
+                {
+                    ramSearch.capture(bus->getRamView());
+                }
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        #ifdef CPU_TRACE
+        if (!traceDumpPath.empty())
+        {
+            std::cerr << "The trace was written to " << traceDumpPath << std::endl;
+            bus->writeTraceDump(traceDumpPath);
+        }
+        #endif // CPU_TRACE
+        return 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Ran " << frameCount << " frames in " << elapsed.count() << "s (" << frameCount / elapsed.count() << " fps)" << std::endl;
+
+    std::cout << "State checksum: " << std::hex << Checksum(bus->getPpu().getScreen(), Checksum(bus->getRamView())) << std::dec << std::endl;
+
+    auto blockCacheStatistics = bus->getCpu().getBlockCacheStatistics();
+    std::cout << "Block cache: " << blockCacheStatistics.hits << " hits, " << blockCacheStatistics.misses << " misses, " << blockCacheStatistics.blocks << " blocks" << std::endl;
+
+    auto idleLoopStatistics = bus->getCpu().getIdleLoopStatistics();
+    std::cout << "Idle loops: " << idleLoopStatistics.fastForwards << " fast forwards, " << idleLoopStatistics.skippedInstructions << " instructions and " <<
+        idleLoopStatistics.skippedCycles << " cycles skipped" << std::endl;
+
+    if (aot)
+    {
+        auto recompiledStatistics = bus->getCpu().getRecompiledStatistics();
+        std::cout << "Recompiled: " << recompiledStatistics.instructions << " instructions in " << recompiledStatistics.runs << " runs, " <<
+            recompiledStatistics.misses << " interpreter fallbacks" << std::endl;
+    }
+
+    if (!searchFilters.empty())
+    {
+        auto searchStart = std::chrono::steady_clock::now();
+        for (const auto& [filter, operand] : searchFilters)
+        {
+            ramSearch.filterHistory(filter, operand);
+        }
+        std::chrono::duration<double, std::milli> searchElapsed = std::chrono::steady_clock::now() - searchStart;
+        std::cout << "Ram search: " << ramSearch.getCandidateCount() << " candidates in " << ramSearch.getSnapshotCount() << " snapshots, filtered in " <<
+            searchElapsed.count() << "ms" << std::endl;
+        static constexpr uint32_t MAX_PRINTED_CANDIDATES = 32;
+        std::vector<uint32_t> candidates = ramSearch.getCandidates();
+        for (uint32_t i = 0; i < candidates.size() && i < MAX_PRINTED_CANDIDATES; i++)
+        {
+            std::cout << std::hex << "  $" << candidates[i] << " = $" << static_cast<uint32_t>(ramSearch.getValue(ramSearch.getSnapshotCount() - 1, candidates[i])) <<
+                std::dec << std::endl;
+        }
+    }
+
+    if (!cdlPath.empty())
+    {
+        std::ofstream cdl(cdlPath, std::ios::binary);
+        bus->getCodeDataLogger().writeCdl(cdl);
+        const std::vector<uint8_t>& prgFlags = bus->getCodeDataLogger().getPrgFlags();
+        size_t code = std::count_if(prgFlags.begin(), prgFlags.end(), [](uint8_t flags) { return flags & CDL_CODE; });
+        size_t data = std::count_if(prgFlags.begin(), prgFlags.end(), [](uint8_t flags) { return flags & CDL_DATA; });
+        std::cout << "Code/data log written to " << cdlPath << ": " << code << " code and " << data << " data bytes of " << prgFlags.size() << std::endl;
+    }
+
+    #ifdef CPU_STATISTICS
+    if (!statsPath.empty())
+    {
+        std::ofstream stats(statsPath);
+        stats << "Rom: " << romPath << std::endl;
+        bus->getCpu().writeExecutionReport(stats);
+        std::cout << "Execution statistics written to " << statsPath << std::endl;
+    }
+    #endif // CPU_STATISTICS
+
+    #ifdef MEMORY_HEATMAP
+    if (!heatmapPrefix.empty())
+    {
+        std::ofstream cpuCsv(heatmapPrefix + "_cpu.csv");
+        bus->getCpuHeatmap().writeCsv(cpuCsv);
+        std::ofstream cpuBinary(heatmapPrefix + "_cpu.bin", std::ios::binary);
+        bus->getCpuHeatmap().writeBinary(cpuBinary);
+        std::ofstream ppuCsv(heatmapPrefix + "_ppu.csv");
+        bus->getPpu().getHeatmap().writeCsv(ppuCsv);
+        std::ofstream ppuBinary(heatmapPrefix + "_ppu.bin", std::ios::binary);
+        bus->getPpu().getHeatmap().writeBinary(ppuBinary);
+        std::cout << "Memory heatmaps written to " << heatmapPrefix << "_cpu and " << heatmapPrefix << "_ppu" << std::endl;
+    }
+    #endif // MEMORY_HEATMAP
+
+    #ifdef CPU_TRACE
+    if (!traceDumpPath.empty() && !bus->getCpu().isJammed())
+    {
+        bus->writeTraceDump(traceDumpPath);
+        std::cout << "Instruction trace written to " << traceDumpPath << std::endl;
+    }
+    #endif // CPU_TRACE
+
+    if (jit)
+    {
+        auto jitStatistics = bus->getCpu().getJitStatistics();
+        std::cout << "Jit: " << jitStatistics.translatedBlocks << " blocks (" << jitStatistics.codeSize << " bytes), " <<
+            jitStatistics.instructions << " instructions, " << jitStatistics.mmioExits << " mmio exits" << std::endl;
+        if (jitDifferential)
+        {
+            std::cout << "Jit differential: " << jitStatistics.differentialChecks << " checks, " << jitStatistics.differentialMismatches << " mismatches" << std::endl;
+            if (jitStatistics.differentialMismatches > 0)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
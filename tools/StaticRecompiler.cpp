@@ -0,0 +1,647 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "NumToHexStringConvertor.hpp"
+
+#include "HardwareEmulation/Bus.hpp"
+#include "HardwareEmulation/Aot/RecompiledProgram.hpp"
+
+// Recompiles the code of an NROM (mapper 0) rom ahead of time into C++ functions that run on the core's bus
+// usage: StaticRecompiler <rom path> <output path> [program name]
+// The code is found by a recursive descent from the reset, nmi and irq vectors and every basic block becomes a function
+// The output is linked into a binary next to the core and loaded with Cpu::setRecompiledProgram
+// Code the walk couldn't reach (jump tables, indirect jumps through ram) still runs in the interpreter
+
+static constexpr uint32_t INES_HEADER_SIZE = 16;
+static constexpr uint16_t PRG_ROM_START = 0x8000;
+static constexpr uint16_t RAM_MEMORY_RANGE = 0x2000;
+static constexpr uint16_t TRUE_RAM_MASK = 0x7ff;
+
+static std::string Hex(uint32_t value, uint8_t digits)
+{
+    return "0x" + NumToHexStringConvertor::Convert(value, digits);
+}
+
+class StaticRecompiler
+{
+public:
+    StaticRecompiler(Bus& bus);
+
+    // Walks the code from the interrupt vectors, returns the amount of instructions that were found
+    size_t discover();
+
+    void generate(const std::string& name, std::ostream& out);
+
+private:
+    using IType = Cpu<Bus>::IType;
+    using AMode = Cpu<Bus>::AMode;
+
+    struct DecodedInstruction
+    {
+        uint16_t pc;
+        uint16_t operand;
+        uint8_t opcode;
+        uint8_t length;
+    };
+
+    // How the effective address of an instruction is accessed by the generated code
+    enum class Access
+    {
+        NONE,
+        RAM, // the address is known to be in the ram
+        ROM, // a read from an address known to be in the rom
+        BUS // anything else, the instruction may need the bus
+    };
+
+    struct Operand
+    {
+        Access access;
+        std::string setup; // statements that compute the address
+        std::string address; // an expression of the address
+        std::string pageCross; // an expression that is true when indexing crossed a page
+    };
+
+    const Cpu<Bus>::Instruction& instructionOf(const DecodedInstruction& decoded) const;
+    bool decode(uint16_t pc, DecodedInstruction& decoded);
+    uint16_t readVector(uint16_t address);
+    // Returns false when the instruction is left to the interpreter
+    bool isRecompilable(const DecodedInstruction& decoded);
+    // The target of an indirect jump through a pointer in rom, -1 when the pointer isn't in rom
+    int32_t resolveIndirectJump(uint16_t pointer);
+    Operand resolveOperand(const DecodedInstruction& decoded);
+    std::string disassemble(const DecodedInstruction& decoded);
+
+    // Each emits the statements of a single instruction, memory accesses come before any change to the context
+    // so a failed bus access can return before anything happened
+    void emitInstruction(const DecodedInstruction& decoded, std::ostream& out);
+    void emitBlock(uint16_t leader, std::ostream& out);
+
+    Bus& _bus;
+    std::map<uint16_t, DecodedInstruction> _instructions;
+    // Block starts: entry points, jump and branch targets, return addresses and instructions that may need the bus
+    std::set<uint16_t> _leaders;
+    std::vector<uint16_t> _blocks;
+};
+
+StaticRecompiler::StaticRecompiler(Bus& bus) :
+    _bus(bus)
+{
+}
+
+const Cpu<Bus>::Instruction& StaticRecompiler::instructionOf(const DecodedInstruction& decoded) const
+{
+    return Cpu<Bus>::_opcodeVector[decoded.opcode];
+}
+
+bool StaticRecompiler::decode(uint16_t pc, DecodedInstruction& decoded)
+{
+    decoded.pc = pc;
+    decoded.opcode = _bus.cpuRead(pc);
+    decoded.length = Cpu<Bus>::getInstructionLength(decoded.opcode);
+    if (pc + decoded.length - 1 > 0xffff)
+    {
+        return false;
+    }
+    decoded.operand = 0;
+    for (uint8_t i = 1; i < decoded.length; i++)
+    {
+        decoded.operand |= _bus.cpuRead(pc + i) << (8 * (i - 1));
+    }
+    return true;
+}
+
+uint16_t StaticRecompiler::readVector(uint16_t address)
+{
+    return _bus.cpuRead(address) | (_bus.cpuRead(address + 1) << 8);
+}
+
+int32_t StaticRecompiler::resolveIndirectJump(uint16_t pointer)
+{
+    if (pointer < PRG_ROM_START)
+    {
+        return -1;
+    }
+    // The high byte is read from the same page like the 6502 does
+    return _bus.cpuRead(pointer) | (_bus.cpuRead((pointer & 0xff00) | ((pointer + 1) & 0xff)) << 8);
+}
+
+bool StaticRecompiler::isRecompilable(const DecodedInstruction& decoded)
+{
+    const auto& instruction = instructionOf(decoded);
+    switch (instruction.type)
+    {
+    case IType::BRK:
+    case IType::MIA:
+        return false;
+    case IType::JMP:
+        return instruction.addrMode != AMode::INDIRECT || decoded.operand < RAM_MEMORY_RANGE ||
+            resolveIndirectJump(decoded.operand) >= 0;
+    default:
+        return true;
+    }
+}
+
+size_t StaticRecompiler::discover()
+{
+    std::vector<uint16_t> pending = {readVector(0xfffc), readVector(0xfffa), readVector(0xfffe)};
+    for (uint16_t entry : pending)
+    {
+        _leaders.insert(entry);
+    }
+    auto branchTo = [&](uint16_t target)
+    {
+        _leaders.insert(target);
+        pending.push_back(target);
+    };
+    while (!pending.empty())
+    {
+        uint16_t pc = pending.back();
+        pending.pop_back();
+        bool endOfCode = false;
+        while (!endOfCode && pc >= PRG_ROM_START && _instructions.count(pc) == 0)
+        {
+            DecodedInstruction decoded;
+            if (!decode(pc, decoded))
+            {
+                break;
+            }
+            _instructions[pc] = decoded;
+            const auto& instruction = instructionOf(decoded);
+            uint16_t next = pc + decoded.length;
+            if (!isRecompilable(decoded))
+            {
+                // The interpreter takes over from here so the walk can't know where the code continues
+                break;
+            }
+            if (resolveOperand(decoded).access == Access::BUS)
+            {
+                _leaders.insert(pc);
+            }
+            if (Cpu<Bus>::isBranch(instruction.type))
+            {
+                branchTo(next + static_cast<int8_t>(decoded.operand));
+                _leaders.insert(next);
+            }
+            switch (instruction.type)
+            {
+            case IType::JMP:
+                if (instruction.addrMode == AMode::ABSOLUTE)
+                {
+                    branchTo(decoded.operand);
+                }
+                else if (decoded.operand >= PRG_ROM_START)
+                {
+                    branchTo(resolveIndirectJump(decoded.operand));
+                }
+                endOfCode = true;
+                break;
+            case IType::JSR:
+                branchTo(decoded.operand);
+                _leaders.insert(next);
+                break;
+            case IType::RTS:
+            case IType::RTI:
+                endOfCode = true;
+                break;
+            default:
+                break;
+            }
+            pc = next;
+        }
+    }
+    return _instructions.size();
+}
+
+StaticRecompiler::Operand StaticRecompiler::resolveOperand(const DecodedInstruction& decoded)
+{
+    const auto& instruction = instructionOf(decoded);
+    bool read = Cpu<Bus>::isReadInstruction(instruction.type);
+    std::string base = Hex(decoded.operand, 4);
+    switch (instruction.addrMode)
+    {
+    case AMode::ZP:
+        return {Access::RAM, "", Hex(decoded.operand, 2), ""};
+    case AMode::I_ZP_X:
+        return {Access::RAM, "", "static_cast<uint8_t>(" + Hex(decoded.operand, 2) + " + context.x)", ""};
+    case AMode::I_ZP_Y:
+        return {Access::RAM, "", "static_cast<uint8_t>(" + Hex(decoded.operand, 2) + " + context.y)", ""};
+    case AMode::ABSOLUTE:
+        if (instruction.type == IType::JMP || instruction.type == IType::JSR)
+        {
+            return {Access::NONE, "", "", ""};
+        }
+        if (decoded.operand < RAM_MEMORY_RANGE)
+        {
+            return {Access::RAM, "", Hex(decoded.operand & TRUE_RAM_MASK, 4), ""};
+        }
+        if (decoded.operand >= PRG_ROM_START && read)
+        {
+            return {Access::ROM, "", base, ""};
+        }
+        return {Access::BUS, "uint16_t address = " + base + ";\n", "address", ""};
+    case AMode::I_ABSOLUTE_X:
+    case AMode::I_ABSOLUTE_Y:
+    {
+        std::string index = (instruction.addrMode == AMode::I_ABSOLUTE_X)? "context.x" : "context.y";
+        std::string setup = "uint16_t address = " + base + " + " + index + ";\n";
+        std::string pageCross = "((address ^ " + base + ") & 0xff00) != 0";
+        uint32_t last = decoded.operand + 0xff;
+        if (last < RAM_MEMORY_RANGE)
+        {
+            return {Access::RAM, setup, "address & " + Hex(TRUE_RAM_MASK, 4), pageCross};
+        }
+        if (decoded.operand >= PRG_ROM_START && last <= 0xffff && read)
+        {
+            return {Access::ROM, setup, "address", pageCross};
+        }
+        return {Access::BUS, setup, "address", pageCross};
+    }
+    case AMode::I_INDIRECT:
+        return {Access::BUS, "uint8_t pointer = " + Hex(decoded.operand, 2) + " + context.x;\n"
+            "uint16_t address = context.ram[pointer] | (context.ram[static_cast<uint8_t>(pointer + 1)] << 8);\n", "address", ""};
+    case AMode::INDIRECT_I:
+        return {Access::BUS, "uint16_t pointer = context.ram[" + Hex(decoded.operand, 2) + "] | (context.ram[" +
+            Hex((decoded.operand + 1) & 0xff, 2) + "] << 8);\n"
+            "uint16_t address = pointer + context.y;\n", "address", "((address ^ pointer) & 0xff00) != 0"};
+    default:
+        return {Access::NONE, "", "", ""};
+    }
+}
+
+std::string StaticRecompiler::disassemble(const DecodedInstruction& decoded)
+{
+    const auto& instruction = instructionOf(decoded);
+    auto& cpu = _bus.getCpu();
+    std::string line = "$" + NumToHexStringConvertor::Convert(decoded.pc, 4) + " " +
+        cpu._iTypeNameMapper[static_cast<int>(instruction.type)] + " " + cpu._aModeNameMapper[static_cast<int>(instruction.addrMode)];
+    if (decoded.length > 1)
+    {
+        line += " $" + NumToHexStringConvertor::Convert(decoded.operand, (decoded.length - 1) * 2);
+    }
+    return line;
+}
+
+void StaticRecompiler::emitInstruction(const DecodedInstruction& decoded, std::ostream& out)
+{
+    const auto& instruction = instructionOf(decoded);
+    Operand operand = resolveOperand(decoded);
+    uint16_t next = decoded.pc + decoded.length;
+    std::ostringstream code;
+
+    // Leaves the value of the operand in data
+    auto readData = [&]()
+    {
+        code << operand.setup;
+        switch (operand.access)
+        {
+        case Access::RAM:
+            code << "uint8_t data = context.ram[" << operand.address << "];\n";
+            break;
+        case Access::ROM:
+            if (operand.setup.empty())
+            {
+                // Rom reads from a constant address are folded, the program only runs on the rom it was made from
+                code << "uint8_t data = " << Hex(_bus.cpuRead(decoded.operand), 2) << ";\n";
+            }
+            else
+            {
+                code << "uint8_t data = RecompiledCode::ReadRom(context, " << operand.address << ");\n";
+            }
+            break;
+        case Access::BUS:
+            code << "uint8_t data;\n";
+            code << "if (!RecompiledCode::Read(context, " << operand.address << ", data))\n{\n    return false;\n}\n";
+            break;
+        default:
+            code << "uint8_t data = " << ((instruction.addrMode == AMode::IMM)? Hex(decoded.operand & 0xff, 2) : "context.a") << ";\n";
+            break;
+        }
+        if (!operand.pageCross.empty() && Cpu<Bus>::isReadInstruction(instruction.type))
+        {
+            code << "context.cycles += (" << operand.pageCross << ")? 1 : 0;\n";
+        }
+    };
+    auto writeData = [&](const std::string& value)
+    {
+        if (operand.access == Access::RAM)
+        {
+            code << "context.ram[" << operand.address << "] = " << value << ";\n";
+        }
+        else if (operand.access == Access::BUS)
+        {
+            code << "if (!RecompiledCode::Write(context, " << operand.address << ", " << value << "))\n{\n    return false;\n}\n";
+        }
+        else
+        {
+            code << "context.a = " << value << ";\n";
+        }
+    };
+    auto storeRegister = [&](const std::string& reg)
+    {
+        code << operand.setup;
+        writeData(reg);
+    };
+    auto setZeroNegative = [&](const std::string& value)
+    {
+        code << "context.zero = " << value << ";\ncontext.negative = " << value << ";\n";
+    };
+    auto load = [&](const std::string& reg)
+    {
+        readData();
+        code << reg << " = data;\n";
+        setZeroNegative(reg);
+    };
+    auto compare = [&](const std::string& reg)
+    {
+        readData();
+        code << "context.carry = " << reg << " >= data;\n";
+        setZeroNegative("static_cast<uint8_t>(" + reg + " - data)");
+    };
+    auto logic = [&](const std::string& op)
+    {
+        readData();
+        code << "context.a " << op << "= data;\n";
+        setZeroNegative("context.a");
+    };
+    auto add = [&](bool subtract)
+    {
+        readData();
+        code << "uint8_t value = data" << ((subtract)? " ^ 0xff" : "") << ";\n";
+        code << "uint16_t sum = context.a + value + context.carry;\n";
+        code << "context.carry = sum >> 8;\n";
+        code << "context.overflow = (context.a ^ sum) & (value ^ sum);\n";
+        code << "context.a = sum & 0xff;\n";
+        setZeroNegative("context.a");
+    };
+    // Read modify write, the result is written back before the flags change
+    auto modify = [&](const std::string& result, const std::string& carry)
+    {
+        readData();
+        code << "uint8_t result = " << result << ";\n";
+        if (!carry.empty())
+        {
+            code << "uint8_t carry = " << carry << ";\n";
+        }
+        writeData("result");
+        if (!carry.empty())
+        {
+            code << "context.carry = carry;\n";
+        }
+        setZeroNegative("result");
+    };
+    auto branch = [&](const std::string& condition)
+    {
+        uint16_t target = next + static_cast<int8_t>(decoded.operand);
+        uint32_t penalty = ((target & 0xff00) != (next & 0xff00))? 2 : 1;
+        code << "if (" << condition << ")\n{\n    context.cycles += " << penalty << ";\n    context.pc = " << Hex(target, 4) <<
+            ";\n}\nelse\n{\n    context.pc = " << Hex(next, 4) << ";\n}\n";
+    };
+    auto setStatusBit = [&](const std::string& mask, bool value)
+    {
+        if (value)
+        {
+            code << "context.status |= RecompiledCode::" << mask << ";\n";
+        }
+        else
+        {
+            code << "context.status &= ~RecompiledCode::" << mask << ";\n";
+        }
+    };
+
+    switch (instruction.type)
+    {
+    case IType::ADC: add(false); break;
+    case IType::SBC: add(true); break;
+    case IType::AND: logic("&"); break;
+    case IType::ORA: logic("|"); break;
+    case IType::EOR: logic("^"); break;
+    case IType::ASL: modify("data << 1", "data >> 7"); break;
+    case IType::LSR: modify("data >> 1", "data & 0x01"); break;
+    case IType::ROL: modify("(data << 1) | context.carry", "data >> 7"); break;
+    case IType::ROR: modify("(data >> 1) | (context.carry << 7)", "data & 0x01"); break;
+    case IType::INC: modify("data + 1", ""); break;
+    case IType::DEC: modify("data - 1", ""); break;
+    case IType::BIT:
+        readData();
+        code << "context.overflow = data << 1;\n";
+        code << "context.zero = context.a & data;\n";
+        code << "context.negative = data;\n";
+        break;
+    case IType::CMP: compare("context.a"); break;
+    case IType::CPX: compare("context.x"); break;
+    case IType::CPY: compare("context.y"); break;
+    case IType::LDA: load("context.a"); break;
+    case IType::LDX: load("context.x"); break;
+    case IType::LDY: load("context.y"); break;
+    case IType::STA: storeRegister("context.a"); break;
+    case IType::STX: storeRegister("context.x"); break;
+    case IType::STY: storeRegister("context.y"); break;
+    case IType::BCC: branch("!context.carry"); break;
+    case IType::BCS: branch("context.carry"); break;
+    case IType::BEQ: branch("context.zero == 0"); break;
+    case IType::BNE: branch("context.zero != 0"); break;
+    case IType::BMI: branch("context.negative & 0x80"); break;
+    case IType::BPL: branch("!(context.negative & 0x80)"); break;
+    case IType::BVS: branch("context.overflow & 0x80"); break;
+    case IType::BVC: branch("!(context.overflow & 0x80)"); break;
+    case IType::JMP:
+        if (instruction.addrMode == AMode::ABSOLUTE)
+        {
+            code << "context.pc = " << Hex(decoded.operand, 4) << ";\n";
+        }
+        else if (decoded.operand >= PRG_ROM_START)
+        {
+            code << "context.pc = " << Hex(resolveIndirectJump(decoded.operand), 4) << ";\n";
+        }
+        else
+        {
+            // A pointer in ram, the target is only known at runtime
+            uint16_t high = (decoded.operand & 0xff00) | ((decoded.operand + 1) & 0xff);
+            code << "context.pc = context.ram[" << Hex(decoded.operand & TRUE_RAM_MASK, 4) << "] | (context.ram[" <<
+                Hex(high & TRUE_RAM_MASK, 4) << "] << 8);\n";
+        }
+        break;
+    case IType::JSR:
+        code << "RecompiledCode::Push(context, " << Hex((next - 1) >> 8, 2) << ");\n";
+        code << "RecompiledCode::Push(context, " << Hex((next - 1) & 0xff, 2) << ");\n";
+        code << "context.pc = " << Hex(decoded.operand, 4) << ";\n";
+        break;
+    case IType::RTS:
+        code << "uint16_t address = RecompiledCode::Pull(context);\n";
+        code << "address |= RecompiledCode::Pull(context) << 8;\n";
+        code << "context.pc = address + 1;\n";
+        break;
+    case IType::RTI:
+        code << "RecompiledCode::SetStatus(context, RecompiledCode::Pull(context));\n";
+        code << "uint16_t address = RecompiledCode::Pull(context);\n";
+        code << "address |= RecompiledCode::Pull(context) << 8;\n";
+        code << "context.pc = address;\n";
+        break;
+    case IType::PHA:
+        code << "RecompiledCode::Push(context, context.a);\n";
+        break;
+    case IType::PHP:
+        code << "RecompiledCode::Push(context, RecompiledCode::GetStatus(context) | RecompiledCode::BREAK_COMMAND_FLAG_MASK | "
+            "RecompiledCode::RESERVED_FLAG_MASK);\n";
+        break;
+    case IType::PLA:
+        code << "context.a = RecompiledCode::Pull(context);\n";
+        setZeroNegative("context.a");
+        break;
+    case IType::PLP:
+        code << "RecompiledCode::SetStatus(context, RecompiledCode::Pull(context));\n";
+        break;
+    case IType::CLC: code << "context.carry = 0;\n"; break;
+    case IType::SEC: code << "context.carry = 1;\n"; break;
+    case IType::CLV: code << "context.overflow = 0;\n"; break;
+    case IType::CLI: setStatusBit("INTERRUPT_DISABLE_FLAG_MASK", false); break;
+    case IType::SEI: setStatusBit("INTERRUPT_DISABLE_FLAG_MASK", true); break;
+    case IType::CLD: setStatusBit("DECIMAL_MODE_FLAG_MASK", false); break;
+    case IType::SED: setStatusBit("DECIMAL_MODE_FLAG_MASK", true); break;
+    case IType::INX: code << "context.x++;\n"; setZeroNegative("context.x"); break;
+    case IType::INY: code << "context.y++;\n"; setZeroNegative("context.y"); break;
+    case IType::DEX: code << "context.x--;\n"; setZeroNegative("context.x"); break;
+    case IType::DEY: code << "context.y--;\n"; setZeroNegative("context.y"); break;
+    case IType::TAX: code << "context.x = context.a;\n"; setZeroNegative("context.x"); break;
+    case IType::TAY: code << "context.y = context.a;\n"; setZeroNegative("context.y"); break;
+    case IType::TSX: code << "context.x = context.sp;\n"; setZeroNegative("context.x"); break;
+    case IType::TXA: code << "context.a = context.x;\n"; setZeroNegative("context.a"); break;
+    case IType::TYA: code << "context.a = context.y;\n"; setZeroNegative("context.a"); break;
+    case IType::TXS: code << "context.sp = context.x;\n"; break;
+    default:
+        // NOP
+        break;
+    }
+
+    out << "    // " << disassemble(decoded) << "\n";
+    std::string line;
+    std::istringstream lines(code.str());
+    bool scoped = !code.str().empty();
+    if (scoped)
+    {
+        out << "    {\n";
+    }
+    while (std::getline(lines, line))
+    {
+        out << "        " << line << "\n";
+    }
+    if (scoped)
+    {
+        out << "    }\n";
+    }
+}
+
+void StaticRecompiler::emitBlock(uint16_t leader, std::ostream& out)
+{
+    std::vector<const DecodedInstruction*> instructions;
+    uint16_t pc = leader;
+    bool endOfBlock = false;
+    while (!endOfBlock)
+    {
+        auto iter = _instructions.find(pc);
+        if (iter == _instructions.end() || !isRecompilable(iter->second) || (pc != leader && _leaders.count(pc) > 0))
+        {
+            break;
+        }
+        const auto& instruction = instructionOf(iter->second);
+        instructions.push_back(&iter->second);
+        endOfBlock = Cpu<Bus>::isBranch(instruction.type) || instruction.type == IType::JMP || instruction.type == IType::JSR ||
+            instruction.type == IType::RTS || instruction.type == IType::RTI;
+        pc += iter->second.length;
+    }
+    if (instructions.empty())
+    {
+        return;
+    }
+    uint32_t cycles = 0;
+    for (auto decoded : instructions)
+    {
+        cycles += instructionOf(*decoded).cycles;
+    }
+    _blocks.push_back(leader);
+    out << "bool Block" << NumToHexStringConvertor::Convert(leader, 4) << "(RecompiledContext& context)\n{\n";
+    out << "    if (context.instructions + " << instructions.size() << " > context.maxInstructions)\n    {\n        return false;\n    }\n";
+    for (auto decoded : instructions)
+    {
+        emitInstruction(*decoded, out);
+    }
+    if (!endOfBlock)
+    {
+        out << "    context.pc = " << Hex(pc, 4) << ";\n";
+    }
+    out << "    context.cycles += " << cycles << ";\n";
+    out << "    context.instructions += " << instructions.size() << ";\n";
+    out << "    return true;\n}\n\n";
+}
+
+void StaticRecompiler::generate(const std::string& name, std::ostream& out)
+{
+    out << "// Generated by StaticRecompiler from " << name << ", do not edit\n";
+    out << "// Every block runs whole or not at all, a run only stops at the start of a block\n\n";
+    out << "#include \"HardwareEmulation/Aot/RecompiledCode.hpp\"\n\n";
+    out << "namespace\n{\n\n";
+    for (uint16_t leader : _leaders)
+    {
+        emitBlock(leader, out);
+    }
+    out << "const RecompiledBlock BLOCKS[] =\n{\n";
+    for (uint16_t leader : _blocks)
+    {
+        out << "    {" << Hex(leader, 4) << ", Block" << NumToHexStringConvertor::Convert(leader, 4) << "},\n";
+    }
+    out << "};\n\n";
+    out << "const RecompiledProgram PROGRAM = {\"" << name << "\", 0x" << std::hex << RecompiledProgramRegistry::PrgChecksum(_bus) <<
+        std::dec << ", BLOCKS};\n\n";
+    out << "const bool REGISTERED = RecompiledProgramRegistry::Register(&PROGRAM);\n\n";
+    out << "}\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: StaticRecompiler <rom path> <output path> [program name]" << std::endl;
+        return 1;
+    }
+    std::string romPath = argv[1];
+    std::string outputPath = argv[2];
+    std::string name = (argc > 3)? argv[3] : std::filesystem::path(romPath).stem().string();
+
+    std::fstream file(romPath, std::fstream::in | std::fstream::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open " << romPath << std::endl;
+        return 1;
+    }
+    std::array<uint8_t, INES_HEADER_SIZE> header = {};
+    file.read(reinterpret_cast<char*>(header.data()), header.size());
+    uint8_t mapperId = (header[7] & 0xf0) | ((header[6] & 0xf0) >> 4);
+    if (mapperId != 0)
+    {
+        std::cerr << "Only NROM (mapper 0) roms can be recompiled, " << romPath << " uses mapper " << static_cast<int>(mapperId) << std::endl;
+        return 1;
+    }
+    file.seekg(0);
+
+    auto bus = std::make_unique<Bus>();
+    bus->insertCartridge(std::move(file));
+    StaticRecompiler recompiler(*bus);
+    size_t instructions = recompiler.discover();
+
+    std::ofstream output(outputPath);
+    if (!output.is_open())
+    {
+        std::cerr << "Failed to open " << outputPath << std::endl;
+        return 1;
+    }
+    recompiler.generate(name, output);
+    std::cout << "Recompiled " << instructions << " instructions of " << name << " into " << outputPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "NumToHexStringConvertor.hpp"
+
+#include "HardwareEmulation/Cpu.hpp"
+#include "HardwareEmulation/CpuTrace.hpp"
+
+// Turns a trace dump into text, the cpu writes the dump when it jams or the emulation throws
+// usage: TraceFormatter [options] <dump path>
+// options:
+//   --dk                print in the DK.log style instead of the nestest.log style
+//   --screen <path>     write the screen of the dump as a ppm image
+
+class TraceFormatter
+{
+public:
+    TraceFormatter();
+
+    // C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7
+    std::string formatNestest(const TraceEntry& entry) const;
+    // C79E XXX A:00 X:00 Y:00 ..U..I.. STKP:FD
+    std::string formatDk(const TraceEntry& entry) const;
+
+    static bool WriteScreen(const std::string& path, const std::vector<uint32_t>& screen);
+
+private:
+    using CpuType = Cpu<FunctionalCpuBus>;
+    using IType = CpuType::IType;
+    using AMode = CpuType::AMode;
+
+    static constexpr uint32_t SCREEN_WIDTH = 256;
+
+    std::string formatOperand(const TraceEntry& entry) const;
+
+    FunctionalCpuBus _bus;
+    // Only used for its name tables
+    CpuType _cpu;
+};
+
+TraceFormatter::TraceFormatter() :
+    _bus([](uint16_t, uint8_t) {}, [](uint16_t) -> uint8_t { return 0; }),
+    _cpu(_bus)
+{
+}
+
+std::string TraceFormatter::formatOperand(const TraceEntry& entry) const
+{
+    const auto& instruction = CpuType::_opcodeVector[entry.opcode];
+    std::string byte = NumToHexStringConvertor::Convert(entry.operand & 0xff, 2);
+    std::string word = NumToHexStringConvertor::Convert(entry.operand, 4);
+    switch (instruction.addrMode)
+    {
+    case AMode::ACCUM:
+        return " A";
+    case AMode::IMM:
+        return " #$" + byte;
+    case AMode::ABSOLUTE:
+        return " $" + word;
+    case AMode::ZP:
+        return " $" + byte;
+    case AMode::I_ZP_X:
+        return " $" + byte + ",X";
+    case AMode::I_ZP_Y:
+        return " $" + byte + ",Y";
+    case AMode::I_ABSOLUTE_X:
+        return " $" + word + ",X";
+    case AMode::I_ABSOLUTE_Y:
+        return " $" + word + ",Y";
+    case AMode::RELATIVE:
+        return " $" + NumToHexStringConvertor::Convert(static_cast<uint16_t>(entry.pc + 2 + static_cast<int8_t>(entry.operand)), 4);
+    case AMode::I_INDIRECT:
+        return " ($" + byte + ",X)";
+    case AMode::INDIRECT_I:
+        return " ($" + byte + "),Y";
+    case AMode::INDIRECT:
+        return " ($" + word + ")";
+    default:
+        return "";
+    }
+}
+
+std::string TraceFormatter::formatNestest(const TraceEntry& entry) const
+{
+    const auto& instruction = CpuType::_opcodeVector[entry.opcode];
+    uint8_t length = CpuType::getInstructionLength(entry.opcode) - 1;
+    std::string bytes = NumToHexStringConvertor::Convert(entry.opcode, 2);
+    for (uint8_t i = 0; i < length; i++)
+    {
+        bytes += " " + NumToHexStringConvertor::Convert((entry.operand >> (8 * i)) & 0xff, 2);
+    }
+    bytes.resize(8, ' ');
+    // Illegal opcodes are marked with a * like nestest.log does
+    std::string text = (instruction.type == IType::MIA)? "*" : " ";
+    text += _cpu._iTypeNameMapper[static_cast<int>(instruction.type)] + formatOperand(entry);
+    text.resize(33, ' ');
+    char registers[80];
+    std::snprintf(registers, sizeof(registers), "A:%02X X:%02X Y:%02X P:%02X SP:%02X PPU:%3u,%3u CYC:%llu", entry.a, entry.x, entry.y,
+        entry.status | CpuType::RESERVED_FLAG_MASK, entry.sp, entry.scanline, entry.dot, static_cast<unsigned long long>(entry.cycle));
+    return NumToHexStringConvertor::Convert(entry.pc, 4) + "  " + bytes + text + registers;
+}
+
+std::string TraceFormatter::formatDk(const TraceEntry& entry) const
+{
+    uint8_t status = entry.status | CpuType::RESERVED_FLAG_MASK;
+    std::string flags = "NVUBDIZC";
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+        if (!(status & (0x80 >> bit)))
+        {
+            flags[bit] = '.';
+        }
+    }
+    return NumToHexStringConvertor::Convert(entry.pc, 4) + " XXX A:" + NumToHexStringConvertor::Convert(entry.a, 2) +
+        " X:" + NumToHexStringConvertor::Convert(entry.x, 2) + " Y:" + NumToHexStringConvertor::Convert(entry.y, 2) +
+        " " + flags + " STKP:" + NumToHexStringConvertor::Convert(entry.sp, 2);
+}
+
+bool TraceFormatter::WriteScreen(const std::string& path, const std::vector<uint32_t>& screen)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    file << "P6\n" << SCREEN_WIDTH << " " << screen.size() / SCREEN_WIDTH << "\n255\n";
+    for (uint32_t pixel : screen)
+    {
+        char rgb[3] = {static_cast<char>(pixel >> 16), static_cast<char>(pixel >> 8), static_cast<char>(pixel)};
+        file.write(rgb, sizeof(rgb));
+    }
+    return file.good();
+}
+
+int main(int argc, char* argv[])
+{
+    std::string dumpPath;
+    std::string screenPath;
+    bool dk = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--dk")
+        {
+            dk = true;
+        }
+        else if (arg == "--screen" && i + 1 < argc)
+        {
+            screenPath = argv[++i];
+        }
+        else
+        {
+            dumpPath = arg;
+        }
+    }
+    if (dumpPath.empty())
+    {
+        std::cerr << "usage: TraceFormatter [--dk] [--screen <ppm path>] <dump path>" << std::endl;
+        return 1;
+    }
+    std::vector<TraceEntry> entries;
+    std::vector<uint32_t> screen;
+    if (!CpuTrace::ReadDump(dumpPath, entries, screen))
+    {
+        std::cerr << "Failed to read the trace dump " << dumpPath << std::endl;
+        return 1;
+    }
+    TraceFormatter formatter;
+    for (const TraceEntry& entry : entries)
+    {
+        std::cout << ((dk)? formatter.formatDk(entry) : formatter.formatNestest(entry)) << "\n";
+    }
+    if (!screenPath.empty() && !TraceFormatter::WriteScreen(screenPath, screen))
+    {
+        std::cerr << "Failed to write the screen to " << screenPath << std::endl;
+        return 1;
+    }
+    return 0;
+}